@@ -9,6 +9,9 @@ option(SCSC_BUILD_DOC "Build documentation." "ON")
 
 option(SCSC_USE_MKL "Enable MKL support." "ON")
 option(SCSC_USE_GPU "Enable GPU support." "ON")
+option(SCSC_USE_MPI "Enable MPI support. (Build 'main_mpi')" "OFF")
+option(SCSC_USE_PROFILER "Enable the profiling zones. (Recorded if 'SCSC_PROFILE' is set)" "ON")
+option(SCSC_TRACK_NEW "Count the live bytes of the global operator new. (Reported if 'SCSC_MEMORY' is set)" "OFF")
 
 set(SCSC_USE_OMP "OFF" CACHE STRING "Selected OpenMP library. [OFF/GOMP/IOMP] (Require 'SCSC_USE_MKL')")
 set_property(CACHE SCSC_USE_OMP PROPERTY STRINGS "OFF;GOMP;IOMP")
@@ -23,6 +23,7 @@ set(INCS "")
 set(LIBS "")
 set(COMFLGS "")
 set(LNKFLGS "")
+set(DEFS "")
 
 # MKL
 if(SCSC_USE_MKL)
@@ -31,6 +32,7 @@ if(SCSC_USE_MKL)
     list(APPEND INCS "${MKL_INCLUDES}")
     list(APPEND LIBS "${MKL_LIBRARIES}")
     set(COMFLGS "${COMFLGS} ${MKL_FLAGS}")
+    list(APPEND DEFS "SCSC_USE_MKL")
   endif()
 endif()
 
@@ -56,8 +58,19 @@ elseif(SCSC_USE_GPU)
     set(COMFLGS "${COMFLGS} ${OpenMP_CXX_FLAGS}")
     set(LNKFLGS "${LNKFLGS} ${OpenMP_CXX_FLAGS}")
   endif()
+else()
+  find_package(OpenMP)
+  if(OpenMP_FOUND)
+    set(COMFLGS "${COMFLGS} ${OpenMP_CXX_FLAGS}")
+    set(LNKFLGS "${LNKFLGS} ${OpenMP_CXX_FLAGS}")
+  endif()
 endif()
 
+# Threads; used by the shared thread pool
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads REQUIRED)
+list(APPEND LIBS "${CMAKE_THREAD_LIBS_INIT}")
+
 # CUDA & MAGMA
 if(SCSC_USE_GPU)
   find_package(CUDA REQUIRED)
@@ -65,6 +78,7 @@ if(SCSC_USE_GPU)
   if(MAGMA_FOUND)
     list(APPEND INCS "${MAGMA_INCLUDES}")
     list(APPEND LIBS "${MAGMA_SPARSE_LIBRARY}" "${MAGMA_LIBRARY}")
+    list(APPEND DEFS "SCSC_USE_GPU")
   endif()
   if(CUDA_FOUND)
     list(APPEND INCS "${CUDA_INCLUDE_DIRS}")
@@ -72,6 +86,19 @@ if(SCSC_USE_GPU)
   endif()
 endif()
 
+# Profiler
+if(SCSC_USE_PROFILER)
+  list(APPEND DEFS "SCSC_USE_PROFILER")
+endif()
+if(SCSC_TRACK_NEW)
+  list(APPEND DEFS "SCSC_TRACK_NEW")
+endif()
+
+# MPI; used by main_mpi only
+if(SCSC_USE_MPI)
+  find_package(MPI REQUIRED)
+endif()
+
 # DOxygen
 if(SCSC_BUILD_DOC)
   find_package(Doxygen REQUIRED)
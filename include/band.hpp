@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    band.hpp
+/// @brief   The band solver header.
+///
+
+#ifndef SCSC_BAND_HPP
+#define SCSC_BAND_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Cholesky factorization of a symmetric positive definite band matrix in place.
+///
+/// @param[in]   n    the size of A.
+/// @param[in]   kd   the bandwidth of A.
+/// @param[in]   A    the lower band storage of A; A[i, j] (j <= i <= j+kd) is stored in A[(i-j) + j*ld].
+/// @param[in]   ld   the leading dimension of A; at least kd+1.
+///
+/// @param[out]  A    replaced by the Cholesky factor L, in the same storage.
+///
+/// @return  0 on success; otherwise the order of the first leading minor that is not positive definite.
+///
+int factorizeBand( const int n, const int kd, double *A, const long ld );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Cholesky factorization of a symmetric positive definite band matrix in place. (single precision)
+///
+/// @see  factorizeBand( const int, const int, double*, const long )
+///
+int factorizeBand( const int n, const int kd, float *A, const long ld );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve L * L' * x = b in place.
+///
+/// @param[in]   n    the size of L.
+/// @param[in]   kd   the bandwidth of L.
+/// @param[in]   L    the band Cholesky factor from factorizeBand.
+/// @param[in]   ld   the leading dimension of L.
+/// @param[in]   b    the right-hand side; n by 1 vector.
+///
+/// @param[out]  b    replaced by the solution.
+///
+void solveBand( const int n, const int kd, const double *L, const long ld, double *b );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve L * L' * x = b in place. (single precision)
+///
+/// @see  solveBand( const int, const int, const double*, const long, double* )
+///
+void solveBand( const int n, const int kd, const float *L, const long ld, float *b );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Rank-one updates of a band Cholesky factor; L * L' := L * L' + sum_q sigma[q] * X[:, q] * X[:, q]'.
+///
+/// @param[in]   n      the size of L.
+/// @param[in]   kd     the bandwidth of L.
+/// @param[in]   L      the band Cholesky factor from factorizeBand.
+/// @param[in]   ld     the leading dimension of L.
+/// @param[in]   r      the number of modifications.
+/// @param[in]   X      the modification vectors; n by r matrix.
+/// @param[in]   ldx    the leading dimension of X.
+/// @param[in]   s      the first row of X with a nonzero entry.
+/// @param[in]   sigma  +1 for an update, -1 for a downdate; r by 1 vector.
+///
+/// @param[out]  L      replaced by the updated factor.
+/// @param[out]  X      reset to zero on success; destroyed otherwise.
+///
+/// @return  0 on success; otherwise the order of the leading minor that is no longer positive definite (L is then
+///          partially updated).
+///
+/// @note  The modifications are applied in order; put the updates before the downdates.
+/// @note  The band of L is preserved if the nonzero entries of each column of X lie within kd+1 consecutive rows.
+///
+int updateBand( const int n, const int kd, double *L, const long ld, const int r, double *X, const long ldx,
+                const int s, const double *sigma );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Reverse Cuthill-McKee ordering of a symmetric sparse matrix.
+///
+/// @param[in]   n       the size of A.
+/// @param[in]   A_row   the row pointers of A;   CSR format.
+/// @param[in]   A_col   the column indices of A; CSR format.
+///
+/// @param[out]  perm    the ordering; the i-th row of the reordered matrix is the perm[i]-th row of A; n by 1 vector.
+/// @param[out]  ptr_bw  the bandwidth of the reordered matrix; pointer.
+///
+/// @note  Each connected component is started from a pseudo-peripheral vertex.
+///
+void reorderBandSparse( const int n, const int *A_row, const int *A_col, int *perm, int *ptr_bw );
+
+#endif  // SCSC_BAND_HPP
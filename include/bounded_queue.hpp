@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    bounded_queue.hpp
+/// @brief   The bounded lock-free queue header.
+///
+
+#ifndef SCSC_BOUNDED_QUEUE_HPP
+#define SCSC_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A bounded lock-free queue of many producers and many consumers (Vyukov).
+///
+/// Every cell carries a sequence number that tells whether it is free for the push of a round or full for its pop, so
+/// that a push and a pop take one compare-and-swap each and never wait for each other. The cells are stored inline; a
+/// queue allocates no memory.
+///
+/// @tparam  T  the element type; copyable.
+/// @tparam  N  the capacity; a power of 2.
+///
+template <typename T, size_t N>
+class BoundedQueue {
+
+  static_assert(N >= 2 && (N & (N-1)) == 0, "The capacity must be a power of 2.");
+
+ public:
+
+  BoundedQueue() : head_(0), tail_(0) {
+    for ( size_t i = 0; i < N; ++i ) {
+      cell_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue( const BoundedQueue& ) = delete;
+  BoundedQueue &operator=( const BoundedQueue& ) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Push an element unless the queue is full.
+  ///
+  /// @param[in]   value  the element.
+  ///
+  /// @return  whether the element is pushed.
+  ///
+  bool tryPush( const T &value ) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for ( ;; ) {
+      Cell &cell = cell_[pos & (N-1)];
+      const size_t seq = cell.seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+      if ( diff == 0 ) {
+        if ( tail_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed) ) {
+          cell.value = value;
+          cell.seq.store(pos+1, std::memory_order_release);
+          return true;
+        }
+      } else if ( diff < 0 ) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Pop an element unless the queue is empty.
+  ///
+  /// @param[out]  value  the element; unchanged if the queue is empty.
+  ///
+  /// @return  whether an element is popped.
+  ///
+  bool tryPop( T &value ) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for ( ;; ) {
+      Cell &cell = cell_[pos & (N-1)];
+      const size_t seq = cell.seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos+1);
+      if ( diff == 0 ) {
+        if ( head_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed) ) {
+          value = cell.value;
+          cell.seq.store(pos+N, std::memory_order_release);
+          return true;
+        }
+      } else if ( diff < 0 ) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T                   value;
+  };
+
+  alignas(64) Cell                cell_[N];
+  alignas(64) std::atomic<size_t> head_;  // the next position to pop
+  alignas(64) std::atomic<size_t> tail_;  // the next position to push
+
+};
+
+#endif  // SCSC_BOUNDED_QUEUE_HPP
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    distributed.hpp
+/// @brief   The distributed-memory (MPI) header.
+///
+
+#ifndef SCSC_DISTRIBUTED_HPP
+#define SCSC_DISTRIBUTED_HPP
+
+#include <mpi.h>
+#include <harmonic.hpp>
+#include <iterative.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The halo of a distributed vector.
+///
+/// Each rank owns a contiguous range of the interior vertices. A local vector stores the owned entries followed by the
+/// ghost entries (the entries owned by other ranks that the local rows refer to), sorted by global index.
+///
+struct Halo {
+  int          nown;       ///< the number of owned entries.
+  int          nghost;     ///< the number of ghost entries.
+  int          nneighbor;  ///< the number of neighbour ranks.
+  int         *neighbor;   ///< the neighbour ranks; nneighbor by 1 vector.
+  int         *send_ptr;   ///< the offsets of the send list of each neighbour; nneighbor+1 by 1 vector.
+  int         *send_idx;   ///< the local indices of the owned entries to send; send_ptr[nneighbor] by 1 vector.
+  int         *recv_ptr;   ///< the offsets of the ghost entries from each neighbour; nneighbor+1 by 1 vector.
+  double      *buffer;     ///< the workspace of the sent entries; send_ptr[nneighbor] by 1 vector.
+  MPI_Request *request;    ///< the pending requests; 2*nneighbor by 1 vector.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Partition the interior vertices of a mesh by recursive graph bisection.
+///
+/// @param[in]   nv     the number of vertices.
+/// @param[in]   nb     the number of boundary vertices.
+/// @param[in]   nf     the number of faces.
+/// @param[in]   F      the faces (after reorderVertex); nf by 3 matrix.
+/// @param[in]   npart  the number of parts.
+///
+/// @param[out]  order  the interior vertices (zero-based, interior index) grouped by part; nv-nb by 1 vector.
+/// @param[out]  start  the offset of each part in order; npart+1 by 1 vector.
+///
+/// @note  Each bisection splits a breadth-first ordering from a pseudo-peripheral vertex, so that the parts are
+///        compact and their sizes are balanced.
+///
+void partitionMesh( const int nv, const int nb, const int nf, const int *F, const int npart, int *order, int *start );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Construct the halo.
+///
+/// @param[in]   comm    the communicator.
+/// @param[in]   start   the first interior vertex owned by each rank; size+1 by 1 vector.
+/// @param[in]   nghost  the number of ghost entries.
+/// @param[in]   ghost   the global interior indices of the ghost entries, in increasing order; nghost by 1 vector.
+///
+/// @param[out]  halo    the halo; destroy by destroyHalo.
+///
+void constructHalo( MPI_Comm comm, const int *start, const int nghost, const int *ghost, Halo *halo );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start updating the ghost entries of a local vector.
+///
+/// @param[in]   comm  the communicator.
+/// @param[in]   halo  the halo.
+/// @param[in]   x     the local vector; nown+nghost by 1 vector.
+///
+/// @note  The owned entries of x must not change and the ghost entries must not be accessed until finishHalo.
+///
+void startHalo( MPI_Comm comm, Halo *halo, double *x );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Finish updating the ghost entries of a local vector.
+///
+/// @param[in]   halo  the halo.
+///
+void finishHalo( Halo *halo );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Destroy the halo.
+///
+/// @param[in]   halo  the halo.
+///
+void destroyHalo( Halo *halo );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Construct the local rows of the Laplacian.
+///
+/// The local vertices are numbered as the global ones: the boundary vertices, the owned interior vertices, and then the
+/// ghost interior vertices.
+///
+/// @param[in]   method       the method of Laplacian construction.
+/// @param[in]   nl           the number of local vertices.
+/// @param[in]   nb           the number of boundary vertices.
+/// @param[in]   nown         the number of owned interior vertices.
+/// @param[in]   nf           the number of local faces; the faces incident to the owned vertices.
+/// @param[in]   V            the coordinate of local vertices; nl by 3 matrix.
+/// @param[in]   F            the local faces, in local numbering; nf by 3 matrix.
+///
+/// @param[out]  ptr_Lii_val  the values of the Laplacian matrix;         Lii part, nown rows, nl-nb columns.
+/// @param[out]  ptr_Lii_row  the row indices of the Laplacian matrix;    Lii part.
+/// @param[out]  ptr_Lii_col  the column indices of the Laplacian matrix; Lii part.
+/// @param[out]  ptr_Lib_val  the values of the Laplacian matrix;         Lib part, nown rows, nb columns.
+/// @param[out]  ptr_Lib_row  the row indices of the Laplacian matrix;    Lib part.
+/// @param[out]  ptr_Lib_col  the column indices of the Laplacian matrix; Lib part.
+///
+/// @note  The rows equal the corresponding rows of constructLaplacianSparse; the columns are sorted.
+///
+void constructLaplacianMpi( const Method method, const int nl, const int nb, const int nown, const int nf,
+                            const double *V, const int *F,
+                            double **ptr_Lii_val, int **ptr_Lii_row, int **ptr_Lii_col,
+                            double **ptr_Lib_val, int **ptr_Lib_row, int **ptr_Lib_col );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Distributed sparse matrix-vector multiplication; y := A * x.
+///
+/// @param[in]   comm   the communicator.
+/// @param[in]   halo   the halo.
+/// @param[in]   A_val  the values of the local rows of A;         CSR format.
+/// @param[in]   A_row  the row pointers of the local rows of A;   CSR format.
+/// @param[in]   A_col  the column indices of the local rows of A; CSR format, sorted, local numbering.
+/// @param[in]   x      the local input vector; nown+nghost by 1 vector.
+///
+/// @param[out]  x      the ghost entries are updated.
+/// @param[out]  y      the local output vector; nown by 1 vector.
+///
+/// @note  The rows without ghost columns are computed while the ghost entries are being exchanged.
+///
+void spmvMpi( MPI_Comm comm, Halo *halo, const double *A_val, const int *A_row, const int *A_col, double *x, double *y );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve A * x = b using the distributed preconditioned conjugate gradient method.
+///
+/// @param[in]   comm     the communicator.
+/// @param[in]   halo     the halo.
+/// @param[in]   A_val    the values of the local rows of A;         CSR format.
+/// @param[in]   A_row    the row pointers of the local rows of A;   CSR format.
+/// @param[in]   A_col    the column indices of the local rows of A; CSR format, sorted, local numbering.
+/// @param[in]   b        the local right-hand side; nown by 1 vector.
+/// @param[in]   x        the local initial guess;   nown+nghost by 1 vector.
+/// @param[in]   precond  the local preconditioner; acts on nown by 1 vectors.
+/// @param[in]   tol      the tolerance of the relative residual.
+/// @param[in]   maxit    the maximum number of iterations.
+///
+/// @param[out]  x        replaced by the solution.
+/// @param[out]  ptr_res  the final relative residual; pointer. (ignored if null)
+///
+/// @return  the number of iterations.
+///
+/// @note  A must be symmetric positive definite. The two inner products of each iteration share one all-reduce.
+///
+int solvePcgMpi( MPI_Comm comm, Halo *halo, const double *A_val, const int *A_row, const int *A_col,
+                 const double *b, double *x, const Preconditioner &precond, const double tol, const int maxit,
+                 double *ptr_res );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem. (distributed version)
+///
+/// @param[in]   comm     the communicator.
+/// @param[in]   halo     the halo.
+/// @param[in]   nb       the number of boundary vertices.
+/// @param[in]   Lii_val  the values of the local rows of the Laplacian;         Lii part. See constructLaplacianMpi.
+/// @param[in]   Lii_row  the row indices of the local rows of the Laplacian;    Lii part.
+/// @param[in]   Lii_col  the column indices of the local rows of the Laplacian; Lii part.
+/// @param[in]   Lib_val  the values of the local rows of the Laplacian;         Lib part.
+/// @param[in]   Lib_row  the row indices of the local rows of the Laplacian;    Lib part.
+/// @param[in]   Lib_col  the column indices of the local rows of the Laplacian; Lib part.
+/// @param[in]   Ub       the coordinate of the boundary vertices in the disk; nb by 2 matrix.
+///
+/// @param[out]  Ui       the coordinate of the owned interior vertices in the disk; nown by 2 matrix.
+/// @param[out]  info     the information of the solver (the same on all ranks). (ignored if null)
+///
+void solveHarmonicMpi( MPI_Comm comm, Halo *halo, const int nb,
+                       const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                       const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                       const double *Ub, double *Ui, SolveInfo *info );
+
+#endif  // SCSC_DISTRIBUTED_HPP
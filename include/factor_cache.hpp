@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    factor_cache.hpp
+/// @brief   The factorization cache header.
+///
+
+#ifndef SCSC_FACTOR_CACHE_HPP
+#define SCSC_FACTOR_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <harmonic.hpp>
+#include <workspace.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A factorization kept in memory instead of a file. (e.g. by a resident service; see mesh_service.hpp)
+///
+struct FactorMemory {
+  Workspace store;              ///< the buffers of the arrays.
+  int       n       = 0;        ///< the size of the matrix; 0 if empty.
+  int       bw      = 0;        ///< the bandwidth of the factor. (solver specific)
+  int      *perm    = nullptr;  ///< the ordering; n by 1 vector.
+  double   *factor  = nullptr;  ///< the numeric factor. (null if not stored)
+  long      nfactor = 0;        ///< the length of factor.
+  double   *val     = nullptr;  ///< the values of the factorized Lii; CSR format. (null if not stored)
+  long      nval    = 0;        ///< the length of val.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The key of the cached factorization and Laplacian of a mesh.
+///
+/// The cache consists of two files, <path>.fac (the factorization of Lii) and <path>.lap (the Laplacian and the vertex
+/// coordinates it was built from). If memory is set, the factorization is kept there instead of <path>.fac.
+///
+struct FactorCache {
+  char          path[4096];        ///< the cache files, without extension.
+  uint64_t      topology;          ///< the hash of the method, the sizes, and the reordered faces.
+  FactorMemory *memory = nullptr;  ///< the factorization in memory. (if not null)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A cached factorization, mapped in memory.
+///
+struct FactorData {
+  int           n;        ///< the size of the matrix.
+  int           bw;       ///< the bandwidth of the factor. (solver specific)
+  const int    *perm;     ///< the ordering; n by 1 vector. (null if not cached)
+  const double *factor;   ///< the numeric factor. (null if not cached)
+  long          nfactor;  ///< the length of factor.
+  const double *val;      ///< the values of the factorized Lii; CSR format. (null if not cached)
+  long          nval;     ///< the length of val.
+  void         *map;      ///< the mapped file; null if kept in memory.
+  size_t        size;     ///< the size of the mapped file.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A cached Laplacian, mapped in memory.
+///
+struct LaplacianData {
+  const double *V;        ///< the coordinate of vertices the Laplacian was built from; nv by 3 matrix.
+  const double *Lii_val;  ///< the values of the Laplacian matrix;         Lii part.
+  const int    *Lii_row;  ///< the row indices of the Laplacian matrix;    Lii part.
+  const int    *Lii_col;  ///< the column indices of the Laplacian matrix; Lii part.
+  const double *Lib_val;  ///< the values of the Laplacian matrix;         Lib part.
+  const int    *Lib_row;  ///< the row indices of the Laplacian matrix;    Lib part.
+  const int    *Lib_col;  ///< the column indices of the Laplacian matrix; Lib part.
+  void         *map;      ///< the mapped file.
+  size_t        size;     ///< the size of the mapped file.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Compute the cache key of a mesh.
+///
+/// @param[in]   dir     the cache directory.
+/// @param[in]   method  the method of Laplacian construction.
+/// @param[in]   nv      the number of vertices.
+/// @param[in]   nb      the number of boundary vertices.
+/// @param[in]   nf      the number of faces.
+/// @param[in]   F       the faces (after reorderVertex); nf by 3 matrix.
+///
+/// @param[out]  cache   the cache key.
+///
+void initFactorCache( const char *dir, const Method method, const int nv, const int nb, const int nf, const int *F,
+                      FactorCache *cache );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Hash bytes by 64-bit FNV-1a, as the cache keys.
+///
+/// @param[in]   h     the hash of the preceding bytes; kHashBasis to start.
+/// @param[in]   data  the bytes.
+/// @param[in]   size  the number of bytes.
+///
+/// @return  the hash.
+///
+uint64_t hashBytes( uint64_t h, const void *data, const size_t size );
+
+const uint64_t kHashBasis = 0xcbf29ce484222325ULL;  ///< the FNV-1a offset basis; the hash of no bytes.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Map a cached factorization; points into the memory of the key if set.
+///
+/// @param[in]   cache  the cache key.
+/// @param[in]   n      the size of the matrix.
+///
+/// @param[out]  data   the cached factorization; unmap by releaseFactorCache.
+///
+/// @return  true if found.
+///
+bool loadFactorCache( const FactorCache *cache, const int n, FactorData *data );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Store a factorization in the cache; replaces the existing file, or copies into the memory of the key if set.
+///
+/// @param[in]   cache    the cache key.
+/// @param[in]   n        the size of the matrix.
+/// @param[in]   bw       the bandwidth of the factor. (solver specific)
+/// @param[in]   perm     the ordering; n by 1 vector.
+/// @param[in]   factor   the numeric factor. (only the ordering is stored if null)
+/// @param[in]   nfactor  the length of factor.
+/// @param[in]   val      the values of the factorized Lii; CSR format.
+/// @param[in]   nval     the length of val.
+///
+/// @return  true on success.
+///
+bool storeFactorCache( const FactorCache *cache, const int n, const int bw, const int *perm,
+                       const double *factor, const long nfactor, const double *val, const long nval );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Unmap a cached factorization.
+///
+/// @param[in]   data  the cached factorization.
+///
+void releaseFactorCache( FactorData *data );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Map a cached Laplacian.
+///
+/// @param[in]   cache  the cache key.
+/// @param[in]   nv     the number of vertices.
+/// @param[in]   nb     the number of boundary vertices.
+///
+/// @param[out]  data   the cached Laplacian; unmap by releaseLaplacianCache.
+///
+/// @return  true if found.
+///
+bool loadLaplacianCache( const FactorCache *cache, const int nv, const int nb, LaplacianData *data );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Store a Laplacian in the cache; replaces the existing file.
+///
+/// @param[in]   cache    the cache key.
+/// @param[in]   nv       the number of vertices.
+/// @param[in]   nb       the number of boundary vertices.
+/// @param[in]   V        the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   Lii_val  the values of the Laplacian matrix;         Lii part.
+/// @param[in]   Lii_row  the row indices of the Laplacian matrix;    Lii part.
+/// @param[in]   Lii_col  the column indices of the Laplacian matrix; Lii part.
+/// @param[in]   Lib_val  the values of the Laplacian matrix;         Lib part.
+/// @param[in]   Lib_row  the row indices of the Laplacian matrix;    Lib part.
+/// @param[in]   Lib_col  the column indices of the Laplacian matrix; Lib part.
+///
+/// @return  true on success.
+///
+bool storeLaplacianCache( const FactorCache *cache, const int nv, const int nb, const double *V,
+                          const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                          const double *Lib_val, const int *Lib_row, const int *Lib_col );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Unmap a cached Laplacian.
+///
+/// @param[in]   data  the cached Laplacian.
+///
+void releaseLaplacianCache( LaplacianData *data );
+
+#endif  // SCSC_FACTOR_CACHE_HPP
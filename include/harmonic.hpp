@@ -9,6 +9,10 @@
 #define SCSC_HARMONIC_HPP
 
 #include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <iterative.hpp>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  The enumeration of Laplacian construction methods.
@@ -19,17 +23,141 @@ enum class Method {
   COUNT,          ///< Used for counting number of methods.
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of factorization precisions of direct solvers.
+///
+enum class Precision {
+  DOUBLE = 0,  ///< Double precision factorization.
+  MIXED  = 1,  ///< Single precision factorization with iterative refinement in double precision.
+  COUNT,       ///< Used for counting number of precisions.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of conjugate gradient variants of iterative solvers.
+///
+enum class Krylov {
+  CG        = 0,  ///< Preconditioned conjugate gradient; two reductions per iteration.
+  PIPELINED = 1,  ///< Pipelined conjugate gradient (Ghysels & Vanroose); one reduction per iteration, overlapped.
+  SSTEP     = 2,  ///< s-step conjugate gradient; one reduction per s iterations.
+  COUNT,          ///< Used for counting number of variants.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of preconditioners of iterative solvers.
+///
+enum class Precond {
+  NONE   = 0,  ///< No preconditioner.
+  JACOBI = 1,  ///< Jacobi (diagonal) preconditioner.
+  COUNT,       ///< Used for counting number of preconditioners.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of shapes of generated meshes.
+///
+enum class MeshShape {
+  GRID   = 0,  ///< Structured grid of the unit square.
+  JITTER = 1,  ///< Jittered grid points; each cell split along its Delaunay diagonal.
+  BUMPY  = 2,  ///< Structured grid lifted onto a bumpy height field.
+  COUNT,       ///< Used for counting number of shapes.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of error codes; see HarmonicError.
+///
+enum class ErrorCode {
+  IO          = 0,  ///< A file can not be opened, read, or written.
+  FORMAT      = 1,  ///< The input is malformed.
+  NUMERIC     = 2,  ///< A factorization or a solve failed; e.g. Lii is not positive definite.
+  UNAVAILABLE = 3,  ///< The method or the solver backend is not available in this build.
+  INTERNAL    = 4,  ///< The computed data are inconsistent.
+  COUNT,            ///< Used for counting number of error codes.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The error thrown by the routines.
+///
+/// The routines throw instead of ending the process, so that a failed mapping leaves the others in the process running.
+/// The buffers a routine allocated are freed before it throws, and the thread pool passes the error of a loop body on
+/// to the caller of the loop. The caller owns the error; nothing is printed.
+///
+class HarmonicError : public std::runtime_error {
+ public:
+  HarmonicError( const ErrorCode code, const std::string &what ) : std::runtime_error(what), code_(code) {}
+  ErrorCode code() const { return code_; }  ///< the error code.
+ private:
+  ErrorCode code_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The information of harmonic problem solving.
+///
+struct SolveInfo {
+  int    iter;      ///< the number of iterations of both coordinates; 0 for direct solvers.
+  double res0;      ///< the initial relative residual; the maximum of both coordinates.
+  double res;       ///< the final relative residual; the maximum of both coordinates.
+  int    nupdate;   ///< the number of rank-one updates applied to a cached factorization; 0 if none.
+  int    nrefine;   ///< the number of iterative refinement steps of both coordinates; 0 if none.
+  bool   fallback;  ///< whether the mixed precision refinement stagnated and Lii was refactorized in double precision.
+  int    bw;        ///< the bandwidth of the band (or dense) factor of Lii; 0 if not banded.
+  long   nfactor;   ///< the nonzeros of the factor of Lii; 0 for iterative solvers.
+};
+
+struct FactorCache;
+class Workspace;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The options of harmonic problem solving.
+///
+struct SolveOptions {
+  const char        *solver    = nullptr;            ///< the solver backend; see findSparseBackend. (the default if null)
+  Precond            precond   = Precond::JACOBI;    ///< the preconditioner of iterative solvers.
+  double             tol       = 1e-10;              ///< the tolerance of the relative residual of iterative solvers.
+  Precision          precision = Precision::DOUBLE;  ///< the factorization precision of direct solvers.
+  Krylov             krylov    = Krylov::CG;         ///< the conjugate gradient variant of iterative solvers.
+  const FactorCache *cache     = nullptr;            ///< the factorization cache key; see initFactorCache. (if not null)
+  Monitor            monitor   = nullptr;            ///< the iteration monitor of iterative solvers. (if not empty)
+  Workspace         *work      = nullptr;            ///< the scratch workspace; see workspace.hpp. (if not null)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The options of the resident service of main_sp; see mesh_service.hpp.
+///
+struct ServiceOptions {
+  const char *serve   = nullptr;  ///< the socket to serve on. (if not null)
+  const char *connect = nullptr;  ///< the socket of the service to send the request to. (if not null)
+  long        budget  = 1024;     ///< the memory budget of the cached meshes, in MiB.
+  bool        send    = false;    ///< whether to send the mesh itself instead of its path.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The command line arguments.
+///
+struct Arguments {
+  const char     *input   = "input.obj";         ///< the input file. (-f)
+  const char     *output  = "output.obj";        ///< the output file. (-o)
+  Method          method  = Method::KIRCHHOFF;   ///< the method of Laplacian construction. (-t)
+  const char     *guess   = nullptr;             ///< the initial guess file (a previous output file). (-g)
+  bool            compare = false;               ///< whether to also solve from zero to report the iterations saved. (-z)
+  const char     *cache   = nullptr;             ///< the factorization cache directory. (-c)
+  const char     *log     = nullptr;             ///< the convergence history file. (-l)
+  const char     *stats   = nullptr;             ///< the run statistics ("json" or a JSON file); see startStats. (-j)
+  bool            stream  = false;               ///< whether to compute the edge data while reading. (-S)
+  SolveOptions    options;                       ///< the solver options; only those read are set. (-s, -m, -e, -p, -k)
+  ServiceOptions  service;                       ///< the options of the resident service. (-d, -r, -b, -i)
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Reads the arguments.
 ///
 /// @param[in]   argc    The number of input arguments.
 /// @param[in]   argv    The input arguments.
+/// @param[in]   accept  The short names of the options the binary supports, e.g. "fto"; -h is always supported.
+///
+/// @param[out]  args    The arguments; those not given are unchanged.
 ///
-/// @param[out]  input   The input file.
-/// @param[out]  output  The output file.
-/// @param[out]  method  The method.
+/// @note  -h displays the usage of the supported options and exits; an unsupported option displays it and exits with 1.
 ///
-void readArgs( int argc, char** argv, const char *&input, const char *&output, Method &method );
+void readArgs( int argc, char** argv, const char *accept, Arguments &args );
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Reads the object file.
@@ -46,6 +174,62 @@ void readArgs( int argc, char** argv, const char *&input, const char *&output, M
 ///
 void readObject( const char *input, int *ptr_nv, int *ptr_nf, double **ptr_V, double **ptr_C, int **ptr_F );
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Count the vertices and faces of the object file.
+///
+/// @param[in]   input   the path to the object file.
+///
+/// @param[out]  ptr_nv  the number of vertices; pointer.
+/// @param[out]  ptr_nf  the number of faces;    pointer.
+///
+/// @note  Throws HarmonicError (IO or FORMAT) if the file can not be read or has no vertex.
+///
+/// @see  readObject( const char*, const int, const int, double*, double*, int* )
+///
+void scanObject( const char *input, int *ptr_nv, int *ptr_nf );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Reads the object file into given arrays.
+///
+/// @param[in]   input   the path to the object file.
+/// @param[in]   nv      the number of vertices; see scanObject.
+/// @param[in]   nf      the number of faces;    see scanObject.
+///
+/// @param[out]  V       the coordinate of vertices;      nv by 3 matrix.
+/// @param[out]  C       the color (RGB) of the vertices; nv by 3 matrix.
+/// @param[out]  F       the faces;                       nf by 3 matrix.
+///
+/// @note  The output arrays should be allocated before calling this routine.
+/// @note  Throws HarmonicError (IO or FORMAT) if the file can not be read, a line can not be parsed, a face refers to
+///        no vertex, or the file holds more vertices or faces than given.
+///
+void readObject( const char *input, const int nv, const int nf, double *V, double *C, int *F );
+
+/// @brief  The callback of readObject on a batch of faces; called as emit(context, begin, end, nv_read) once the faces
+///         [begin, end) and the first nv_read vertices are read.
+using FaceBatch = void (*)( void *context, int begin, int end, int nv_read );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Reads the object file into given arrays, handing the faces over in batches while reading.
+///
+/// @param[in]   input    the path to the object file.
+/// @param[in]   nv       the number of vertices; see scanObject.
+/// @param[in]   nf       the number of faces;    see scanObject.
+/// @param[in]   batch    the number of faces of a batch.
+/// @param[in]   emit     the callback on each batch, in order; see FaceBatch.
+/// @param[in]   context  the context passed to emit.
+///
+/// @param[out]  V        the coordinate of vertices;      nv by 3 matrix.
+/// @param[out]  C        the color (RGB) of the vertices; nv by 3 matrix.
+/// @param[out]  F        the faces;                       nf by 3 matrix.
+///
+/// @note  The output arrays should be allocated before calling this routine.
+/// @note  The colors are set after the last batch if the file has none.
+/// @note  Throws HarmonicError as readObject( const char*, const int, const int, double*, double*, int* ) does.
+///
+void readObject( const char *input, const int nv, const int nf, double *V, double *C, int *F,
+                 const int batch, FaceBatch emit, void *context );
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Verify the boundary vertices.
 ///
@@ -69,30 +253,57 @@ void verifyBoundary( const int nv, const int nf, const int *F, int *ptr_nb, int
 /// @param[in]   V      the coordinate of vertices;       nv by 3 matrix.
 /// @param[in]   C      the color (RGB) of the vertices;  nv by 3 matrix.
 /// @param[in]   F      the faces;                        nf by 3 matrix.
+/// @param[in]   idx_b  the indices of boundary vertices;  nb by 1 vector.
+/// @param[in]   work   the scratch workspace; see workspace.hpp. (a local one if null)
 ///
 /// @param[out]  V      replaced by the reordered coordinate of vertices;      nv by 3 matrix.
 /// @param[out]  C      replaced by the reordered color (RGB) of the vertices; nv by 3 matrix.
 /// @param[out]  F      replaced by the reordered faces;                       nv by 3 matrix.
-/// @param[out]  idx_b  the indices of boundary vertices;                      nb by 1 vector.
 ///
 /// @note  the vertices are reordered so that the first nb vertices are the boundary vertices.
 ///
-void reorderVertex( const int nv, const int nb, const int nf, double *V, double *C, int *F, const int *idx_b );
+void reorderVertex( const int nv, const int nb, const int nf, double *V, double *C, int *F, const int *idx_b,
+                    Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Reorder the interior vertices to reduce the bandwidth of the Laplacian.
+///
+/// @param[in]   nv      the number of vertices.
+/// @param[in]   nb      the number of boundary vertices.
+/// @param[in]   nf      the number of faces.
+/// @param[in]   V       the coordinate of vertices;       nv by 3 matrix.
+/// @param[in]   C       the color (RGB) of the vertices;  nv by 3 matrix.
+/// @param[in]   F       the faces;                        nf by 3 matrix.
+///
+/// @param[out]  V       replaced by the reordered coordinate of vertices;      nv by 3 matrix.
+/// @param[out]  C       replaced by the reordered color (RGB) of the vertices; nv by 3 matrix.
+/// @param[out]  F       replaced by the reordered faces;                       nf by 3 matrix.
+/// @param[out]  ptr_bw  the bandwidth of the Lii part of the Laplacian; pointer.
+/// @param[out]  ptr_nr  the number of interior vertices adjacent to the boundary; pointer.
+///
+/// @note  The vertices should be reordered by reorderVertex first; the boundary vertices are kept in place.
+/// @note  The interior vertices are ordered by reverse Cuthill-McKee from the boundary, so that the interior vertices
+///        adjacent to the boundary are the last nr vertices.
+///
+void reorderBand( const int nv, const int nb, const int nf, double *V, double *C, int *F, int *ptr_bw, int *ptr_nr );
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Construct the Laplacian.
 ///
 /// @param[in]   method  the method of Laplacian construction.
 /// @param[in]   nv      the number of vertices.
+/// @param[in]   nb      the number of boundary vertices.
 /// @param[in]   nf      the number of faces.
 /// @param[in]   V       the coordinate of vertices;      nv by 3 matrix.
 /// @param[in]   F       the faces; nf by 3 matrix.
 ///
-/// @param[out]  L       the Laplacian matrix; nv by nv matrix.
+/// @param[out]  L       the interior rows of the Laplacian matrix; (nv-nb) by nv matrix. [ Lib, Lii ].
 ///
 /// @note  The output arrays should be allocated before calling this routine.
+/// @note  The rows of the boundary vertices (the first nb vertices) are not formed.
 ///
-void constructLaplacian( const Method method, const int nv, const int nf, const double *V, const int *F, double *L );
+void constructLaplacian( const Method method, const int nv, const int nb, const int nf, const double *V, const int *F,
+                         double *L );
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Map the boundary vertices.
@@ -112,27 +323,169 @@ void mapBoundary( const int nv, const int nb, const double *V, double *U );
 ///
 /// @param[in]   nv  the number of vertices.
 /// @param[in]   nb  the number of boundary vertices.
-/// @param[in]   L   the Laplacian matrix; nv by nv matrix.
+/// @param[in]   L   the interior rows of the Laplacian matrix; (nv-nb) by nv matrix. [ Lib, Lii ].
 /// @param[in]   U   the coordinate of vertices on the disk; nv by 2 matrix. The first nb vertices are given.
 ///
+/// @param[out]  L   the Lii part may be overwritten by its factorization.
 /// @param[out]  U   the coordinate of vertices on the disk; nv by 2 matrix. The last (nv-nb) vertices are replaced.
 ///
 /// @note  The output arrays should be allocated before calling this routine.
+/// @note  Throws HarmonicError (NUMERIC) if Lii is not positive definite.
 ///
 void solveHarmonic( const int nv, const int nb, double *L, double *U );
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using MKL (LAPACK). See solveHarmonic.
+///
+void solveHarmonicMkl( const int nv, const int nb, double *L, double *U );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using MAGMA. See solveHarmonic.
+///
+void solveHarmonicMagma( const int nv, const int nb, double *L, double *U );
+
+/// @brief  Initialize MAGMA once per process; it is finalized at exit. (used by the MAGMA solvers)
+void initMagma();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The dense solver; see solveHarmonic.
+///
+using DenseSolver = void (*)( const int nv, const int nb, double *L, double *U );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A dense solver backend.
+///
+struct DenseBackend {
+  const char  *name;         ///< the name; the value of --solver.
+  const char  *description;  ///< the description.
+  DenseSolver  solve;        ///< the solver.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Find a dense solver backend.
+///
+/// @param[in]   name  the name of the backend; the default backend if null.
+///
+/// @return  the backend; null if not available.
+///
+const DenseBackend *findDenseBackend( const char *name );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  List the dense solver backends compiled in.
+///
+/// @param[out]  ptr_backend  the backends; pointer.
+///
+/// @return  the number of backends.
+///
+int listDenseBackends( const DenseBackend **ptr_backend );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Construct the Laplacian. (banded version)
+///
+/// @param[in]   method  the method of Laplacian construction.
+/// @param[in]   nv      the number of vertices.
+/// @param[in]   nb      the number of boundary vertices.
+/// @param[in]   nf      the number of faces.
+/// @param[in]   V       the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   F       the faces; nf by 3 matrix.
+/// @param[in]   bw      the bandwidth of the Lii part; see reorderBand.
+/// @param[in]   nr      the number of interior vertices adjacent to the boundary; see reorderBand.
+///
+/// @param[out]  L       the Laplacian matrix; (bw+1)*(nv-nb) + nr*nb vector. [ Lii, Lib ].
+///                      Lii is the lower band storage; (bw+1) by (nv-nb) matrix.
+///                      Lib is the last nr rows of the Lib part; nr by nb matrix.
+///
+/// @note  The output arrays should be allocated before calling this routine.
+///
+void constructLaplacianBand( const Method method, const int nv, const int nb, const int nf, const double *V, const int *F,
+                             const int bw, const int nr, double *L );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem. (banded version)
+///
+/// @param[in]   nv  the number of vertices.
+/// @param[in]   nb  the number of boundary vertices.
+/// @param[in]   bw  the bandwidth of the Lii part.
+/// @param[in]   nr  the number of interior vertices adjacent to the boundary.
+/// @param[in]   L   the Laplacian matrix; (bw+1)*(nv-nb) + nr*nb vector. [ Lii, Lib ]. See constructLaplacianBand.
+/// @param[in]   U   the coordinate of vertices on the disk; nv by 2 matrix. The first nb vertices are given.
+///
+/// @param[out]  L   the Lii part is overwritten by its factorization.
+/// @param[out]  U   the coordinate of vertices on the disk; nv by 2 matrix. The last (nv-nb) vertices are replaced.
+///
+/// @note  The output arrays should be allocated before calling this routine.
+///
+void solveHarmonicBand( const int nv, const int nb, const int bw, const int nr, double *L, double *U );
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  write the object file
 ///
 /// @param[in]   input  the path to the object file.
 ///
-/// @param[in]   nv  the number of vertices.
-/// @param[in]   nf  the number of faces.
-/// @param[in]   U   the coordinate of vertices on the disk; nv by 2 matrix.
-/// @param[in]   C   the color of vertices. RGB.
-/// @param[in]   F   the faces; nf by 3 matrix.
+/// @param[in]   nv    the number of vertices.
+/// @param[in]   nf    the number of faces.
+/// @param[in]   U     the coordinate of vertices on the disk; nv by 2 matrix.
+/// @param[in]   C     the color of vertices. RGB.
+/// @param[in]   F     the faces; nf by 3 matrix.
+/// @param[in]   work  the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @note  Throws HarmonicError (IO) if the file can not be written.
 ///
-void writeObject( const char *input, const int nv, const int nf, double *U, double *C, int *F );
+void writeObject( const char *input, const int nv, const int nf, double *U, double *C, int *F, Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  write a mesh to an object file (in 3D, unlike writeObject)
+///
+/// @param[in]   output  the path to the object file.
+///
+/// @param[in]   nv    the number of vertices.
+/// @param[in]   nf    the number of faces.
+/// @param[in]   V     the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   C     the color of vertices. RGB. (C[0] = -1 if none)
+/// @param[in]   F     the faces; nf by 3 matrix.
+/// @param[in]   work  the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @note  Throws HarmonicError (IO) if the file can not be written.
+///
+void writeMesh( const char *output, const int nv, const int nf, const double *V, const double *C, const int *F,
+                Workspace *work = nullptr );
+
+const int kMaxMeshCells = 18918;  ///< the most cells per side of a generated mesh; the 6n^2 entries of F fit in int.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Count the vertices and faces of a generated mesh.
+///
+/// @param[in]   n       the number of cells per side; at most kMaxMeshCells.
+///
+/// @param[out]  ptr_nv  the number of vertices; (n+1)^2; pointer.
+/// @param[out]  ptr_nf  the number of faces;    2n^2;    pointer.
+///
+/// @see  generateMesh
+///
+void scanMesh( const int n, int *ptr_nv, int *ptr_nf );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Generate a disk-topology mesh over the unit square, for scaling studies.
+///
+/// @param[in]   shape    the shape of the mesh.
+/// @param[in]   n        the number of cells per side.
+/// @param[in]   seed     the random seed; the same seed gives the same mesh for any number of threads.
+/// @param[in]   shuffle  whether to shuffle the order of vertices. (like meshes from scanners)
+///
+/// @param[out]  V        the coordinate of vertices; nv by 3 matrix.
+/// @param[out]  C        the color of vertices; all -1. (none)
+/// @param[out]  F        the faces; nf by 3 matrix; counterclockwise.
+///
+/// @note  The output arrays should be allocated before calling this routine; see scanMesh.
+///
+void generateMesh( const MeshShape shape, const int n, const uint64_t seed, const bool shuffle,
+                   double *V, double *C, int *F );
+
+/// @brief  The name of a mesh shape; "grid", "jitter", or "bumpy".
+const char *meshShapeName( const MeshShape shape );
+
+/// @brief  Find a mesh shape by its name; COUNT if unknown.
+MeshShape findMeshShape( const char *name );
 
 
 
@@ -142,13 +495,39 @@ void writeObject( const char *input, const int nv, const int nf, double *U, doub
 /// @param[in]   nv      the number of vertices.
 /// @param[in]   nf      the number of faces.
 /// @param[in]   F       the faces; nf by 3 matrix.
+/// @param[in]   work    the scratch workspace; see workspace.hpp. (a local one if null)
 ///
 /// @param[out]  ptr_nb  the number of boundary vertices; pointer.
 /// @param[out]  idx_b   the indices of boundary vertices, nb by 1 vector.
 ///
 /// @note  The output arrays should be allocated before calling this routine.
 ///
-void verifyBoundarySparse( const int nv, const int nf, const int *F, int *ptr_nb, int *idx_b );
+void verifyBoundarySparse( const int nv, const int nf, const int *F, int *ptr_nb, int *idx_b, Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Generate the directed edge keys of some faces. (sparse version)
+///
+/// @param[in]   nf     the number of faces.
+/// @param[in]   F      the faces; nf by 3 matrix.
+/// @param[in]   begin  the first face.
+/// @param[in]   end    the last face plus one.
+///
+/// @param[out]  E      the keys of the edges of the faces [begin, end); nf by 3 matrix.
+///
+void edgeKeySparse( const int nf, const int *F, const int begin, const int end, uint64_t *E );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Verify the boundary vertices from the directed edge keys. (sparse version)
+///
+/// @param[in]   nf      the number of faces.
+/// @param[in]   E       the keys of the edges of the faces; nf by 3 matrix; see edgeKeySparse.
+/// @param[in]   work    the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @param[out]  E       the keys, sorted.
+/// @param[out]  ptr_nb  the number of boundary vertices; pointer.
+/// @param[out]  idx_b   the indices of boundary vertices, nb by 1 vector.
+///
+void verifyBoundarySparse( const int nf, uint64_t *E, int *ptr_nb, int *idx_b, Workspace *work = nullptr );
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Construct the Laplacian. (sparse version)
@@ -159,6 +538,10 @@ void verifyBoundarySparse( const int nv, const int nf, const int *F, int *ptr_nb
 /// @param[in]   nf           the number of faces.
 /// @param[in]   V            the coordinate of vertices; nv by 3 matrix.
 /// @param[in]   F            the faces; nf by 3 matrix.
+/// @param[in]   work         the scratch workspace; see workspace.hpp. (a local one if null)
+/// @param[in]   out          the workspace the arrays are taken from; not work. (allocated using new if null)
+/// @param[in]   W            the cotangent weights of the edges; nf by 3 matrix; see cotangentWeightSparse.
+///                           (computed here if null; ignored by the Kirchhoff method)
 ///
 /// @param[out]  ptr_Lii_val  the values of the Laplacian matri;          Lii part; pointer-to-pointer.
 /// @param[out]  ptr_Lii_row  the row indices of the Laplacian matrix;    Lii part; pointer-to-pointer.
@@ -168,33 +551,188 @@ void verifyBoundarySparse( const int nv, const int nf, const int *F, int *ptr_nb
 /// @param[out]  ptr_Lib_row  the row indices of the Laplacian matrix;    Lib part; pointer-to-pointer.
 /// @param[out]  ptr_Lib_col  the column indices of the Laplacian matrix; Lib part; pointer-to-pointer.
 ///
-/// @note  The arrays are allocated by this routine (using new).
+/// @note  The arrays are allocated by this routine (using new, or taken from out).
 ///
 void constructLaplacianSparse( const Method method, const int nv, const int nb, const int nf, const double *V, const int *F,
                                double **ptr_Lii_val, int **ptr_Lii_row, int **ptr_Lii_col,
-                               double **ptr_Lib_val, int **ptr_Lib_row, int **ptr_Lib_col);
+                               double **ptr_Lib_val, int **ptr_Lib_row, int **ptr_Lib_col,
+                               Workspace *work = nullptr, Workspace *out = nullptr, const double *W = nullptr );
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Solve the harmonic problem. (sparse version)
+/// @brief  Compute the cotangent weights of the edges of some faces. (sparse version)
 ///
+/// @param[in]   nv     the number of vertices.
+/// @param[in]   nf     the number of faces.
+/// @param[in]   V      the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   F      the faces; nf by 3 matrix.
+/// @param[in]   begin  the first face.
+/// @param[in]   end    the last face plus one.
+///
+/// @param[out]  W      the weights of the edges of the faces [begin, end); nf by 3 matrix. The k-th column holds the
+///                     weight of the edge from the k-th vertex of a face to the next one.
+///
+/// @note  The weights do not depend on the order of vertices, so that they can be computed before reorderVertex.
+///
+void cotangentWeightSparse( const int nv, const int nf, const double *V, const int *F, const int begin, const int end,
+                            double *W );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Reads the object file into given arrays, computing the edge data while reading. (sparse version)
+///
+/// The parser hands the faces over in batches through a bounded lock-free queue; the other threads of the pool compute
+/// the edge keys and the cotangent weights of each batch while the parsing goes on.
+///
+/// @param[in]   input  the path to the object file.
+/// @param[in]   nv     the number of vertices; see scanObject.
+/// @param[in]   nf     the number of faces;    see scanObject.
+///
+/// @param[out]  V      the coordinate of vertices;      nv by 3 matrix.
+/// @param[out]  C      the color (RGB) of the vertices; nv by 3 matrix.
+/// @param[out]  F      the faces;                       nf by 3 matrix.
+/// @param[out]  E      the keys of the edges;           nf by 3 matrix; see edgeKeySparse.
+/// @param[out]  W      the cotangent weights of the edges; nf by 3 matrix; see cotangentWeightSparse. (ignored if null)
+///
+/// @note  The output arrays should be allocated before calling this routine.
+///
+void streamObjectSparse( const char *input, const int nv, const int nf, double *V, double *C, int *F, uint64_t *E,
+                         double *W );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Update the Laplacian after moving some vertices. (sparse version)
+///
+/// @param[in]   method   the method of Laplacian construction.
 /// @param[in]   nv       the number of vertices.
-/// @param[in]   nb       the number of boundary vertices.
+/// @param[in]   nb       the number of boundary.
+/// @param[in]   nf       the number of faces.
+/// @param[in]   V0       the coordinate of vertices the Laplacian was built from; nv by 3 matrix.
+/// @param[in]   V        the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   F        the faces; nf by 3 matrix.
+/// @param[in]   nm       the number of moved vertices.
+/// @param[in]   moved    the indices of moved vertices (zero-based); nm by 1 vector.
 /// @param[in]   Lii_val  the values of the Laplacian matrix;         Lii part.
 /// @param[in]   Lii_row  the row indices of the Laplacian matrix;    Lii part.
 /// @param[in]   Lii_col  the column indices of the Laplacian matrix; Lii part.
 /// @param[in]   Lib_val  the values of the Laplacian matrix;         Lib part.
 /// @param[in]   Lib_row  the row indices of the Laplacian matrix;    Lib part.
 /// @param[in]   Lib_col  the column indices of the Laplacian matrix; Lib part.
-/// @param[in]   U        the coordinate of vertices on the disk; nv by 2 matrix. The first nb vertices are given.
 ///
-/// @param[out]  U        the coordinate of vertices on the disk; nv by 2 matrix. The last (nv-nb) vertices are replaced.
+/// @param[out]  Lii_val  replaced by the updated values; Lii part.
+/// @param[out]  Lib_val  replaced by the updated values; Lib part.
+///
+/// @note  Only the weights of the faces incident to the moved vertices are recomputed.
+///
+void updateLaplacianSparse( const Method method, const int nv, const int nb, const int nf,
+                            const double *V0, const double *V, const int *F, const int nm, const int *moved,
+                            double *Lii_val, const int *Lii_row, const int *Lii_col,
+                            double *Lib_val, const int *Lib_row, const int *Lib_col );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem. (sparse version)
+///
+/// @param[in]   nv         the number of vertices.
+/// @param[in]   nb         the number of boundary vertices.
+/// @param[in]   Lii_val    the values of the Laplacian matrix;         Lii part.
+/// @param[in]   Lii_row    the row indices of the Laplacian matrix;    Lii part.
+/// @param[in]   Lii_col    the column indices of the Laplacian matrix; Lii part.
+/// @param[in]   Lib_val    the values of the Laplacian matrix;         Lib part.
+/// @param[in]   Lib_row    the row indices of the Laplacian matrix;    Lib part.
+/// @param[in]   Lib_col    the column indices of the Laplacian matrix; Lib part.
+/// @param[in]   U          the coordinate of vertices on the disk; nv by 2 matrix. The first nb vertices are given.
+/// @param[in]   U0         the initial guess of the coordinate of vertices on the disk; nv by 2 matrix.
+///                         Only the last (nv-nb) vertices are used. Starts from zero if null.
+/// @param[in]   options    the solver options. The monitor is called with rhs the coordinate (0 or 1).
+///
+/// @param[out]  U          the coordinate of vertices on the disk; nv by 2 matrix. The last (nv-nb) vertices are replaced.
+/// @param[out]  info       the solving information; pointer. (ignored if null)
 ///
 /// @note  The output arrays should be allocated before calling this routine.
+/// @note  The backend is options.solver; by default the native Cholesky backend with a cache or Precision::MIXED,
+///        and the native conjugate gradient backend otherwise. Throws HarmonicError (UNAVAILABLE) if the backend is not
+///        available, or if Precision::MIXED is given to a backend without a mixed precision path; see SparseBackend.
+/// @note  Direct solvers ignore the initial guess.
+/// @note  With a cache, the native Cholesky backend factorizes Lii (banded, after reverse Cuthill-McKee). If Lii
+///        differs from the cached one in a few entries, the cached factor is updated by rank-one modifications.
+/// @note  With Precision::MIXED, Lii is factorized in single precision and the solution is refined against Lii in
+///        double precision; if the refinement stagnates, Lii is refactorized in double precision. The native Cholesky
+///        backend then factorizes Lii (banded) without the cache.
 ///
 void solveHarmonicSparse( const int nv, const int nb,
                           const double *Lii_val, const int *Lii_row, const int *Lii_col,
                           const double *Lib_val, const int *Lib_row, const int *Lib_col,
-                          double *U );
+                          double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using the native conjugate gradient methods. See solveHarmonicSparse.
+///
+void solveHarmonicSparseCg( const int nv, const int nb,
+                            const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                            const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                            double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using the native band Cholesky factorization. See solveHarmonicSparse.
+///
+void solveHarmonicSparseCholesky( const int nv, const int nb,
+                                  const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                                  const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                                  double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using MKL (PARDISO). See solveHarmonicSparse.
+///
+void solveHarmonicSparseMkl( const int nv, const int nb,
+                             const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                             const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                             double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using MAGMA (conjugate gradient on GPU). See solveHarmonicSparse.
+///
+void solveHarmonicSparseMagma( const int nv, const int nb,
+                               const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                               const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                               double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The sparse solver; see solveHarmonicSparse.
+///
+using SparseSolver = void (*)( const int nv, const int nb,
+                               const double *Lii_val, const int *Lii_row, const int *Lii_col,
+                               const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                               double *U, const double *U0, const SolveOptions &options, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A sparse solver backend.
+///
+struct SparseBackend {
+  const char   *name;         ///< the name; the value of --solver.
+  const char   *description;  ///< the description.
+  SparseSolver  solve;        ///< the solver.
+  bool          mixed;        ///< whether Precision::MIXED is supported.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Find a sparse solver backend.
+///
+/// @param[in]   name  the name of the backend.
+///
+/// @return  the backend; null if not available.
+///
+/// @note  The dense backends are also available (prefixed by "dense-"); Lii and Lib are expanded to a dense matrix.
+///
+const SparseBackend *findSparseBackend( const char *name );
+
+/// @brief  The name of the backend solveHarmonicSparse uses with the options; options.solver if not null.
+const char *sparseBackendName( const SolveOptions &options );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  List the sparse solver backends compiled in.
+///
+/// @param[out]  ptr_backend  the backends; pointer.
+///
+/// @return  the number of backends.
+///
+int listSparseBackends( const SparseBackend **ptr_backend );
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Solve eigenvalue near mu0 on host.
 ///
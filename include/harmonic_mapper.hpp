@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    harmonic_mapper.hpp
+/// @brief   The reusable harmonic mapper header. (sparse version)
+///
+
+#ifndef SCSC_HARMONIC_MAPPER_HPP
+#define SCSC_HARMONIC_MAPPER_HPP
+
+#include <harmonic.hpp>
+#include <workspace.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The harmonic mapping pipeline of a mesh. (sparse version)
+///
+/// The mapper owns the mesh, its boundary, the Laplacian, the solution, and the scratch of every stage. The stages are
+/// run in order: load (or setMesh or generate), verifyBoundary, reorderVertex, constructLaplacian, mapBoundary, solve,
+/// and write.
+///
+/// All buffers are kept in workspaces between meshes, so that mapping many meshes of the same sizes with one mapper
+/// takes no heap allocation after the first one (except for the cache and the initial guess).
+///
+/// Every stage runs in its own scope of the scratch workspace: it starts empty and is released in bulk when the stage
+/// returns. The high-water mark of each stage is kept; see highWater.
+///
+/// A stage that fails throws HarmonicError; its scratch is released on the way out, and the mapper can load the next
+/// mesh. The stages keep no process-wide state, so that the mappers of many meshes can run in threads of one process,
+/// sharing the thread pool. (The profiler, the statistics, and the selected instruction set are process-wide.)
+///
+/// @note  A mapper is not thread-safe; use one mapper per thread.
+///
+class HarmonicMapper {
+
+ public:
+
+  /// The stages that use the scratch workspace.
+  enum class Stage {
+    VERIFY    = 0,  ///< verifyBoundary.
+    REORDER   = 1,  ///< reorderVertex.
+    LAPLACIAN = 2,  ///< constructLaplacian.
+    SOLVE     = 3,  ///< solve.
+    WRITE     = 4,  ///< write.
+    COUNT,          ///< Used for counting number of stages.
+  };
+
+  HarmonicMapper();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Load the mesh from an object file.
+  ///
+  /// @param[in]   input  the path to the object file.
+  ///
+  void load( const char *input );
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Load the mesh from an object file, computing the edge data while reading; see streamObjectSparse.
+  ///
+  /// @param[in]   input   the path to the object file.
+  /// @param[in]   method  the method of Laplacian construction; the cotangent weights are computed for COTANGENT.
+  ///
+  /// @note  verifyBoundary and constructLaplacian use the edge data instead of computing it.
+  ///
+  void stream( const char *input, const Method method );
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Copy the mesh.
+  ///
+  /// @param[in]   nv  the number of vertices.
+  /// @param[in]   nf  the number of faces.
+  /// @param[in]   V   the coordinate of vertices;      nv by 3 matrix.
+  /// @param[in]   C   the color (RGB) of the vertices; nv by 3 matrix.
+  /// @param[in]   F   the faces;                       nf by 3 matrix.
+  ///
+  void setMesh( const int nv, const int nf, const double *V, const double *C, const int *F );
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Generate the mesh in place; see generateMesh.
+  ///
+  /// @param[in]   shape    the shape of the mesh.
+  /// @param[in]   n        the number of cells per side.
+  /// @param[in]   seed     the random seed.
+  /// @param[in]   shuffle  whether to shuffle the order of vertices.
+  ///
+  void generate( const MeshShape shape, const int n, const uint64_t seed, const bool shuffle );
+
+  /// @brief  Find the boundary of the mesh; see verifyBoundarySparse.
+  void verifyBoundary();
+
+  /// @brief  Move the boundary vertices to the front; see reorderVertex.
+  void reorderVertex();
+
+  /// @brief  The new index of each vertex of the loaded mesh; nv by 1 vector. (after reorderVertex)
+  void vertexOrder( int *order ) const;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Construct the Laplacian; see constructLaplacianSparse.
+  ///
+  /// @param[in]   method  the method of Laplacian construction.
+  /// @param[in]   cache   the cache key; see initFactorCache. (ignored if null)
+  ///
+  /// @note  If the cache holds the Laplacian of the same topology, only the weights around the moved vertices are
+  ///        recomputed; see updateLaplacianSparse.
+  ///
+  void constructLaplacian( const Method method, const FactorCache *cache = nullptr );
+
+  /// @brief  Store the Laplacian in the cache; see storeLaplacianCache.
+  void storeLaplacian( const FactorCache *cache ) const;
+
+  /// @brief  Map the boundary vertices to the unit circle; see mapBoundary.
+  void mapBoundary();
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Solve the harmonic problem; see solveHarmonicSparse.
+  ///
+  /// @param[in]   options  the solver options; the scratch of the mapper is used if options.work is null.
+  /// @param[in]   U0       the initial guess of iterative solvers; nv by 2 matrix. (ignored if null)
+  ///
+  /// @param[out]  info     the solver information; pointer. (ignored if null)
+  ///
+  void solve( const SolveOptions &options, const double *U0 = nullptr, SolveInfo *info = nullptr );
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Solve the harmonic problem into a given array; see solveHarmonicSparse.
+  ///
+  /// @param[in]   options  the solver options; the scratch of the mapper is used if options.work is null.
+  /// @param[in]   U0       the initial guess of iterative solvers; nv by 2 matrix. (ignored if null)
+  /// @param[in]   U        the boundary part set; nv by 2 matrix.
+  ///
+  /// @param[out]  U        the coordinate of vertices on the disk; nv by 2 matrix.
+  /// @param[out]  info     the solver information; pointer. (ignored if null)
+  ///
+  void solve( const SolveOptions &options, const double *U0, double *U, SolveInfo *info );
+
+  /// @brief  Write the mapped mesh; see writeObject.
+  void write( const char *output );
+
+  int           nv() const     { return nv_; }      ///< the number of vertices.
+  int           nf() const     { return nf_; }      ///< the number of faces.
+  int           nb() const     { return nb_; }      ///< the number of boundary vertices.
+  int           nmoved() const { return nm_; }      ///< the number of moved vertices of a cached Laplacian; -1 if none.
+  const double *V() const      { return V_; }       ///< the coordinate of vertices;      nv by 3 matrix.
+  const double *C() const      { return C_; }       ///< the color (RGB) of the vertices; nv by 3 matrix.
+  const int    *F() const      { return F_; }       ///< the faces;                       nf by 3 matrix.
+  const double *U() const      { return U_; }       ///< the coordinate of vertices on the disk; nv by 2 matrix.
+  long          nnzLii() const { return Lii_row_[nv_-nb_]; }  ///< the nonzeros of Lii; after constructLaplacian.
+  long          nnzLib() const { return Lib_row_[nv_-nb_]; }  ///< the nonzeros of Lib; after constructLaplacian.
+
+  /// @brief  The bandwidth of Lii in the vertex order; after constructLaplacian.
+  int bandwidth() const;
+
+  /// @brief  The scratch high-water mark of the last run of a stage, in bytes.
+  size_t highWater( const Stage stage ) const { return peak_[static_cast<int>(stage)]; }
+
+  /// @brief  The memory held by the mesh, the Laplacian, the solution, and the scratch, in bytes.
+  size_t capacity() const { return mesh_.capacity() + lap_.capacity() + sol_.capacity() + scratch_.capacity(); }
+
+ private:
+
+  int       nv_, nf_, nb_, nm_;
+  double   *V_, *C_, *U_;
+  int      *F_, *idx_b_;
+  uint64_t *E_;  // the streamed edge keys; null once used
+  double   *W_;  // the streamed cotangent weights; null if none
+  double   *Lii_val_, *Lib_val_;
+  int      *Lii_row_, *Lii_col_, *Lib_row_, *Lib_col_;
+
+  Workspace mesh_;     // V, C, F, idx_b, and the streamed edge data
+  Workspace lap_;      // the Laplacian
+  Workspace sol_;      // U
+  Workspace scratch_;  // the temporaries of a stage; empty between stages
+  size_t    peak_[static_cast<int>(Stage::COUNT)];  // the scratch high-water mark of each stage
+
+};
+
+#endif  // SCSC_HARMONIC_MAPPER_HPP
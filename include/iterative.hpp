@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    iterative.hpp
+/// @brief   The iterative solver header.
+///
+
+#ifndef SCSC_ITERATIVE_HPP
+#define SCSC_ITERATIVE_HPP
+
+#include <functional>
+
+class Workspace;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The preconditioner; computes z := inv(M) * r.
+///
+/// @param[in]   r  the residual; n by 1 vector.
+///
+/// @param[out]  z  the preconditioned residual; n by 1 vector.
+///
+using Preconditioner = std::function<void( const double *r, double *z )>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The convergence record of one iteration.
+///
+struct IterationInfo {
+  int    rhs;           ///< the index of the right-hand side; set by the caller of the solver.
+  int    iter;          ///< the number of iterations; 0 for the initial residual.
+  double res;           ///< the relative residual (as tracked by the solver).
+  double time;          ///< the elapsed time of the solver, in seconds.
+  double time_precond;  ///< the time of preconditioner applications since the previous record, in seconds.
+  double time_spmv;     ///< the time of matrix-vector multiplications since the previous record, in seconds.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The iteration monitor; called with the initial residual and after every iteration (every step of s-step
+///         solvers).
+///
+/// @param[in]   info  the convergence record.
+///
+/// @return  false to stop the solver early.
+///
+using Monitor = std::function<bool( const IterationInfo &info )>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Sparse matrix-vector multiplication; y := A * x.
+///
+/// @param[in]   n      the number of rows of A.
+/// @param[in]   A_val  the values of A;         CSR format.
+/// @param[in]   A_row  the row pointers of A;   CSR format.
+/// @param[in]   A_col  the column indices of A; CSR format.
+/// @param[in]   x      the input vector.
+///
+/// @param[out]  y      the output vector; n by 1 vector.
+///
+void spmvSparse( const int n, const double *A_val, const int *A_row, const int *A_col, const double *x, double *y );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve A * x = b using the preconditioned conjugate gradient method.
+///
+/// @param[in]   n        the size of A.
+/// @param[in]   A_val    the values of A;         CSR format.
+/// @param[in]   A_row    the row pointers of A;   CSR format.
+/// @param[in]   A_col    the column indices of A; CSR format.
+/// @param[in]   b        the right-hand side; n by 1 vector.
+/// @param[in]   x        the initial guess;   n by 1 vector.
+/// @param[in]   precond  the preconditioner.
+/// @param[in]   tol      the tolerance of the relative residual.
+/// @param[in]   maxit    the maximum number of iterations.
+/// @param[in]   monitor  the iteration monitor. (ignored if empty)
+/// @param[in]   work     the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @param[out]  x        replaced by the solution.
+/// @param[out]  ptr_res  the final relative residual; pointer. (ignored if null)
+///
+/// @return  the number of iterations.
+///
+/// @note  A must be symmetric positive definite.
+///
+int solvePcgSparse( const int n, const double *A_val, const int *A_row, const int *A_col, const double *b, double *x,
+                    const Preconditioner &precond, const double tol, const int maxit, const Monitor &monitor,
+                    double *ptr_res, Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve A * x = b using the pipelined preconditioned conjugate gradient method (Ghysels & Vanroose).
+///
+/// @param[in]   n        the size of A.
+/// @param[in]   A_val    the values of A;         CSR format.
+/// @param[in]   A_row    the row pointers of A;   CSR format.
+/// @param[in]   A_col    the column indices of A; CSR format.
+/// @param[in]   b        the right-hand side; n by 1 vector.
+/// @param[in]   x        the initial guess;   n by 1 vector.
+/// @param[in]   precond  the preconditioner.
+/// @param[in]   tol      the tolerance of the relative residual.
+/// @param[in]   maxit    the maximum number of iterations.
+/// @param[in]   monitor  the iteration monitor. (ignored if empty)
+/// @param[in]   work     the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @param[out]  x        replaced by the solution.
+/// @param[out]  ptr_res  the final relative residual; pointer. (ignored if null)
+///
+/// @return  the number of iterations.
+///
+/// @note  A must be symmetric positive definite.
+/// @note  The three inner products of an iteration are fused into the sweep of the vector updates, and their reduction
+///        is not needed until after the next preconditioner application and matrix-vector multiplication.
+/// @note  The residual is updated by recurrence. Once it meets tol, the residual is recomputed from x, and the iteration
+///        restarts from it unless it meets tol too or no longer decreases; the returned residual is recomputed from x.
+///
+int solvePipelinedPcgSparse( const int n, const double *A_val, const int *A_row, const int *A_col, const double *b,
+                             double *x, const Preconditioner &precond, const double tol, const int maxit,
+                             const Monitor &monitor, double *ptr_res, Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve A * x = b using the s-step preconditioned conjugate gradient method.
+///
+/// @param[in]   n        the size of A.
+/// @param[in]   A_val    the values of A;         CSR format.
+/// @param[in]   A_row    the row pointers of A;   CSR format.
+/// @param[in]   A_col    the column indices of A; CSR format.
+/// @param[in]   b        the right-hand side; n by 1 vector.
+/// @param[in]   x        the initial guess;   n by 1 vector.
+/// @param[in]   precond  the preconditioner.
+/// @param[in]   s        the number of iterations per step.
+/// @param[in]   tol      the tolerance of the relative residual.
+/// @param[in]   maxit    the maximum number of iterations.
+/// @param[in]   monitor  the iteration monitor. (ignored if empty)
+/// @param[in]   work     the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @param[out]  x        replaced by the solution.
+/// @param[out]  ptr_res  the final relative residual; pointer. (ignored if null)
+///
+/// @return  the number of iterations; s per step.
+///
+/// @note  A must be symmetric positive definite.
+/// @note  Each step builds a Chebyshev basis of s Krylov vectors of inv(M) * A (assuming its spectrum lies in [0, 2],
+///        as with the Jacobi preconditioner of a diagonally dominant A), makes it A-orthogonal to the previous step,
+///        and minimizes the error over it; all inner products of a step share one reduction.
+/// @note  The residual is updated by recurrence. Once it meets tol, the residual is recomputed from x, and the iteration
+///        restarts from it unless it meets tol too or no longer decreases; the returned residual is recomputed from x.
+///
+int solveSstepPcgSparse( const int n, const double *A_val, const int *A_row, const int *A_col, const double *b,
+                         double *x, const Preconditioner &precond, const int s, const double tol, const int maxit,
+                         const Monitor &monitor, double *ptr_res, Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Compute the relative residual; ||b - A * x|| / ||b||.
+///
+/// @param[in]   n      the size of A.
+/// @param[in]   A_val  the values of A;         CSR format.
+/// @param[in]   A_row  the row pointers of A;   CSR format.
+/// @param[in]   A_col  the column indices of A; CSR format.
+/// @param[in]   b      the right-hand side; n by 1 vector.
+/// @param[in]   x      the solution;        n by 1 vector.
+/// @param[in]   work   the scratch workspace; see workspace.hpp. (a local one if null)
+///
+/// @return  the relative residual.
+///
+double residualSparse( const int n, const double *A_val, const int *A_row, const int *A_col, const double *b, const double *x,
+                       Workspace *work = nullptr );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Write the convergence history.
+///
+/// @param[in]   path     the path to the output file; written as JSON if it ends with ".json", otherwise as CSV.
+/// @param[in]   n        the number of records.
+/// @param[in]   history  the convergence records; n by 1 vector.
+///
+/// @return  true if the file is written.
+///
+bool writeConvergence( const char *path, const int n, const IterationInfo *history );
+
+#endif  // SCSC_ITERATIVE_HPP
@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    memory_tracker.hpp
+/// @brief   The memory tracker header.
+///
+
+#ifndef SCSC_MEMORY_TRACKER_HPP
+#define SCSC_MEMORY_TRACKER_HPP
+
+/// @brief  The memory use of the process, in bytes; negative if not available.
+struct MemorySample {
+  double live;      ///< the live bytes allocated by new and by the workspaces
+  double peak;      ///< the peak of the live bytes since the last reset
+  double rss;       ///< the resident set size
+  double peak_rss;  ///< the peak of the sampled resident set size since the last reset
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start sampling the resident set size in a background thread.
+///
+/// @return  whether the live bytes are tracked. (They need a build with SCSC_TRACK_NEW and glibc.)
+///
+/// @note  The live bytes are counted from the start of the program; the RSS catches what new does not see, such as the
+///        buffers of external libraries.
+///
+bool startMemoryTracking();
+
+/// @brief  Stop sampling; waits for the sampling thread.
+void stopMemoryTracking();
+
+/// @brief  Whether the memory is tracked.
+bool memoryTracking();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Count memory allocated outside new, such as mapped pages.
+///
+/// @param[in]   bytes  the allocated bytes; negative when freed.
+///
+void trackMemory( const long bytes );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Read the memory use.
+///
+/// @param[out]  sample  the memory use.
+/// @param[in]   reset   whether to restart the peaks from the current use. (e.g. at the start of a stage)
+///
+void readMemory( MemorySample &sample, const bool reset = false );
+
+#endif  // SCSC_MEMORY_TRACKER_HPP
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    mesh_service.hpp
+/// @brief   The resident mesh service header. (sparse version)
+///
+
+#ifndef SCSC_MESH_SERVICE_HPP
+#define SCSC_MESH_SERVICE_HPP
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <harmonic.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A request to map a mesh.
+///
+struct MapRequest {
+  const char   *input   = nullptr;             ///< the path to the object file; null if the mesh is given below.
+  const char   *output  = nullptr;             ///< the path of the mapped mesh, written by the service; null to return U.
+  int           nv      = 0;                   ///< the number of vertices of the given mesh.
+  int           nf      = 0;                   ///< the number of faces of the given mesh.
+  const double *V       = nullptr;             ///< the coordinate of vertices of the given mesh; nv by 3 matrix.
+  const int    *F       = nullptr;             ///< the faces of the given mesh; nf by 3 matrix.
+  Method        method  = Method::KIRCHHOFF;   ///< the method of Laplacian construction.
+  SolveOptions  options;                       ///< the solver options; the cache key, monitor, and workspace are unused.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The information of a mapped mesh.
+///
+struct MapReply {
+  int       nv;        ///< the number of vertices.
+  SolveInfo info;      ///< the solver information.
+  bool      warm;      ///< whether the mesh, its boundary, and its Laplacian were cached.
+  bool      factored;  ///< whether the factorization of Lii was cached. (direct solvers)
+  double    time;      ///< the time of the request in the service, in seconds.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The resident mesh service.
+///
+/// The service keeps the meshes it has mapped, each in a HarmonicMapper after constructLaplacian (the parsed mesh, its
+/// boundary and vertex order, and the Laplacian), together with the factorization of Lii of the direct solvers; see
+/// FactorMemory. A request of a cached mesh only solves, or only solves with the cached factor.
+///
+/// A mesh given by path is keyed by its real path, size, and modification time; a mesh given inline by its hash. The
+/// method of Laplacian construction is part of the key.
+///
+/// The meshes are evicted in least-recently-used order once the memory they hold (see HarmonicMapper::capacity) exceeds
+/// the budget.
+///
+/// @note  map is thread-safe. The requests of different meshes run concurrently, sharing the thread pool; the requests
+///        of the same mesh run one at a time.
+///
+class MeshService {
+
+ public:
+
+  /// @brief  Create the service with a memory budget, in bytes.
+  explicit MeshService( const size_t budget );
+
+  ~MeshService();
+  MeshService( const MeshService& ) = delete;
+  MeshService &operator=( const MeshService& ) = delete;
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// @brief  Map a mesh.
+  ///
+  /// @param[in]   request  the request.
+  ///
+  /// @param[out]  U        the coordinate of vertices on the disk, in the vertex order of the mesh; nv by 2 matrix.
+  ///                       (empty if request.output is given)
+  /// @param[out]  reply    the information of the mapped mesh; pointer.
+  ///
+  /// @note  Throws HarmonicError if the mesh can not be mapped; the mesh is not cached then.
+  /// @note  The mapped mesh is written as by HarmonicMapper::write, in the vertex order of the mapper.
+  ///
+  void map( const MapRequest &request, std::vector<double> &U, MapReply *reply );
+
+  int    size() const;                                ///< the number of cached meshes.
+  size_t bytes() const;                               ///< the memory held by the cached meshes, in bytes.
+  size_t budget() const { return budget_; }           ///< the memory budget, in bytes.
+  long   hits() const   { return hits_.load(); }      ///< the number of requests of cached meshes.
+  long   misses() const { return misses_.load(); }    ///< the number of requests of new meshes.
+
+ private:
+
+  struct Entry;
+  typedef std::list<std::shared_ptr<Entry>> List;
+
+  // Find or insert the entry of a key, as the most recently used one
+  std::shared_ptr<Entry> acquire( const std::string &key, bool *found );
+
+  // Update the memory of an entry, and evict the least recently used entries over the budget
+  void account( const std::shared_ptr<Entry> &entry );
+
+  // Remove an entry that failed
+  void discard( const std::shared_ptr<Entry> &entry );
+
+  size_t                                          budget_;
+  size_t                                          bytes_;   // the memory held by the entries in lru_
+  List                                            lru_;     // the most recently used first
+  std::unordered_map<std::string, List::iterator> index_;   // the entries in lru_ by key
+  mutable std::mutex                              lock_;    // guards bytes_, lru_, and index_
+  std::atomic<long>                               hits_;
+  std::atomic<long>                               misses_;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Serve the requests sent to a Unix domain socket until SIGINT or SIGTERM.
+///
+/// @param[in]   path     the path of the socket; replaced if it exists, and removed on return.
+/// @param[in]   service  the service.
+///
+/// @note  Each connection is served by a thread, one request after another. A request is a text line followed by the
+///        mesh if given inline, in the byte order of the host:
+///
+///            map method=<0|1> solver=<name> precond=<0|1> tol=<num> precision=<0|1> krylov=<0|1|2> file=<path>\n
+///            map method=<0|1> ... nv=<nv> nf=<nf>\n  V (3*nv doubles)  F (3*nf 32-bit ints, from 1)
+///            stats\n
+///
+///        The solver options may be omitted. With output=1 before file= (or nv=), the next line is the path of the
+///        mapped mesh, written by the service. An inline mesh larger than the budget is refused, and the connection
+///        closed. The reply is a text line, followed by U (2*nv doubles) on success unless the service wrote it:
+///
+///            ok nv=<nv> iter=<num> res=<num> mesh=<warm|cold> factor=<warm|cold> time=<seconds>\n
+///            ok meshes=<num> bytes=<num> budget=<num> hits=<num> misses=<num>\n
+///            error <io|format|numeric|unavailable|internal> <message>\n
+///
+void serveMeshes( const char *path, MeshService &service );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Send a request to the service on a Unix domain socket; see serveMeshes.
+///
+/// @param[in]   path     the path of the socket.
+/// @param[in]   request  the request; relative paths are resolved by the service, in its working directory.
+///
+/// @param[out]  U        the coordinate of vertices on the disk, in the vertex order of the mesh; nv by 2 matrix.
+///                       (empty if request.output is given)
+/// @param[out]  reply    the information of the mapped mesh; pointer.
+///
+/// @note  Throws HarmonicError with the error of the service, or IO if the service can not be reached.
+///
+void requestMap( const char *path, const MapRequest &request, std::vector<double> &U, MapReply *reply );
+
+#endif  // SCSC_MESH_SERVICE_HPP
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    multigrid.hpp
+/// @brief   The geometric multigrid header.
+///
+
+#ifndef SCSC_MULTIGRID_HPP
+#define SCSC_MULTIGRID_HPP
+
+#include <harmonic.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  One level of the multigrid hierarchy.
+///
+/// @note  The level operator of the finest level is borrowed from the caller.
+///
+struct MultigridLevel {
+  int           nv;      ///< the number of vertices of the level mesh.
+  int           ni;      ///< the number of interior vertices of the level mesh.
+  int           nf;      ///< the number of faces of the level mesh.
+
+  const double *A_val;   ///< the values of the Lii part of the level Laplacian;         CSR format.
+  const int    *A_row;   ///< the row pointers of the Lii part of the level Laplacian;   CSR format.
+  const int    *A_col;   ///< the column indices of the Lii part of the level Laplacian; CSR format.
+  int          *A_diag;  ///< the positions of the diagonal entries in A_val; ni by 1 vector.
+
+  double       *P_val;   ///< the values of the prolongation from the next coarser level;         CSR format.
+  int          *P_row;   ///< the row pointers of the prolongation from the next coarser level;   CSR format.
+  int          *P_col;   ///< the column indices of the prolongation from the next coarser level; CSR format.
+
+  double       *b;       ///< the workspace of the right-hand side; ni by 1 vector.
+  double       *x;       ///< the workspace of the correction;      ni by 1 vector.
+  double       *r;       ///< the workspace of the residual;        ni by 1 vector.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The multigrid hierarchy.
+///
+struct Multigrid {
+  int             nlevel;  ///< the number of levels.
+  MultigridLevel *level;   ///< the levels, from the finest to the coarsest; nlevel by 1 vector.
+  double         *coarse;       ///< the Cholesky factor of the coarsest level operator; dense (ni by ni), or band.
+  int             coarse_bw;    ///< the bandwidth of the band factor; -1 if dense.
+  int            *coarse_perm;  ///< the ordering of the band factor; ni by 1 vector. (null if dense)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Construct the multigrid hierarchy by edge-collapse decimation.
+///
+/// @param[in]   method   the method of Laplacian construction.
+/// @param[in]   nv       the number of vertices.
+/// @param[in]   nb       the number of boundary vertices.
+/// @param[in]   nf       the number of faces.
+/// @param[in]   V        the coordinate of vertices; nv by 3 matrix.
+/// @param[in]   F        the faces; nf by 3 matrix.
+/// @param[in]   Lii_val  the values of the Laplacian matrix;         Lii part.
+/// @param[in]   Lii_row  the row indices of the Laplacian matrix;    Lii part.
+/// @param[in]   Lii_col  the column indices of the Laplacian matrix; Lii part.
+///
+/// @param[out]  mg       the multigrid hierarchy.
+///
+/// @note  The vertices should be reordered so that the first nb vertices are the boundary vertices.
+///        Only interior vertices are collapsed, hence the boundary loop is kept on every level.
+///        The Laplacian of each coarser level is rebuilt by constructLaplacianSparse.
+/// @note  If the decimation stalls early, the coarsest level may be too large for a dense factor; it is then factored
+///        in band storage (see band.hpp) after reverse Cuthill-McKee ordering, and coarse_bw is set.
+/// @note  Throws HarmonicError if the coarsest level operator is not positive definite.
+///
+void constructMultigrid( const Method method, const int nv, const int nb, const int nf, const double *V, const int *F,
+                         const double *Lii_val, const int *Lii_row, const int *Lii_col, Multigrid *mg );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Solve the harmonic problem using conjugate gradient preconditioned with multigrid V-cycles.
+///
+/// @param[in]   nv        the number of vertices.
+/// @param[in]   nb        the number of boundary vertices.
+/// @param[in]   mg        the multigrid hierarchy.
+/// @param[in]   Lib_val   the values of the Laplacian matrix;         Lib part.
+/// @param[in]   Lib_row   the row indices of the Laplacian matrix;    Lib part.
+/// @param[in]   Lib_col   the column indices of the Laplacian matrix; Lib part.
+/// @param[in]   U         the coordinate of vertices on the disk; nv by 2 matrix. The first nb vertices are given.
+/// @param[in]   U0        the initial guess of the coordinate of vertices on the disk; nv by 2 matrix.
+///                        Only the last (nv-nb) vertices are used. Starts from zero if null.
+///
+/// @param[out]  U         the coordinate of vertices on the disk; nv by 2 matrix. The last (nv-nb) vertices are replaced.
+/// @param[out]  info      the solving information; pointer. (ignored if null)
+///
+void solveHarmonicMultigrid( const int nv, const int nb, Multigrid *mg,
+                             const double *Lib_val, const int *Lib_row, const int *Lib_col,
+                             double *U, const double *U0, SolveInfo *info );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Destroy the multigrid hierarchy.
+///
+/// @param[in]   mg  the multigrid hierarchy.
+///
+void destroyMultigrid( Multigrid *mg );
+
+#endif  // SCSC_MULTIGRID_HPP
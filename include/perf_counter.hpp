@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    perf_counter.hpp
+/// @brief   The hardware performance counter header.
+///
+
+#ifndef SCSC_PERF_COUNTER_HPP
+#define SCSC_PERF_COUNTER_HPP
+
+/// @brief  The counted hardware events.
+enum class PerfEvent {
+  CYCLES        = 0,  ///< CPU cycles
+  INSTRUCTIONS  = 1,  ///< retired instructions
+  LLC_MISSES    = 2,  ///< last-level cache misses
+  BRANCH_MISSES = 3,  ///< mispredicted branches
+  COUNT         = 4,
+};
+
+/// @brief  The counts of the events, summed over the attached threads; negative if an event is not available.
+struct PerfSample {
+  double count[int(PerfEvent::COUNT)];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start counting; attaches the calling thread.
+///
+/// @return  whether any event is available. (The counters need Linux perf_event_open and a hardware PMU.)
+///
+/// @note  The events are counted in user space per thread; each thread that does work must be attached.
+///
+bool startPerfCounters();
+
+/// @brief  Whether counting is started.
+bool perfCounting();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Attach the calling thread to the counters. (The thread pool attaches its workers.)
+///
+/// @note  Does nothing if counting is not started or the thread is attached.
+///
+void attachPerfCounters();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Read the counters of all attached threads.
+///
+/// @param[out]  sample  the counts; scaled if the kernel multiplexed the events.
+///
+void readPerfCounters( PerfSample &sample );
+
+/// @brief  The name of an event.
+const char *perfEventName( const PerfEvent event );
+
+#endif  // SCSC_PERF_COUNTER_HPP
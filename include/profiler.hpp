@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    profiler.hpp
+/// @brief   The scoped profiler header.
+///
+
+#ifndef SCSC_PROFILER_HPP
+#define SCSC_PROFILER_HPP
+
+#include <cstdint>
+#include <memory_tracker.hpp>
+#include <perf_counter.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The time of the monotonic clock.
+///
+/// @return  the time, in nanoseconds.
+///
+int64_t profileClock();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start recording zones.
+///
+/// @param[in]   path  the path of the trace file written by finishProfile.
+///
+/// @note  Without a call, zones are recorded if the environment variable SCSC_PROFILE is set to the path of the trace.
+/// @note  Nothing is recorded unless built with SCSC_USE_PROFILER.
+///
+void startProfile( const char *path );
+
+/// @brief  Whether zones are recorded.
+bool profiling();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start counting the hardware events and the work of each stage.
+///
+/// @param[in]   path  the CSV file the stages are appended to by finishProfile; null to only print them.
+///
+/// @note  Without a call, counting starts if the environment variable SCSC_PERF is set to 1 or to the path of the CSV.
+/// @note  Must be called before the thread pool starts; see attachPerfCounters.
+///
+void startPerfReport( const char *path );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start tracking the memory of each stage; see startMemoryTracking.
+///
+/// @note  Without a call, tracking starts if the environment variable SCSC_MEMORY is set to 1.
+///
+void startMemoryReport();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Count the work of a kernel towards the running stage; see SCSC_PROFILE_WORK.
+///
+/// @param[in]   bytes  the bytes the kernel moves from and to the memory, by a compulsory-traffic model.
+/// @param[in]   flops  the floating point operations of the kernel.
+///
+void profileWork( const double bytes, const double flops );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Stop recording; write the zones to the trace file and print a summary table.
+///
+/// The trace is in the Chrome trace event format (JSON), which chrome://tracing and Perfetto open; each thread has its
+/// own track. The table lists every zone name with its number of calls and its total time, indented by nesting.
+///
+/// If the stages are counted (see startPerfReport), also prints the roofline report: the achieved bandwidth and flop
+/// rate, the arithmetic intensity, and the hardware events of each stage. With the peaks of the machine set in
+/// SCSC_PEAK_GBS and SCSC_PEAK_GFLOPS, it also tells whether a stage is bound by the memory or by the compute, and the
+/// fraction of the roof it reaches.
+///
+/// If the memory is tracked (see startMemoryReport), also prints the peak and the retained memory of each stage, both
+/// of the live bytes and of the RSS.
+///
+/// @note  Does nothing if zones are not recorded, and stages are neither counted nor tracked.
+/// @note  Must not be called while work is running in the thread pool.
+///
+void finishProfile();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A profiling zone; records the time from construction to destruction on the calling thread.
+///
+/// Zones nest; each thread keeps its own buffer, so that recording takes no lock. Use SCSC_PROFILE_ZONE, which is
+/// compiled out without SCSC_USE_PROFILER.
+///
+class ProfileZone {
+
+ public:
+
+  /// @param[in]   name  the name of the zone; a string literal (the pointer is kept).
+  explicit ProfileZone( const char *name );
+  ~ProfileZone();
+
+  ProfileZone( const ProfileZone& ) = delete;
+  ProfileZone &operator=( const ProfileZone& ) = delete;
+
+ private:
+
+  const char *name_;
+  int64_t     begin_;  // the start time; negative if not recorded
+
+};
+
+#ifdef SCSC_USE_PROFILER
+#define SCSC_PROFILE_CONCAT_( a, b ) a##b
+#define SCSC_PROFILE_CONCAT( a, b ) SCSC_PROFILE_CONCAT_(a, b)
+/// @brief  Profile the rest of the enclosing scope; see ProfileZone.
+#define SCSC_PROFILE_ZONE( name ) ProfileZone SCSC_PROFILE_CONCAT(scsc_profile_zone_, __LINE__)(name)
+/// @brief  Count the work of a kernel; see profileWork.
+#define SCSC_PROFILE_WORK( bytes, flops ) profileWork(bytes, flops)
+#else  // SCSC_USE_PROFILER
+#define SCSC_PROFILE_ZONE( name ) static_cast<void>(0)
+#define SCSC_PROFILE_WORK( bytes, flops ) static_cast<void>(sizeof((bytes) + (flops)))
+#endif  // SCSC_USE_PROFILER
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  A stage of a main program; prints its label and elapsed time, and records a zone.
+///
+/// The output is "<label> ......... Done.  Elapsed time is <time> seconds.", the label padded with dots to 40 columns.
+/// If the stages are counted (see startPerfReport), the achieved GB/s and GFLOP/s and the hardware events follow.
+/// If the statistics are collected (see startStats), the time is kept for them.
+///
+class ProfileStage {
+
+ public:
+
+  /// @param[in]   print  whether to print the label and the time. (e.g. only on one MPI rank)
+  explicit ProfileStage( const bool print = true );
+
+  /// @brief  Start a stage at once; see start.
+  explicit ProfileStage( const char *label, const bool print = true );
+
+  /// @brief  Stop the stage if running; see stop. While an exception unwinds, the stage prints "Failed." instead, and
+  ///         its time is neither counted nor kept for the statistics.
+  ~ProfileStage();
+
+  ProfileStage( const ProfileStage& ) = delete;
+  ProfileStage &operator=( const ProfileStage& ) = delete;
+
+  /// @brief  Start a stage; the previous one must be stopped.
+  ///
+  /// @param[in]   label  the label of the stage; a string literal (the pointer is kept).
+  ///
+  void start( const char *label );
+
+  /// @brief  Stop the stage.
+  ///
+  /// @return  the elapsed time, in seconds.
+  ///
+  double stop();
+
+ private:
+
+  // End a stage that failed
+  void fail();
+
+  const char *label_;     // the label; null if stopped
+  bool        print_;
+  bool        recorded_;  // whether the stage is recorded as a zone
+  bool        counted_;   // whether the stage is counted or tracked
+  int64_t     begin_;
+  double      bytes_;     // the work counted before the stage
+  double      flops_;
+  PerfSample   perf_;     // the events counted before the stage
+  MemorySample mem_;      // the memory use before the stage
+
+};
+
+#endif  // SCSC_PROFILER_HPP
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    run_stats.hpp
+/// @brief   The machine-readable run statistics header.
+///
+
+#ifndef SCSC_RUN_STATS_HPP
+#define SCSC_RUN_STATS_HPP
+
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The characteristics of a run; negative (or null) if not known.
+///
+struct RunStats {
+  const char *input       = nullptr;  ///< the input file.
+  const char *method      = nullptr;  ///< the method of Laplacian construction.
+  const char *solver      = nullptr;  ///< the solver backend.
+  int         nv          = -1;       ///< the number of vertices.
+  int         nf          = -1;       ///< the number of faces.
+  int         nb          = -1;       ///< the number of boundary vertices.
+  long        nnz_lii     = -1;       ///< the nonzeros of Lii.
+  long        nnz_lib     = -1;       ///< the nonzeros of Lib.
+  int         bw          = -1;       ///< the bandwidth of Lii in the vertex order.
+  int         factor_bw   = -1;       ///< the bandwidth of Lii in the ordering of the factorization.
+  long        nnz_factor  = -1;       ///< the nonzeros of the factor of Lii.
+  int         iter        = -1;       ///< the number of iterations of both coordinates.
+  double      res         = -1.0;     ///< the final relative residual.
+  double      held        = -1.0;     ///< the memory held by the buffers of the run, in bytes.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start collecting the statistics; the time of every ProfileStage is kept from now on.
+///
+/// @param[in]   path  "json" to print them to the standard output, or the path of the JSON file.
+///
+/// @note  With "json", the standard output is sent to the standard error from now on, so that only the JSON is printed
+///        to the standard output.
+///
+void startStats( const char *path );
+
+/// @brief  Whether the statistics are collected.
+bool collectingStats();
+
+/// @brief  Keep the time of a stage; see ProfileStage. (ignored if not collecting)
+void recordStageStats( const char *label, const double time );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Stop collecting; write the statistics as JSON.
+///
+/// The object holds the fields of the run, the fill-in of the factor (nnz_factor minus the nonzeros of the lower
+/// triangle of Lii), the stages with their times, the total time of the stages, and the peak resident set size of the
+/// process. Unknown fields are null.
+///
+/// @param[in]   stats  the characteristics of the run.
+///
+/// @return  whether the statistics are written. (true if not collecting)
+///
+bool finishStats( const RunStats &stats );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Write a JSON string, escaping the quotes, the backslashes, and the control characters.
+///
+/// @param[in]   file  the file.
+/// @param[in]   str   the string; null if none.
+///
+void writeJsonString( FILE *file, const char *str );
+
+#endif  // SCSC_RUN_STATS_HPP
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    simd.hpp
+/// @brief   The SIMD kernels header; one variant per instruction set, chosen at startup.
+///
+
+#ifndef SCSC_SIMD_HPP
+#define SCSC_SIMD_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The enumeration of instruction sets of the kernels.
+///
+enum class Isa {
+  GENERIC = 0,  ///< Portable code; SSE2 on x86-64.
+  AVX2    = 1,  ///< AVX2 and FMA.
+  AVX512  = 2,  ///< AVX-512 (F, BW, and VL) and FMA.
+  COUNT,        ///< Used for counting number of instruction sets.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The hot kernels of an instruction set.
+///
+/// The AVX2 and the AVX-512 variants sum in 8 lanes in the same order and fuse the same multiply-adds, so that they give
+/// the same bits; the generic variant sums in order, as the code did before the variants. The cotangent weights and the
+/// line counts are exact in every variant.
+///
+struct SimdKernels {
+  Isa isa;  ///< the instruction set.
+
+  /// y[i] := A(i, :) * x for begin <= i < end; A in CSR format.
+  void (*spmv)( const int begin, const int end, const double *A_val, const int *A_row, const int *A_col,
+                const double *x, double *y );
+
+  /// x' * y of n entries.
+  double (*dot)( const int n, const double *x, const double *y );
+
+  /// y := y + a * x of n entries.
+  void (*axpy)( const int n, const double a, const double *x, double *y );
+
+  /// y := x + b * y of n entries.
+  void (*xpby)( const int n, const double *x, const double b, double *y );
+
+  /// The cotangent weights of the faces begin <= i < end; see cotangentWeightSparse.
+  void (*cotangent)( const int nv, const int nf, const double *V, const int *F, const int begin, const int end,
+                     double *W );
+
+  /// Add the lines of len characters starting with 'v' and 'f' to nv and nf; prev is the character before buf.
+  void (*countLines)( const char *buf, const long len, const char prev, long *nv, long *nf );
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The kernels of the selected instruction set.
+///
+/// @note  At startup, the best instruction set the CPU supports (by CPUID) is selected, or the one the environment
+///        variable SCSC_ISA names (generic, avx2, or avx512) if the CPU supports it.
+///
+const SimdKernels &simd();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Select the instruction set of the kernels. (e.g. to benchmark the variants)
+///
+/// @param[in]   isa  the instruction set.
+///
+/// @return  whether the CPU (and the build) supports it; the selection is unchanged if not.
+///
+/// @note  Must not be called while work is running in the thread pool.
+///
+bool selectIsa( const Isa isa );
+
+/// @brief  The best instruction set the CPU and the build support.
+Isa detectIsa();
+
+/// @brief  The name of an instruction set; "generic", "avx2", or "avx512".
+const char *isaName( const Isa isa );
+
+/// @brief  Find an instruction set by its name; COUNT if unknown.
+Isa findIsa( const char *name );
+
+/// @brief  The kernels of an instruction set; null if the build does not have them. (used by simd.cpp)
+const SimdKernels *simdGeneric();
+const SimdKernels *simdAvx2();
+const SimdKernels *simdAvx512();
+
+/// @brief  Sum 8 lanes in the order shared by the variants.
+inline double sumLanes( const double *lane ) {
+  return ((lane[0] + lane[1]) + (lane[2] + lane[3])) + ((lane[4] + lane[5]) + (lane[6] + lane[7]));
+}
+
+#endif  // SCSC_SIMD_HPP
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    thread_pool.hpp
+/// @brief   The shared work-stealing thread pool header.
+///
+
+#ifndef SCSC_THREAD_POOL_HPP
+#define SCSC_THREAD_POOL_HPP
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Start (or restart) the shared thread pool.
+///
+/// @param[in]   nthread   the number of threads, including the threads that submit work; 0 for the number of CPUs.
+/// @param[in]   affinity  whether to pin each worker thread to its own CPU.
+///
+/// @note  Without a call, the pool starts on first use with SCSC_NUM_THREADS threads (the number of CPUs if unset),
+///        pinned if SCSC_AFFINITY is set to 1.
+/// @note  Must not be called while work is running in the pool.
+///
+void initThreadPool( const int nthread, const bool affinity );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  The number of threads of the shared thread pool.
+///
+/// @return  the number of threads, including the threads that submit work.
+///
+int threadPoolSize();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run a loop in the shared thread pool.
+///
+/// [begin, end) is split into at most 4 chunks per thread, each of at least grain iterations. The chunks go to the deque
+/// of the calling thread; idle threads steal them. The calling thread runs chunks (of any loop) until its own are done,
+/// and sleeps while there are none to run.
+///
+/// @param[in]   begin  the first index.
+/// @param[in]   end    the last index plus one.
+/// @param[in]   grain  the minimum number of iterations of a chunk.
+/// @param[in]   body   the loop body; called as body(chunk_begin, chunk_end).
+///
+/// @note  Nested loops run in the same pool. Of the threads outside the pool, only one at a time runs chunks (the pool
+///        size counts one such thread); the others sleep until their loops are done. So the number of threads running
+///        chunks never exceeds the pool size, no matter how many threads submit work. OpenMP and MKL run
+///        single-threaded inside the pool.
+/// @note  The body is passed by reference; a loop allocates no memory.
+/// @note  If a chunk throws, the chunks not yet started are skipped, and the first error is rethrown to the caller once
+///        the running ones are done.
+///
+template <typename Body>
+void parallelFor( const int begin, const int end, const int grain, const Body &body );
+
+/// @brief  The type-erased loop body of parallelFor; called as body(context, chunk_begin, chunk_end).
+using LoopBody = void (*)( const void *context, int begin, int end );
+
+/// @brief  Run a loop in the shared thread pool; see parallelFor( const int, const int, const int, const Body& ).
+void parallelFor( const int begin, const int end, const int grain, LoopBody body, const void *context );
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run a loop of sums in the shared thread pool.
+///
+/// @param[in]   begin  the first index.
+/// @param[in]   end    the last index plus one.
+/// @param[in]   grain  the minimum number of iterations of a chunk.
+/// @param[in]   nsum   the number of sums.
+/// @param[in]   body   the loop body; called as body(chunk_begin, chunk_end, partial), adding to the partial sums of
+///                     the chunk (nsum by 1 vector, zero on entry).
+///
+/// @param[out]  sum    the sums; nsum by 1 vector.
+///
+/// @note  The partial sums are added in the order of the chunks, so that the result does not depend on the scheduling.
+/// @note  The partial sums are kept on the stack; the number of chunks is limited to 1024 / nsum.
+///
+template <typename Body>
+void parallelSum( const int begin, const int end, const int grain, const int nsum, const Body &body, double *sum );
+
+/// @brief  The type-erased loop body of parallelSum; called as body(context, chunk_begin, chunk_end, partial).
+using SumBody = void (*)( const void *context, int begin, int end, double *partial );
+
+/// @brief  Run a loop of sums in the shared thread pool; see parallelSum( ..., const Body&, double* ).
+void parallelSum( const int begin, const int end, const int grain, const int nsum, SumBody body, const void *context,
+                  double *sum );
+
+template <typename Body>
+void parallelFor( const int begin, const int end, const int grain, const Body &body ) {
+  parallelFor(begin, end, grain, []( const void *context, int b, int e ) {
+    (*static_cast<const Body*>(context))(b, e);
+  }, &body);
+}
+
+template <typename Body>
+void parallelSum( const int begin, const int end, const int grain, const int nsum, const Body &body, double *sum ) {
+  parallelSum(begin, end, grain, nsum, []( const void *context, int b, int e, double *partial ) {
+    (*static_cast<const Body*>(context))(b, e, partial);
+  }, &body, sum);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Sort in the shared thread pool; the chunks are sorted in parallel and then merged pairwise.
+///
+/// @param[in]   first  the first element.
+/// @param[in]   last   the last element plus one.
+/// @param[in]   comp   the comparison.
+///
+/// @param[out]  first  the sorted elements.
+///
+template <typename T, typename Compare>
+void parallelSort( T *first, T *last, Compare comp ) {
+  const long n = last - first, grain = 4096;
+  long nchunk = 1;
+  while ( nchunk < threadPoolSize() && n / (2*nchunk) >= grain ) {
+    nchunk *= 2;
+  }
+  auto bound = [=]( const long k ) { return first + n * k / nchunk; };
+  parallelFor(0, nchunk, 1, [&]( int b, int e ) {
+    for ( int k = b; k < e; ++k ) {
+      std::sort(bound(k), bound(k+1), comp);
+    }
+  });
+  for ( long width = 1; width < nchunk; width *= 2 ) {
+    parallelFor(0, nchunk / (2*width), 1, [&]( int b, int e ) {
+      for ( int k = b; k < e; ++k ) {
+        std::inplace_merge(bound(2*k*width), bound((2*k+1)*width), bound((2*k+2)*width), comp);
+      }
+    });
+  }
+}
+
+#endif  // SCSC_THREAD_POOL_HPP
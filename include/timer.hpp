@@ -8,45 +8,17 @@
 #ifndef SCSC_TIMER_HPP
 #define SCSC_TIMER_HPP
 
-#include <iostream>
-#include <sys/time.h>
+#include <chrono>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Gets current time.
+/// @brief  Gets current time; monotonic.
 ///
-/// @return  current time.
+/// @return  current time, in seconds.
 ///
-inline double getTime() {
-  timeval tv;
-  gettimeofday(&tv, NULL);
-  return double(tv.tv_sec) + double(tv.tv_usec) * 1e-6;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Start stopwatch timer.
-///
-/// @param  ptr_timer  the timer; pointer.
-///
-/// @see  toc
-///
-inline double tic( double *ptr_timer ) {
-  *ptr_timer = getTime();
-  return *ptr_timer;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Read elapsed time from stopwatch
-///
-/// @param  ptr_timer  the timer; pointer.
+/// @see  ProfileStage, for timing the stages of a main program.
 ///
-/// @return  elapsed time.
-///
-/// @see  tic
-///
-inline double toc( double *ptr_timer ) {
-  double time = getTime() - *ptr_timer;
-  std::cout << "Elapsed time is " << time << " seconds." << std::endl;
-  return time;
+inline double getTime() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 #endif  // SCSC_TIMER_HPP
@@ -0,0 +1,441 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    bench.cpp
+/// @brief   The benchmark over the bundled meshes and graphs.
+///
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <harmonic.hpp>
+#include <harmonic_mapper.hpp>
+#include <iterative.hpp>
+#include <profiler.hpp>
+#include <run_stats.hpp>
+#include <sgp.hpp>
+#include <simd.hpp>
+#include <thread_pool.hpp>
+using namespace std;
+
+#ifndef SCSC_VERSION
+#define SCSC_VERSION "unknown"
+#endif  // SCSC_VERSION
+
+#ifndef SCSC_DATA_DIR
+#define SCSC_DATA_DIR "data"
+#endif  // SCSC_DATA_DIR
+
+static const int kSpmv = 100;  // the number of SpMVs of a graph per trial
+
+// The times of a stage over the trials
+struct Series {
+  string         input;
+  string         kind;     // "mesh" or "graph"
+  string         method;   // "kirchhoff", "cotangent", or "" for graphs
+  string         stage;
+  string         backend;  // the solver backend of the solve stage; "" otherwise
+  int            nv;       // the number of vertices
+  long           nf;       // the number of faces (meshes) or of nonzeros of the Laplacian (graphs)
+  vector<double> time;
+};
+
+const char* const short_opt = "hf:g:d:o:O:n:w:t:s:N:i:";
+
+const struct option long_opt[] = {
+  {"help",      0, NULL, 'h'},
+  {"file",      1, NULL, 'f'},
+  {"generate",  1, NULL, 'g'},
+  {"data",      1, NULL, 'd'},
+  {"output",    1, NULL, 'o'},
+  {"mesh",      1, NULL, 'O'},
+  {"trials",    1, NULL, 'n'},
+  {"warmup",    1, NULL, 'w'},
+  {"type",      1, NULL, 't'},
+  {"solver",    1, NULL, 's'},
+  {"dense-max", 1, NULL, 'N'},
+  {"isa",       1, NULL, 'i'},
+  {NULL,        0, NULL, 0}
+};
+
+// Display the usage
+static void dispUsage( const char *bin ) {
+  cout << "Usage: " << bin << " [OPTIONS]" << endl;
+  cout << "Options:" << endl;
+  cout << "  -h,       --help             Display this information" << endl;
+  cout << "  -f<file>, --file <file>      An input; *.obj is a mesh, anything else a graph (repeatable; default: all in the data directory)" << endl;
+  cout << "  -g<spec>, --generate <spec>  A generated mesh <kind>:<faces>[:shuffle], e.g. jitter:1e7 (repeatable)" << endl;
+  cout << "  -d<dir>,  --data <dir>       The data directory (default " << SCSC_DATA_DIR << ")" << endl;
+  cout << "  -o<file>, --output <file>    The JSON results (default bench.json)" << endl;
+  cout << "  -O<file>, --mesh <file>      The output mesh of the write stage (default /dev/null)" << endl;
+  cout << "  -n<num>,  --trials <num>     The number of timed trials (default 5)" << endl;
+  cout << "  -w<num>,  --warmup <num>     The number of warm-up trials (default 1)" << endl;
+  cout << "  -t<num>,  --type <num>       0: KIRCHHOFF, 1: COTANGENT (default both)" << endl;
+  cout << "  -s<name>, --solver <name>    The solver backend (repeatable; default all)" << endl;
+  cout << "  -N<num>,  --dense-max <num>  The largest mesh (vertices) for the dense backends (default 4000)" << endl;
+  cout << "  -i<name>, --isa <name>       The instruction set of the kernels: generic, avx2, or avx512 (default the best)" << endl;
+}
+
+// The elapsed time of a call, in seconds
+template <typename Func>
+static double timeCall( Func func ) {
+  const int64_t begin = profileClock();
+  func();
+  return (profileClock() - begin) * 1e-9;
+}
+
+// Add a time to its series
+static void record( vector<Series> &result, const Series &key, const double time ) {
+  for ( Series &s : result ) {
+    if ( s.input == key.input && s.method == key.method && s.stage == key.stage && s.backend == key.backend ) {
+      s.time.push_back(time);
+      return;
+    }
+  }
+  result.push_back(key);
+  result.back().time.assign(1, time);
+}
+
+// The p-th percentile (0 <= p <= 100) of the times, linearly interpolated
+static double percentile( vector<double> time, const double p ) {
+  sort(time.begin(), time.end());
+  const double pos = p / 100.0 * (time.size()-1);
+  const size_t i = size_t(pos);
+  return (i+1 < time.size()) ? time[i] + (pos-i) * (time[i+1]-time[i]) : time.back();
+}
+
+// The model name of the CPU
+static string cpuModel() {
+  FILE *file = fopen("/proc/cpuinfo", "r");
+  if ( file == nullptr ) {
+    return "unknown";
+  }
+  char line[1024];
+  string model = "unknown";
+  while ( fgets(line, sizeof(line), file) != nullptr ) {
+    const char *colon = strchr(line, ':');
+    if ( strncmp(line, "model name", 10) == 0 && colon != nullptr ) {
+      model = colon+2;
+      model.erase(model.find_last_not_of(" \n")+1);
+      break;
+    }
+  }
+  fclose(file);
+  return model;
+}
+
+// Parse a generated mesh <kind>:<faces>[:shuffle]; false if not one
+static bool parseGenerated( const string &spec, MeshShape &shape, int &n, bool &shuffle ) {
+  const size_t colon = spec.find(':');
+  if ( colon == string::npos ) {
+    return false;
+  }
+  shape = findMeshShape(spec.substr(0, colon).c_str());
+  n = int(min(max(round(sqrt(atof(spec.c_str()+colon+1) / 2.0)), 1.0), double(kMaxMeshCells)));
+  shuffle = (spec.find(":shuffle", colon+1) != string::npos);
+  return shape != MeshShape::COUNT;
+}
+
+// Benchmark the stages of a mesh; the solve stage once per backend
+static void benchMesh( const char *input, const Method method, const vector<const SparseBackend*> &backend,
+                       const int dense_max, const char *mesh, const int nwarm, const int ntrial,
+                       vector<Series> &result ) {
+  HarmonicMapper mapper;
+  MeshShape shape;
+  int n;
+  bool shuffle;
+  const bool generated = parseGenerated(input, shape, n, shuffle);
+  Series key = {input, "mesh", (method == Method::KIRCHHOFF) ? "kirchhoff" : "cotangent", "", "", 0, 0, {}};
+  for ( int trial = -nwarm; trial < ntrial; ++trial ) {
+    vector<pair<string, double>> time;
+    if ( generated ) {
+      time.emplace_back("generate", timeCall([&]() { mapper.generate(shape, n, 0, shuffle); }));
+    } else {
+      time.emplace_back("load",     timeCall([&]() { mapper.load(input); }));
+    }
+    time.emplace_back("boundary", timeCall([&]() { mapper.verifyBoundary(); }));
+    time.emplace_back("reorder",  timeCall([&]() { mapper.reorderVertex(); }));
+    time.emplace_back("assemble", timeCall([&]() { mapper.constructLaplacian(method); }));
+    time.emplace_back("map",      timeCall([&]() { mapper.mapBoundary(); }));
+    for ( const SparseBackend *b : backend ) {
+      if ( strncmp(b->name, "dense", 5) == 0 && mapper.nv() > dense_max ) {
+        continue;
+      }
+      SolveOptions options;
+      options.solver = b->name;
+      time.emplace_back(string("solve:") + b->name, timeCall([&]() { mapper.solve(options); }));
+    }
+    time.emplace_back("write", timeCall([&]() { mapper.write(mesh); }));
+
+    if ( trial < 0 ) {
+      continue;
+    }
+    key.nv = mapper.nv();
+    key.nf = mapper.nf();
+    for ( const pair<string, double> &t : time ) {
+      const size_t colon = t.first.find(':');
+      key.stage   = t.first.substr(0, colon);
+      key.backend = (colon == string::npos) ? "" : t.first.substr(colon+1);
+      record(result, key, t.second);
+    }
+  }
+}
+
+// Benchmark a graph: loading, assembling its Laplacian (CSR), and kSpmv SpMVs
+static void benchGraph( const char *input, const int nwarm, const int ntrial, vector<Series> &result ) {
+  Series key = {input, "graph", "", "", "", 0, 0, {}};
+  for ( int trial = -nwarm; trial < ntrial; ++trial ) {
+    int *E = nullptr, ne = 0;
+    const double time_load = timeCall([&]() { readGraph(const_cast<char*>(input), &E, &ne); });
+
+    // The Laplacian D - A of the undirected graph; the keys are (row, column), the diagonal included
+    int n = 0, nnz = 0, *A_row = nullptr, *A_col = nullptr;
+    double *A_val = nullptr;
+    const double time_assemble = timeCall([&]() {
+      vector<uint64_t> key;
+      key.reserve(3*ne);
+      for ( int e = 0; e < ne; ++e ) {
+        const int a = E[e], b = E[ne+e];
+        if ( a < 0 || b < 0 || a == b ) {
+          continue;
+        }
+        key.push_back((uint64_t(a) << 32) | uint32_t(b));
+        key.push_back((uint64_t(b) << 32) | uint32_t(a));
+        n = max(n, max(a, b)+1);
+      }
+      for ( int i = 0; i < n; ++i ) {
+        key.push_back((uint64_t(i) << 32) | uint32_t(i));
+      }
+      parallelSort(key.data(), key.data()+key.size(), less<uint64_t>());
+      nnz = unique(key.begin(), key.end()) - key.begin();
+      A_row = new int[n+1];
+      A_col = new int[nnz];
+      A_val = new double[nnz];
+      fill(A_row, A_row+n+1, 0);
+      for ( int k = 0; k < nnz; ++k ) {
+        const int i = int(key[k] >> 32), j = int(uint32_t(key[k]));
+        A_row[i+1]++;
+        A_col[k] = j;
+        A_val[k] = -1.0;
+      }
+      for ( int i = 0; i < n; ++i ) {
+        A_row[i+1] += A_row[i];
+      }
+      for ( int i = 0; i < n; ++i ) {
+        const int *diag = lower_bound(A_col+A_row[i], A_col+A_row[i+1], i);
+        A_val[diag-A_col] = A_row[i+1] - A_row[i] - 1;
+      }
+    });
+
+    double *x = new double[n], *y = new double[n];
+    for ( int i = 0; i < n; ++i ) {
+      x[i] = 1.0 / (i+1);
+    }
+    const double time_spmv = timeCall([&]() {
+      for ( int k = 0; k < kSpmv; ++k ) {
+        spmvSparse(n, A_val, A_row, A_col, x, y);
+        swap(x, y);
+      }
+    });
+    delete[] E;
+    delete[] A_row;
+    delete[] A_col;
+    delete[] A_val;
+    delete[] x;
+    delete[] y;
+
+    if ( trial < 0 ) {
+      continue;
+    }
+    key.nv = n;
+    key.nf = nnz;
+    key.stage = "load";     record(result, key, time_load);
+    key.stage = "assemble"; record(result, key, time_assemble);
+    key.stage = "spmv";     record(result, key, time_spmv);
+  }
+}
+
+// Write the results with the machine information
+static bool writeJson( const char *output, const vector<Series> &result, const int nwarm, const int ntrial ) {
+  FILE *file = fopen(output, "w");
+  if ( file == nullptr ) {
+    return false;
+  }
+
+  utsname os;
+  uname(&os);
+  char host[256] = "unknown";
+  gethostname(host, sizeof(host));
+  char date[32];
+  const time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  fprintf(file, "{\n  \"version\": ");
+  writeJsonString(file, SCSC_VERSION);
+  fprintf(file, ",\n  \"date\": \"%s\",\n  \"machine\": {\n    \"host\": ", date);
+  writeJsonString(file, host);
+  fprintf(file, ",\n    \"os\": ");
+  writeJsonString(file, (string(os.sysname) + " " + os.release + " " + os.machine).c_str());
+  fprintf(file, ",\n    \"cpu\": ");
+  writeJsonString(file, cpuModel().c_str());
+  fprintf(file, ",\n    \"cpus\": %u,\n    \"threads\": %d,\n    \"compiler\": ", thread::hardware_concurrency(),
+          threadPoolSize());
+  writeJsonString(file, __VERSION__);
+  fprintf(file, ",\n    \"isa\": \"%s\"", isaName(simd().isa));
+  fprintf(file, "\n  },\n  \"warmup\": %d,\n  \"trials\": %d,\n  \"spmv_per_trial\": %d,\n  \"results\": [", nwarm,
+          ntrial, kSpmv);
+  for ( size_t k = 0; k < result.size(); ++k ) {
+    const Series &s = result[k];
+    fprintf(file, "%s\n    {\"input\": ", (k == 0) ? "" : ",");
+    writeJsonString(file, s.input.c_str());
+    fprintf(file, ", \"kind\": \"%s\", \"nv\": %d, \"%s\": %ld, \"method\": ", s.kind.c_str(), s.nv,
+            (s.kind == "mesh") ? "nf" : "nnz", s.nf);
+    writeJsonString(file, s.method.c_str());
+    fprintf(file, ", \"stage\": \"%s\", \"backend\": ", s.stage.c_str());
+    writeJsonString(file, s.backend.c_str());
+    fprintf(file, ",\n     \"median\": %.9g, \"p10\": %.9g, \"p90\": %.9g, \"min\": %.9g, \"max\": %.9g, \"times\": [",
+            percentile(s.time, 50), percentile(s.time, 10), percentile(s.time, 90),
+            *min_element(s.time.begin(), s.time.end()), *max_element(s.time.begin(), s.time.end()));
+    for ( size_t t = 0; t < s.time.size(); ++t ) {
+      fprintf(file, "%s%.9g", (t == 0) ? "" : ", ", s.time[t]);
+    }
+    fprintf(file, "]}");
+  }
+  fprintf(file, "\n  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+
+  const char *data   = SCSC_DATA_DIR;
+  const char *output = "bench.json";
+  const char *mesh   = "/dev/null";
+  int ntrial = 5, nwarm = 1, dense_max = 4000;
+  vector<string> input, generated;
+  vector<Method> method = {Method::KIRCHHOFF, Method::COTANGENT};
+  vector<const SparseBackend*> backend;
+
+  // Read arguments
+  int c = 0;
+  while ( (c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1 ) {
+    switch ( c ) {
+      case 'h': dispUsage(argv[0]); return 0;
+      case 'f': input.push_back(optarg); break;
+      case 'g': {
+        MeshShape shape;
+        int n;
+        bool shuffle;
+        if ( !parseGenerated(optarg, shape, n, shuffle) ) {
+          cerr << "Unknown generated mesh " << optarg << endl;
+          return 1;
+        }
+        generated.push_back(optarg);
+        break;
+      }
+      case 'd': data = optarg; break;
+      case 'o': output = optarg; break;
+      case 'O': mesh = optarg; break;
+      case 'n': ntrial = max(atoi(optarg), 1); break;
+      case 'w': nwarm = max(atoi(optarg), 0); break;
+      case 't': method.assign(1, Method(atoi(optarg))); break;
+      case 'N': dense_max = atoi(optarg); break;
+      case 's': {
+        const SparseBackend *b = findSparseBackend(optarg);
+        if ( b == nullptr ) {
+          cerr << "Unknown solver " << optarg << endl;
+          return 1;
+        }
+        backend.push_back(b);
+        break;
+      }
+      case 'i': {
+        if ( !selectIsa(findIsa(optarg)) ) {
+          cerr << "Unsupported instruction set " << optarg << endl;
+          return 1;
+        }
+        break;
+      }
+      default: dispUsage(argv[0]); return 1;
+    }
+  }
+
+  // The inputs; every file in the data directory by default
+  if ( input.empty() && generated.empty() ) {
+    DIR *dir = opendir(data);
+    if ( dir == nullptr ) {
+      cerr << "Can not open the data directory " << data << endl;
+      return 1;
+    }
+    for ( dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir) ) {
+      const string name = entry->d_name;
+      if ( name[0] != '.' && name.find("CMake") == string::npos ) {
+        input.push_back(string(data) + "/" + name);
+      }
+    }
+    closedir(dir);
+    sort(input.begin(), input.end());
+  }
+  input.insert(input.end(), generated.begin(), generated.end());
+
+  // The backends; all by default
+  if ( backend.empty() ) {
+    const SparseBackend *b;
+    const int nbackend = listSparseBackends(&b);
+    for ( int i = 0; i < nbackend; ++i ) {
+      backend.push_back(b+i);
+    }
+  }
+
+  // Run; the messages of the stages are dropped
+  vector<Series> result;
+  for ( const string &in : input ) {
+    const bool is_mesh = (in.size() > 4 && in.compare(in.size()-4, 4, ".obj") == 0) ||
+                         find(generated.begin(), generated.end(), in) != generated.end();
+    cerr << "Benchmarking " << in << " ..." << endl;
+    streambuf *buf = cout.rdbuf(nullptr);
+    try {
+      if ( is_mesh ) {
+        for ( const Method m : method ) {
+          benchMesh(in.c_str(), m, backend, dense_max, mesh, nwarm, ntrial, result);
+        }
+      } else {
+        benchGraph(in.c_str(), nwarm, ntrial, result);
+      }
+    } catch ( const HarmonicError &e ) {
+      cerr << "Skipped " << in << ": " << e.what() << endl;
+    }
+    cout.rdbuf(buf);
+    cout.clear();
+  }
+
+  // Summary
+  printf("%-32s %-10s %-9s %-15s %12s %12s %12s\n", "Input", "Method", "Stage", "Backend", "Median (s)", "P10 (s)",
+         "P90 (s)");
+  for ( const Series &s : result ) {
+    const size_t slash = s.input.find_last_of('/');
+    printf("%-32s %-10s %-9s %-15s %12.6f %12.6f %12.6f\n",
+           s.input.substr((slash == string::npos) ? 0 : slash+1).c_str(), s.method.c_str(), s.stage.c_str(),
+           s.backend.c_str(), percentile(s.time, 50), percentile(s.time, 10), percentile(s.time, 90));
+  }
+
+  if ( !writeJson(output, result, nwarm, ntrial) ) {
+    cerr << "Can not write the results " << output << endl;
+    return 1;
+  }
+  cout << endl << "Stores in \"" << output << "\"." << endl;
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    band_harmonic.cpp
+/// @brief   The implementation of harmonic problem solving. (banded version)
+///
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <harmonic.hpp>
+#include <band.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+template <typename T>
+static int factorize( const int n, const int kd, T *A, const long ld ) {
+  // The band is read and written once; column j updates a kd by kd triangle
+  SCSC_PROFILE_WORK(2.0*sizeof(T)*n*ld, double(n)*kd*(kd+2));
+  for ( int j = 0; j < n; ++j ) {
+    T *Aj = A + j*ld;
+    if ( Aj[0] <= 0.0 ) {
+      return j+1;
+    }
+    const T d = sqrt(Aj[0]);
+    const int m = min(kd, n-1-j);
+    Aj[0] = d;
+    for ( int i = 1; i <= m; ++i ) {
+      Aj[i] /= d;
+    }
+
+    // A[j+1:j+m, j+1:j+m] -= l * l'
+    for ( int k = 1; k <= m; ++k ) {
+      T *Ak = A + (j+k)*ld - k;
+      const T a = Aj[k];
+      #pragma omp simd
+      for ( int i = k; i <= m; ++i ) {
+        Ak[i] -= Aj[i] * a;
+      }
+    }
+  }
+  return 0;
+}
+
+template <typename T>
+static void solve( const int n, const int kd, const T *L, const long ld, T *b ) {
+  SCSC_PROFILE_WORK(2.0*sizeof(T)*n*(ld+1), 4.0*n*kd);
+  // L * y = b
+  for ( int j = 0; j < n; ++j ) {
+    const T *Lj = L + j*ld;
+    const int m = min(kd, n-1-j);
+    const T y = (b[j] /= Lj[0]);
+    for ( int i = 1; i <= m; ++i ) {
+      b[j+i] -= Lj[i] * y;
+    }
+  }
+
+  // L' * x = y
+  for ( int j = n-1; j >= 0; --j ) {
+    const T *Lj = L + j*ld;
+    const int m = min(kd, n-1-j);
+    T s = b[j];
+    for ( int i = 1; i <= m; ++i ) {
+      s -= Lj[i] * b[j+i];
+    }
+    b[j] = s / Lj[0];
+  }
+}
+
+int factorizeBand(
+    const int  n,
+    const int  kd,
+    double    *A,
+    const long ld
+) {
+  return factorize(n, kd, A, ld);
+}
+
+int factorizeBand(
+    const int  n,
+    const int  kd,
+    float     *A,
+    const long ld
+) {
+  return factorize(n, kd, A, ld);
+}
+
+void solveBand(
+    const int     n,
+    const int     kd,
+    const double *L,
+    const long    ld,
+    double       *b
+) {
+  solve(n, kd, L, ld, b);
+}
+
+void solveBand(
+    const int    n,
+    const int    kd,
+    const float *L,
+    const long   ld,
+    float       *b
+) {
+  solve(n, kd, L, ld, b);
+}
+
+int updateBand(
+    const int     n,
+    const int     kd,
+    double       *L,
+    const long    ld,
+    const int     r,
+    double       *X,
+    const long    ldx,
+    const int     s,
+    const double *sigma
+) {
+  // The modifications are applied column by column, so that each column of L is loaded once; every row from s on is
+  // visited, since a modification may start past the fill of the earlier ones (e.g. in another component of L)
+  for ( int k = s; k < n; ++k ) {
+    double *Lk = L + k*ld;
+    const int m = min(kd, n-1-k);
+    for ( int q = 0; q < r; ++q ) {
+      double *xk = X + k + q*ldx;
+      if ( xk[0] == 0.0 ) {
+        continue;
+      }
+      const double r2 = Lk[0]*Lk[0] + sigma[q]*xk[0]*xk[0];
+      if ( r2 <= 0.0 ) {
+        return k+1;
+      }
+      const double d = sqrt(r2);
+      const double c = d / Lk[0], t = xk[0] / Lk[0], st = sigma[q] * t;
+      Lk[0] = d;
+      #pragma omp simd
+      for ( int i = 1; i <= m; ++i ) {
+        Lk[i] = (Lk[i] + st * xk[i]) / c;
+        xk[i] = c * xk[i] - t * Lk[i];
+      }
+      xk[0] = 0.0;
+    }
+  }
+  return 0;
+}
+
+void solveHarmonicBand(
+    const int nv,
+    const int nb,
+    const int bw,
+    const int nr,
+    double *L,
+    double *U
+) {
+  const int ni = nv-nb;
+  const int ld = bw+1;
+
+  double       *Lii = L;
+  const double *Lib = L+long(ld)*ni;
+
+  // ====================================================================================================================== //
+  // Solve Lii * Ui = - Lib Ub
+
+  // Lii := chol(Lii)
+  int info = factorizeBand(ni, bw, Lii, ld);
+  if ( info != 0 ) {
+    throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization failed: the leading minor of order " +
+                        to_string(info) + " is not positive definite.");
+  }
+
+  for ( int k = 0; k < 2; ++k ) {
+    const double *Ub = U+k*nv;
+    double       *Ui = U+k*nv+nb;
+
+    // Tmp [in Ui] := - Lib * Ub; only the last nr rows of Lib are nonzero
+    fill(Ui, Ui+ni, 0.0);
+    for ( int j = 0; j < nb; ++j ) {
+      const double *Lj = Lib + long(j)*nr;
+      for ( int i = 0; i < nr; ++i ) {
+        Ui[ni-nr+i] -= Lj[i] * Ub[j];
+      }
+    }
+
+    // Solve Lii * Ui = Tmp [in Ui]
+    solveBand(ni, bw, Lii, ld, Ui);
+  }
+}
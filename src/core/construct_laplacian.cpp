@@ -7,6 +7,7 @@
 ///
 
 #include <harmonic.hpp>
+#include <profiler.hpp>
 #include <iostream>
 #include <cmath>
 using namespace std;
@@ -38,15 +39,24 @@ double Dot(const int n, const double *x, const double *y) {
 void constructLaplacian(
     const Method method,
     const int nv,
+    const int nb,
     const int nf,
     const double *V,
     const int *F,
     double *L
 ) {
-  for (int i=0; i<nv*nv; i++)
+  // Only the interior rows are formed; L[i, j] is stored in L[(i-nb) + j*ni]
+  const int ni = nv-nb;
+  // The matrix is filled once; a cotangent weight costs 31 flops
+  SCSC_PROFILE_WORK(8.0*ni*nv + 84.0*nf, (method == Method::COTANGENT) ? 99.0*nf : 12.0*nf);
+  for (long i=0; i<long(ni)*nv; i++)
   {
     L[i]=0;
   }
+  auto add = [=]( const int i, const int j, const double w ) {
+    if (i >= nb) L[(i-nb)+long(j)*ni] += w;
+    if (j >= nb) L[(j-nb)+long(i)*ni] += w;
+  };
   if (method == Method::KIRCHHOFF) // Kirchhoff Laplacian Matrix
   {
     for (int i = 0; i < nf; ++i)
@@ -54,21 +64,13 @@ void constructLaplacian(
       int F_x = F[i]-1;
       int F_y = F[nf+i]-1;
       int F_z = F[2*nf+i]-1;
-      L[F_x*nv+F_y] = -1;
-      L[F_y*nv+F_z] = -1;
-      L[F_z*nv+F_x] = -1;
-      L[F_y*nv+F_x] = -1;
-      L[F_z*nv+F_y] = -1;
-      L[F_x*nv+F_z] = -1;
-    }
-    for (int i = 0; i<nv; i++){
-      L[i*nv+i]=-1*Sum(nv, L+i*nv, 1);
+      if (F_x >= nb) { L[(F_x-nb)+long(F_y)*ni] = -1; L[(F_x-nb)+long(F_z)*ni] = -1; }
+      if (F_y >= nb) { L[(F_y-nb)+long(F_z)*ni] = -1; L[(F_y-nb)+long(F_x)*ni] = -1; }
+      if (F_z >= nb) { L[(F_z-nb)+long(F_x)*ni] = -1; L[(F_z-nb)+long(F_y)*ni] = -1; }
     }
   }else if (method == Method::COTANGENT) // Cotangent Laplacian Matrix
   {
-    double *v_ki = new double [3];
-    double *v_kj = new double [3];
-    double *v_ij = new double [3];
+    double v_ki[3], v_kj[3], v_ij[3];
     for (int i = 0; i < nf; ++i)
     {
       int F_x = F[i]-1;
@@ -84,15 +86,12 @@ void constructLaplacian(
       v_ij[0] = V[F_y] - V[F_x];
       v_ij[1] = V[nv+F_y] - V[nv+F_x];
       v_ij[2] = V[2*nv+F_y] - V[2*nv+F_x];
-      L[F_x*nv+F_y] += -0.5*Dot(3, v_ki, v_kj)/CrossNorm(v_ki, v_kj);
-      L[F_y*nv+F_x] = L[F_x*nv+F_y];
-      L[F_y*nv+F_z] += 0.5*Dot(3, v_ij, v_ki)/CrossNorm(v_ij, v_ki);
-      L[F_z*nv+F_y] = L[F_y*nv+F_z];
-      L[F_z*nv+F_x] += -0.5*Dot(3, v_kj, v_ij)/CrossNorm(v_kj, v_ij);
-      L[F_x*nv+F_z] = L[F_z*nv+F_x];
-    }
-    for (int i = 0; i<nv; i++){
-      L[i*nv+i]=-1*Sum(nv, L+i*nv, 1);
+      add(F_x, F_y, -0.5*Dot(3, v_ki, v_kj)/CrossNorm(v_ki, v_kj));
+      add(F_y, F_z, 0.5*Dot(3, v_ij, v_ki)/CrossNorm(v_ij, v_ki));
+      add(F_z, F_x, -0.5*Dot(3, v_kj, v_ij)/CrossNorm(v_kj, v_ij));
     }
   }
-}
\ No newline at end of file
+  for (int i = 0; i<ni; i++){
+    L[i+long(nb+i)*ni]=-1*Sum(nv, L+i, ni);
+  }
+}
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    dense_backend.cpp
+/// @brief   The table of dense solver backends.
+///
+
+#include <cstring>
+#include <harmonic.hpp>
+
+// The backends compiled in; the first one is the default
+static const DenseBackend kBackend[] = {
+  {"cholesky", "native tiled Cholesky",  solveHarmonic},
+#ifdef SCSC_USE_MKL
+  {"lapack",   "MKL LAPACK Cholesky",    solveHarmonicMkl},
+#endif  // SCSC_USE_MKL
+#ifdef SCSC_USE_GPU
+  {"magma",    "MAGMA LU on GPU",        solveHarmonicMagma},
+#endif  // SCSC_USE_GPU
+};
+
+int listDenseBackends(
+    const DenseBackend **ptr_backend
+) {
+  *ptr_backend = kBackend;
+  return sizeof(kBackend) / sizeof(kBackend[0]);
+}
+
+const DenseBackend *findDenseBackend(
+    const char *name
+) {
+  if ( name == nullptr ) {
+    return kBackend;
+  }
+  for ( const DenseBackend &backend : kBackend ) {
+    if ( strcmp(backend.name, name) == 0 ) {
+      return &backend;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    generate_mesh.cpp
+/// @brief   The implementation of mesh generation.
+///
+#include <harmonic.hpp>
+#include <cmath>
+#include <cstring>
+#include <profiler.hpp>
+#include <thread_pool.hpp>
+using namespace std;
+
+static const int    kGrain  = 4096;  // the vertices or cells of a task
+static const double kJitter = 0.2;   // the jitter of the points, in cells; below 0.25 keeps each cell convex
+static const int    kWave   = 4;     // the number of waves of the height field
+
+// The splitmix64 hash; turns a seed and an index into independent random bits
+static inline uint64_t mix( uint64_t x ) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+// A uniform random number in [-1, 1) of a seed and an index
+static inline double uniform( const uint64_t seed, const uint64_t k ) {
+  return double(mix(seed ^ mix(k)) >> 11) / 4503599627370496.0 - 1.0;  // 2^52
+}
+
+// The angle at b of the triangle a, b, c
+static inline double angle( const double *a, const double *b, const double *c ) {
+  const double u[2] = {a[0]-b[0], a[1]-b[1]}, v[2] = {c[0]-b[0], c[1]-b[1]};
+  return atan2(fabs(u[0]*v[1]-u[1]*v[0]), u[0]*v[0]+u[1]*v[1]);
+}
+
+void scanMesh(
+    const int n,
+    int *ptr_nv,
+    int *ptr_nf
+) {
+  assert(n >= 1 && n <= kMaxMeshCells);
+  *ptr_nv = (n+1) * (n+1);
+  *ptr_nf = 2 * n * n;
+}
+
+void generateMesh(
+    const MeshShape shape,
+    const int n,
+    const uint64_t seed,
+    const bool shuffle,
+    double *V,
+    double *C,
+    int *F
+) {
+  SCSC_PROFILE_ZONE("generate mesh");
+  int nv, nf;
+  scanMesh(n, &nv, &nf);
+  const int    m = n + 1;
+  const double h = 1.0 / n;
+
+  // Shuffle the vertices by Fisher-Yates; idx[k] is the new index of the vertex k
+  int *idx = nullptr;
+  if ( shuffle ) {
+    idx = new int[nv];
+    for ( int k = 0; k < nv; ++k ) {
+      idx[k] = k;
+    }
+    for ( int k = nv-1; k > 0; --k ) {
+      swap(idx[k], idx[mix(seed + ~uint64_t(k)) % uint64_t(k+1)]);
+    }
+  }
+  auto at = [=]( int k ) { return shuffle ? idx[k] : k; };
+
+  // The height field is a sum of waves of random directions and phases
+  double wave[kWave][4];
+  for ( int w = 0; w < kWave; ++w ) {
+    const double theta = M_PI * uniform(seed, 4*w), freq = 2.0 * M_PI * (w+1);
+    wave[w][0] = freq * cos(theta);
+    wave[w][1] = freq * sin(theta);
+    wave[w][2] = M_PI * uniform(seed, 4*w+1);
+    wave[w][3] = 0.1 / (w+1);
+  }
+
+  // The point of the vertex (i, j) before shuffling
+  auto point = [=]( int i, int j, double *p ) {
+    p[0] = i * h;
+    p[1] = j * h;
+    p[2] = 0.0;
+    if ( shape == MeshShape::JITTER && i > 0 && i < n && j > 0 && j < n ) {
+      const uint64_t k = uint64_t(j) * m + i;
+      p[0] += kJitter * h * uniform(seed, 2*k);
+      p[1] += kJitter * h * uniform(seed, 2*k+1);
+    }
+    if ( shape == MeshShape::BUMPY ) {
+      for ( int w = 0; w < kWave; ++w ) {
+        p[2] += wave[w][3] * sin(wave[w][0]*p[0] + wave[w][1]*p[1] + wave[w][2]);
+      }
+    }
+  };
+
+  parallelFor(0, nv, kGrain, [&]( int begin, int end ) {
+    for ( int k = begin; k < end; ++k ) {
+      double p[3];
+      point(k % m, k / m, p);
+      const int r = at(k);
+      V[r] = p[0];  V[nv+r] = p[1];  V[2*nv+r] = p[2];
+      C[r] = -1.0;  C[nv+r] = -1.0;  C[2*nv+r] = -1.0;
+    }
+  });
+
+  // Split the cell (i, j) with corners a, b, c, d counterclockwise; a-c unless the Delaunay criterion flips it to b-d
+  parallelFor(0, n*n, kGrain, [&]( int begin, int end ) {
+    for ( int c = begin; c < end; ++c ) {
+      const int i = c % n, j = c / n;
+      int q[4] = {j*m+i, j*m+i+1, (j+1)*m+i+1, (j+1)*m+i};
+      if ( shape == MeshShape::JITTER ) {
+        double p[4][3];
+        point(i, j, p[0]);  point(i+1, j, p[1]);  point(i+1, j+1, p[2]);  point(i, j+1, p[3]);
+        if ( angle(p[0], p[1], p[2]) + angle(p[2], p[3], p[0]) > M_PI ) {
+          q[0] = j*m+i+1;  q[1] = (j+1)*m+i+1;  q[2] = (j+1)*m+i;  q[3] = j*m+i;
+        }
+      }
+      const int f = 2*c;
+      F[f]   = at(q[0])+1;  F[nf+f]   = at(q[1])+1;  F[2*nf+f]   = at(q[2])+1;
+      F[f+1] = at(q[0])+1;  F[nf+f+1] = at(q[2])+1;  F[2*nf+f+1] = at(q[3])+1;
+    }
+  });
+
+  delete[] idx;
+}
+
+const char *meshShapeName(
+    const MeshShape shape
+) {
+  switch ( shape ) {
+    case MeshShape::GRID:   return "grid";
+    case MeshShape::JITTER: return "jitter";
+    case MeshShape::BUMPY:  return "bumpy";
+    default:                return "unknown";
+  }
+}
+
+MeshShape findMeshShape(
+    const char *name
+) {
+  for ( int k = 0; k < int(MeshShape::COUNT); ++k ) {
+    if ( strcmp(name, meshShapeName(MeshShape(k))) == 0 ) {
+      return MeshShape(k);
+    }
+  }
+  return MeshShape::COUNT;
+}
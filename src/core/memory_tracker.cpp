@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    memory_tracker.cpp
+/// @brief   The implementation of the memory tracker.
+///
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <memory_tracker.hpp>
+#ifdef __linux__
+#include <unistd.h>
+#endif  // __linux__
+#if defined(SCSC_TRACK_NEW) && defined(__GLIBC__)
+#include <malloc.h>
+#else  // SCSC_TRACK_NEW && __GLIBC__
+#undef SCSC_TRACK_NEW
+#endif  // SCSC_TRACK_NEW && __GLIBC__
+using namespace std;
+
+static atomic<long>  g_live(0);      // the live bytes
+static atomic<long>  g_peak(0);      // the peak of the live bytes
+static atomic<long>  g_rss_peak(0);  // the peak of the sampled RSS
+static atomic<bool>  g_on(false);    // whether the RSS is sampled
+static thread       *g_sampler = nullptr;  // the sampling thread; reused by a restart
+
+static const int kPeriod = 1;  // the sampling period, in milliseconds
+
+// Raise a peak to a value
+static void raise( atomic<long> &peak, const long value ) {
+  long old = peak.load(memory_order_relaxed);
+  while ( value > old && !peak.compare_exchange_weak(old, value, memory_order_relaxed) ) {}
+}
+
+// The resident set size; negative if not available
+static long readRss() {
+#ifdef __linux__
+  FILE *file = fopen("/proc/self/statm", "r");
+  if ( file == nullptr ) {
+    return -1;
+  }
+  long size, resident;
+  const int n = fscanf(file, "%ld %ld", &size, &resident);
+  fclose(file);
+  return (n == 2) ? resident * sysconf(_SC_PAGESIZE) : -1;
+#else  // __linux__
+  return -1;
+#endif  // __linux__
+}
+
+#ifdef SCSC_TRACK_NEW
+
+// The global operator new and delete are replaced only if asked for (SCSC_TRACK_NEW), since every allocation of the
+// program then pays a malloc_usable_size and two atomic updates
+
+// Count a block of new; the usable size is what delete sees too
+static inline void *countNew( void *p ) {
+  if ( p != nullptr ) {
+    const long size = malloc_usable_size(p);
+    raise(g_peak, g_live.fetch_add(size, memory_order_relaxed) + size);
+  }
+  return p;
+}
+
+static inline void countDelete( void *p ) {
+  if ( p != nullptr ) {
+    g_live.fetch_sub(malloc_usable_size(p), memory_order_relaxed);
+  }
+}
+
+void *operator new( size_t size ) {
+  void *p = countNew(malloc(size ? size : 1));
+  if ( p == nullptr ) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[]( size_t size ) {
+  return operator new(size);
+}
+
+void *operator new( size_t size, const nothrow_t& ) noexcept {
+  return countNew(malloc(size ? size : 1));
+}
+
+void *operator new[]( size_t size, const nothrow_t& ) noexcept {
+  return countNew(malloc(size ? size : 1));
+}
+
+void operator delete( void *p ) noexcept {
+  countDelete(p);
+  free(p);
+}
+
+void operator delete[]( void *p ) noexcept {
+  operator delete(p);
+}
+
+void operator delete( void *p, const nothrow_t& ) noexcept {
+  operator delete(p);
+}
+
+void operator delete[]( void *p, const nothrow_t& ) noexcept {
+  operator delete(p);
+}
+
+#endif  // SCSC_TRACK_NEW
+
+bool startMemoryTracking() {
+  if ( !g_on.exchange(true) ) {
+    raise(g_rss_peak, readRss());
+    thread sampler([]() {
+      while ( g_on.load(memory_order_relaxed) ) {
+        raise(g_rss_peak, readRss());
+        this_thread::sleep_for(chrono::milliseconds(kPeriod));
+      }
+    });
+    if ( g_sampler == nullptr ) {
+      g_sampler = new thread;
+    }
+    swap(*g_sampler, sampler);
+  }
+#ifdef SCSC_TRACK_NEW
+  return true;
+#else  // SCSC_TRACK_NEW
+  return false;
+#endif  // SCSC_TRACK_NEW
+}
+
+void stopMemoryTracking() {
+  if ( g_on.exchange(false) ) {
+    g_sampler->join();
+  }
+}
+
+bool memoryTracking() {
+  return g_on.load(memory_order_relaxed);
+}
+
+void trackMemory(
+    const long bytes
+) {
+  raise(g_peak, g_live.fetch_add(bytes, memory_order_relaxed) + bytes);
+}
+
+void readMemory(
+    MemorySample &sample,
+    const bool    reset
+) {
+  const long rss = readRss();
+  const long live = g_live.load();
+  if ( reset ) {
+    g_peak.store(live);
+    g_rss_peak.store(rss);
+  } else {
+    raise(g_rss_peak, rss);
+  }
+#ifdef SCSC_TRACK_NEW
+  sample.live = live;
+  sample.peak = max(g_peak.load(), live);
+#else  // SCSC_TRACK_NEW
+  sample.live = -1.0;
+  sample.peak = -1.0;
+#endif  // SCSC_TRACK_NEW
+  sample.rss      = rss;
+  sample.peak_rss = (rss >= 0) ? max(g_rss_peak.load(), rss) : -1.0;
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    perf_counter.cpp
+/// @brief   The implementation of the hardware performance counters.
+///
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <perf_counter.hpp>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+using namespace std;
+
+static const int kEvent = int(PerfEvent::COUNT);
+
+// The counters of a thread; -1 if an event is not available
+struct ThreadCounters {
+  int fd[kEvent];
+};
+
+static mutex                   g_lock;     // guards the following
+static vector<ThreadCounters>  g_counter;  // the counters of the attached threads; kept after the threads exit
+static atomic<bool>            g_on(false);
+
+static thread_local bool t_attached = false;
+
+#ifdef __linux__
+// Open an event counting the calling thread in user space
+static int openEvent( const PerfEvent event ) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size   = sizeof(attr);
+  attr.type   = PERF_TYPE_HARDWARE;
+  switch ( event ) {
+    case PerfEvent::CYCLES:        attr.config = PERF_COUNT_HW_CPU_CYCLES;    break;
+    case PerfEvent::INSTRUCTIONS:  attr.config = PERF_COUNT_HW_INSTRUCTIONS;  break;
+    case PerfEvent::LLC_MISSES:    attr.config = PERF_COUNT_HW_CACHE_MISSES;  break;  // the last-level cache on most CPUs
+    default:                       attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+  }
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Read an event; scaled by the fraction of the time it was scheduled
+static double readEvent( const int fd ) {
+  uint64_t value[3];
+  if ( read(fd, value, sizeof(value)) != sizeof(value) || value[2] == 0 ) {
+    return 0.0;
+  }
+  return double(value[0]) * (double(value[1]) / double(value[2]));
+}
+#else  // __linux__
+static int openEvent( const PerfEvent ) { return -1; }
+static double readEvent( const int ) { return 0.0; }
+#endif  // __linux__
+
+bool startPerfCounters() {
+  g_on.store(true);
+  attachPerfCounters();
+  lock_guard<mutex> guard(g_lock);
+  for ( const ThreadCounters &c : g_counter ) {
+    for ( int k = 0; k < kEvent; ++k ) {
+      if ( c.fd[k] >= 0 ) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool perfCounting() {
+  return g_on.load(memory_order_relaxed);
+}
+
+void attachPerfCounters() {
+  if ( t_attached || !perfCounting() ) {
+    return;
+  }
+  t_attached = true;
+  ThreadCounters c;
+  for ( int k = 0; k < kEvent; ++k ) {
+    c.fd[k] = openEvent(PerfEvent(k));
+  }
+  lock_guard<mutex> guard(g_lock);
+  g_counter.push_back(c);
+}
+
+void readPerfCounters(
+    PerfSample &sample
+) {
+  for ( int k = 0; k < kEvent; ++k ) {
+    sample.count[k] = -1.0;
+  }
+  lock_guard<mutex> guard(g_lock);
+  for ( const ThreadCounters &c : g_counter ) {
+    for ( int k = 0; k < kEvent; ++k ) {
+      if ( c.fd[k] >= 0 ) {
+        sample.count[k] = max(sample.count[k], 0.0) + readEvent(c.fd[k]);
+      }
+    }
+  }
+}
+
+const char *perfEventName(
+    const PerfEvent event
+) {
+  switch ( event ) {
+    case PerfEvent::CYCLES:        return "cycles";
+    case PerfEvent::INSTRUCTIONS:  return "instructions";
+    case PerfEvent::LLC_MISSES:    return "LLC misses";
+    case PerfEvent::BRANCH_MISSES: return "branch misses";
+    default:                       return "unknown";
+  }
+}
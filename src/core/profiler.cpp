@@ -0,0 +1,440 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    profiler.cpp
+/// @brief   The implementation of the scoped profiler.
+///
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory_tracker.hpp>
+#include <profiler.hpp>
+#include <run_stats.hpp>
+using namespace std;
+
+// A recorded zone
+struct ZoneEvent {
+  const char *name;
+  int64_t     begin;
+  int64_t     end;
+  int         depth;
+};
+
+// The zones of a thread; only the thread appends to it
+struct ThreadTrace {
+  int               tid;
+  vector<ZoneEvent> events;
+};
+
+static mutex                g_lock;            // guards the following
+static vector<ThreadTrace*> g_trace;           // the buffers of the threads that recorded zones; never freed
+static const char          *g_path = nullptr;  // the trace file
+static int64_t              g_origin = 0;      // the start time
+static atomic<bool>         g_on(false);       // whether zones are recorded
+
+// A counted stage
+struct StageRecord {
+  const char *label;
+  double      time;
+  double      bytes;
+  double      flops;
+  PerfSample  perf;
+  MemorySample mem_begin;
+  MemorySample mem_end;
+};
+
+static vector<StageRecord>  g_stage;                // the counted stages; guarded by g_lock
+static const char          *g_csv = nullptr;        // the CSV file of the counted stages
+static atomic<bool>         g_count(false);         // whether the work and the events of stages are counted
+static atomic<int64_t>      g_bytes(0), g_flops(0);  // the work counted so far
+
+static thread_local ThreadTrace *t_trace = nullptr;
+static thread_local int          t_depth = 0;
+
+// Start recording if SCSC_PROFILE is set, counting if SCSC_PERF is set, and tracking if SCSC_MEMORY is set
+static struct ProfileInit {
+  ProfileInit() {
+    const char *env = getenv("SCSC_PROFILE");
+    if ( env != nullptr && env[0] != '\0' ) {
+      startProfile(env);
+    }
+    env = getenv("SCSC_PERF");
+    if ( env != nullptr && env[0] != '\0' && strcmp(env, "0") != 0 ) {
+      startPerfReport((strcmp(env, "1") == 0) ? nullptr : env);
+    }
+    env = getenv("SCSC_MEMORY");
+    if ( env != nullptr && strcmp(env, "1") == 0 ) {
+      startMemoryReport();
+    }
+  }
+} g_init;
+
+// Open a zone on the calling thread; returns the start time
+static int64_t beginZone() {
+  ++t_depth;
+  return profileClock();
+}
+
+// Close a zone on the calling thread
+static void endZone( const char *name, const int64_t begin ) {
+  const int64_t end = profileClock();
+  --t_depth;
+  if ( t_trace == nullptr ) {
+    lock_guard<mutex> guard(g_lock);
+    t_trace = new ThreadTrace;
+    t_trace->tid = g_trace.size();
+    t_trace->events.reserve(4096);
+    g_trace.push_back(t_trace);
+  }
+  const ZoneEvent event = {name, begin, end, t_depth};
+  t_trace->events.push_back(event);
+}
+
+// Format a value; "-" if not available (negative)
+static string formatValue( const char *format, const double value ) {
+  if ( value < 0.0 ) {
+    return "-";
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), format, value);
+  return buf;
+}
+
+// The rates and the events of a stage, printed after its time
+static string describeStage( const StageRecord &r ) {
+  const double *c = r.perf.count;
+  string desc;
+  if ( r.bytes > 0.0 || r.flops > 0.0 ) {
+    desc += formatValue("%.3g GB/s, ", r.bytes / r.time * 1e-9) + formatValue("%.3g GFLOP/s", r.flops / r.time * 1e-9);
+  }
+  if ( c[int(PerfEvent::CYCLES)] > 0.0 && c[int(PerfEvent::INSTRUCTIONS)] >= 0.0 ) {
+    desc += (desc.empty() ? "" : ", ") +
+            formatValue("IPC %.2f", c[int(PerfEvent::INSTRUCTIONS)] / c[int(PerfEvent::CYCLES)]);
+  }
+  for ( const PerfEvent e : {PerfEvent::LLC_MISSES, PerfEvent::BRANCH_MISSES} ) {
+    if ( c[int(e)] >= 0.0 ) {
+      desc += (desc.empty() ? "" : ", ") + string(perfEventName(e)) + formatValue(" %.3g", c[int(e)]);
+    }
+  }
+  return desc.empty() ? desc : "  (" + desc + ")";
+}
+
+// Write the trace and print the summary of the zones
+static void reportZones() {
+  lock_guard<mutex> guard(g_lock);
+
+  // The trace; complete events in microseconds, one track per thread
+  FILE *file = fopen(g_path, "w");
+  if ( file == nullptr ) {
+    cerr << "Can not write the profile " << g_path << endl;
+  } else {
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    const char *sep = "";
+    for ( const ThreadTrace *trace : g_trace ) {
+      fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": "
+                    "\"%s %d\"}}", sep, trace->tid, (trace->tid == 0) ? "main" : "thread", trace->tid);
+      sep = ",\n";
+      for ( const ZoneEvent &e : trace->events ) {
+        fprintf(file, "%s  {\"name\": ", sep);
+        writeJsonString(file, e.name);
+        fprintf(file, ", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                trace->tid, (e.begin - g_origin) * 1e-3, (e.end - e.begin) * 1e-3);
+      }
+    }
+    fprintf(file, "\n]}\n");
+    if ( fclose(file) != 0 ) {
+      cerr << "Can not write the profile " << g_path << endl;
+    }
+  }
+
+  // The summary; the zones by name, in the order they first start, summed over threads
+  struct Row {
+    const char *name;
+    int         depth;
+    long        calls;
+    int64_t     total;
+    int64_t     first;
+  };
+  vector<Row> row;
+  long nevent = 0;
+  for ( ThreadTrace *trace : g_trace ) {
+    for ( const ZoneEvent &e : trace->events ) {
+      auto it = find_if(row.begin(), row.end(), [&]( const Row &r ) { return strcmp(r.name, e.name) == 0; });
+      if ( it == row.end() ) {
+        const Row r = {e.name, e.depth, 0, 0, e.begin};
+        row.push_back(r);
+        it = row.end()-1;
+      }
+      it->depth = min(it->depth, e.depth);
+      it->calls += 1;
+      it->total += e.end - e.begin;
+      it->first = min(it->first, e.begin);
+    }
+    nevent += trace->events.size();
+    trace->events.clear();
+  }
+  stable_sort(row.begin(), row.end(), []( const Row &a, const Row &b ) { return a.first < b.first; });
+
+  printf("\nProfile: %s (%ld zones, %d threads)\n", g_path, nevent, int(g_trace.size()));
+  printf("  %-40s %10s %12s %12s\n", "Zone", "Calls", "Total (s)", "Mean (ms)");
+  for ( const Row &r : row ) {
+    const int indent = 2*min(r.depth, 8);
+    printf("  %*s%-*s %10ld %12.6f %12.6f\n", indent, "", 40-indent, r.name, r.calls, r.total * 1e-9,
+           r.total * 1e-6 / r.calls);
+  }
+  fflush(stdout);
+}
+
+// Print the roofline report of the counted stages and append them to the CSV file
+static void reportRoofline() {
+  lock_guard<mutex> guard(g_lock);
+  const char *env_bw = getenv("SCSC_PEAK_GBS"), *env_flop = getenv("SCSC_PEAK_GFLOPS");
+  const double peak_bw   = env_bw   ? atof(env_bw)   : 0.0;
+  const double peak_flop = env_flop ? atof(env_flop) : 0.0;
+
+  printf("\nRoofline: %d stages", int(g_stage.size()));
+  if ( peak_bw > 0.0 && peak_flop > 0.0 ) {
+    printf(" (peaks %g GB/s, %g GFLOP/s; ridge %.3g flop/byte)", peak_bw, peak_flop, peak_flop / peak_bw);
+  }
+  printf("\n  %-28s %10s %9s %9s %9s %6s %11s %11s  %s\n", "Stage", "Time (s)", "GB/s", "GFLOP/s", "Flop/B", "IPC",
+         "LLC misses", "Br. misses", "Bound");
+  for ( const StageRecord &r : g_stage ) {
+    const double *c = r.perf.count;
+    const bool   work = (r.bytes > 0.0);
+    const double bw   = work ? r.bytes / r.time * 1e-9 : -1.0;
+    const double flop = work ? r.flops / r.time * 1e-9 : -1.0;
+    const double ai   = work ? r.flops / r.bytes : -1.0;
+    const double ipc  = (c[int(PerfEvent::CYCLES)] > 0.0 && c[int(PerfEvent::INSTRUCTIONS)] >= 0.0) ?
+                        c[int(PerfEvent::INSTRUCTIONS)] / c[int(PerfEvent::CYCLES)] : -1.0;
+
+    // The attainable rate is min(peak flops, intensity * peak bandwidth)
+    string bound = "-";
+    if ( work && peak_bw > 0.0 && peak_flop > 0.0 ) {
+      const bool memory = (ai * peak_bw < peak_flop);
+      const double reached = (r.flops > 0.0) ? flop / min(peak_flop, ai * peak_bw) : bw / peak_bw;
+      bound = string(memory ? "memory " : "compute ") + formatValue("%.0f%%", 100.0 * reached);
+    }
+    printf("  %-28s %10.6f %9s %9s %9s %6s %11s %11s  %s\n", r.label, r.time, formatValue("%.3g", bw).c_str(),
+           formatValue("%.3g", flop).c_str(), formatValue("%.3g", ai).c_str(), formatValue("%.2f", ipc).c_str(),
+           formatValue("%.3g", c[int(PerfEvent::LLC_MISSES)]).c_str(),
+           formatValue("%.3g", c[int(PerfEvent::BRANCH_MISSES)]).c_str(), bound.c_str());
+  }
+  fflush(stdout);
+
+  // One row per stage; the runs accumulate in the file
+  if ( g_csv != nullptr ) {
+    FILE *file = fopen(g_csv, "a");
+    if ( file == nullptr ) {
+      cerr << "Can not write the report " << g_csv << endl;
+    } else {
+      if ( ftell(file) == 0 ) {
+        fprintf(file, "stage,time,bytes,flops,gb_per_s,gflop_per_s,cycles,instructions,llc_misses,branch_misses\n");
+      }
+      for ( const StageRecord &r : g_stage ) {
+        fprintf(file, "\"%s\",%.9g,%.9g,%.9g,%.6g,%.6g", r.label, r.time, r.bytes, r.flops,
+                r.bytes / r.time * 1e-9, r.flops / r.time * 1e-9);
+        for ( const double count : r.perf.count ) {
+          fprintf(file, (count >= 0.0) ? ",%.9g" : ",", count);
+        }
+        fprintf(file, "\n");
+      }
+      if ( fclose(file) != 0 ) {
+        cerr << "Can not write the report " << g_csv << endl;
+      }
+    }
+  }
+}
+
+// Print the peak and the retained memory of the stages
+static void reportMemory() {
+  lock_guard<mutex> guard(g_lock);
+  const double mib = 1.0 / (1 << 20);
+
+  // The change from a to b; may be negative, so that "-" marks the missing values only
+  auto change = [=]( const double a, const double b ) -> string {
+    if ( a < 0.0 || b < 0.0 ) {
+      return "-";
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", (b-a) * mib);
+    return buf;
+  };
+  printf("\nMemory (MiB): the peak and the retained growth of the live bytes (new and workspaces) and of the RSS\n");
+  printf("  %-28s %10s %10s %10s %10s %10s\n", "Stage", "Peak", "Growth", "Retained", "Peak RSS", "Retained");
+  for ( const StageRecord &r : g_stage ) {
+    const MemorySample &b = r.mem_begin, &e = r.mem_end;
+    printf("  %-28s %10s %10s %10s %10s %10s\n", r.label, formatValue("%.2f", e.peak * mib).c_str(),
+           change(b.live, e.peak).c_str(), change(b.live, e.live).c_str(), formatValue("%.2f", e.peak_rss * mib).c_str(),
+           change(b.rss, e.rss).c_str());
+  }
+  fflush(stdout);
+}
+
+int64_t profileClock() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void startProfile(
+    const char *path
+) {
+#ifdef SCSC_USE_PROFILER
+  lock_guard<mutex> guard(g_lock);
+  g_path   = path;
+  g_origin = profileClock();
+  g_on.store(true);
+#else  // SCSC_USE_PROFILER
+  cerr << "The profile " << path << " is not recorded; built without SCSC_USE_PROFILER." << endl;
+#endif  // SCSC_USE_PROFILER
+}
+
+bool profiling() {
+  return g_on.load(memory_order_relaxed);
+}
+
+void startPerfReport(
+    const char *path
+) {
+#ifdef SCSC_USE_PROFILER
+  {
+    lock_guard<mutex> guard(g_lock);
+    g_csv = path;
+  }
+  g_count.store(true);
+  if ( !startPerfCounters() ) {
+    cerr << "The hardware counters are not available; only the work of each stage is counted." << endl;
+  }
+#else  // SCSC_USE_PROFILER
+  static_cast<void>(path);
+  cerr << "The stages are not counted; built without SCSC_USE_PROFILER." << endl;
+#endif  // SCSC_USE_PROFILER
+}
+
+void profileWork(
+    const double bytes,
+    const double flops
+) {
+  if ( g_count.load(memory_order_relaxed) ) {
+    g_bytes.fetch_add(int64_t(bytes), memory_order_relaxed);
+    g_flops.fetch_add(int64_t(flops), memory_order_relaxed);
+  }
+}
+
+void startMemoryReport() {
+  if ( !startMemoryTracking() ) {
+    cerr << "The live bytes are not tracked; built without SCSC_TRACK_NEW or glibc. Only the RSS is sampled." << endl;
+  }
+}
+
+void finishProfile() {
+  if ( g_on.exchange(false) && g_path != nullptr ) {
+    reportZones();
+  }
+  const bool memory = memoryTracking();
+  stopMemoryTracking();
+  if ( g_count.exchange(false) ) {
+    reportRoofline();
+  }
+  if ( memory ) {
+    reportMemory();
+  }
+  lock_guard<mutex> guard(g_lock);
+  g_stage.clear();
+}
+
+ProfileZone::ProfileZone(
+    const char *name
+) : name_(name), begin_(profiling() ? beginZone() : -1) {}
+
+ProfileZone::~ProfileZone() {
+  if ( begin_ >= 0 ) {
+    endZone(name_, begin_);
+  }
+}
+
+ProfileStage::ProfileStage(
+    const bool print
+) : label_(nullptr), print_(print), recorded_(false), counted_(false), begin_(-1), bytes_(0.0), flops_(0.0) {}
+
+ProfileStage::ProfileStage(
+    const char *label,
+    const bool  print
+) : ProfileStage(print) {
+  start(label);
+}
+
+ProfileStage::~ProfileStage() {
+  if ( label_ != nullptr ) {
+    if ( uncaught_exception() ) {
+      fail();
+    } else {
+      stop();
+    }
+  }
+}
+
+void ProfileStage::fail() {
+  if ( recorded_ ) {
+    endZone(label_, begin_);
+  }
+  if ( print_ ) {
+    cout << " Failed." << endl;
+  }
+  label_ = nullptr;
+}
+
+void ProfileStage::start(
+    const char *label
+) {
+  label_ = label;
+  if ( print_ ) {
+    const int ndot = max(3, 39 - int(strlen(label)));
+    cout << label << ' ';
+    for ( int i = 0; i < ndot; ++i ) {
+      cout << '.';
+    }
+    cout << flush;
+  }
+  counted_ = print_ && (g_count.load() || memoryTracking());
+  if ( counted_ ) {
+    bytes_ = g_bytes.load();
+    flops_ = g_flops.load();
+    readPerfCounters(perf_);
+    readMemory(mem_, true);
+  }
+  recorded_ = profiling();
+  begin_ = recorded_ ? beginZone() : profileClock();
+}
+
+double ProfileStage::stop() {
+  const double time = (profileClock() - begin_) * 1e-9;
+  if ( recorded_ ) {
+    endZone(label_, begin_);
+  }
+  if ( print_ ) {
+    recordStageStats(label_, time);
+  }
+  string desc;
+  if ( counted_ ) {
+    StageRecord r = {label_, time, g_bytes.load() - bytes_, g_flops.load() - flops_, PerfSample(), mem_, MemorySample()};
+    readMemory(r.mem_end);
+    readPerfCounters(r.perf);
+    for ( int k = 0; k < int(PerfEvent::COUNT); ++k ) {
+      r.perf.count[k] = (r.perf.count[k] >= 0.0) ? max(r.perf.count[k] - max(perf_.count[k], 0.0), 0.0) : -1.0;
+    }
+    desc = describeStage(r);
+    lock_guard<mutex> guard(g_lock);
+    g_stage.push_back(r);
+  }
+  if ( print_ ) {
+    cout << " Done.  Elapsed time is " << time << " seconds." << desc << endl;
+  }
+  label_ = nullptr;
+  return time;
+}
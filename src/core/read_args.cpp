@@ -6,69 +6,203 @@
 /// @author  Yuhsiang Tsai <<yhmtsai@gmail.com>>
 ///
 
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <harmonic.hpp>
 #include <getopt.h>
 
 using namespace std;
 
-const char* const short_opt = "hf:t:o:";
-
-const struct option long_opt[] = {
-  {"help",   0, NULL, 'h'},
-  {"file",   1, NULL, 'f'},
-  {"type",   1, NULL, 't'},
-  {"output", 1, NULL, 'o'},
-  {NULL,     0, NULL, 0}
+// The options; the usage lines are displayed in this order
+static const struct {
+  struct option  opt;
+  const char    *usage;
+} kOption[] = {
+  {{"help",      0, NULL, 'h'},
+   "  -h,       --help             Display this information"},
+  {{"file",      1, NULL, 'f'},
+   "  -f<file>, --file <file>      The graph file"},
+  {{"type",      1, NULL, 't'},
+   "  -t<num>,  --type <num>       0: KIRCHHOFF(default), 1: COTANGENT"},
+  {{"output",    1, NULL, 'o'},
+   "  -o<file>, --output <file>    The output file"},
+  {{"guess",     1, NULL, 'g'},
+   "  -g<file>, --guess <file>     The initial guess (a previous output file)"},
+  {{"compare",   0, NULL, 'z'},
+   "  -z,       --compare          With -g, also solve from zero (not timed) to report the iterations saved"},
+  {{"cache",     1, NULL, 'c'},
+   "  -c<dir>,  --cache <dir>      The factorization cache directory"},
+  {{"precision", 1, NULL, 'p'},
+   "  -p<num>,  --precision <num>  0: DOUBLE(default), 1: MIXED (single precision factorization, refined)"},
+  {{"krylov",    1, NULL, 'k'},
+   "  -k<num>,  --krylov <num>     0: CG(default), 1: PIPELINED, 2: SSTEP"},
+  {{"log",       1, NULL, 'l'},
+   "  -l<file>, --log <file>       The convergence history of iterative solvers (JSON if *.json, else CSV)"},
+  {{"solver",    1, NULL, 's'},
+   "  -s<name>, --solver <name>    The solver backend (an unknown name lists the available ones)"},
+  {{"precond",   1, NULL, 'm'},
+   "  -m<num>,  --precond <num>    0: NONE, 1: JACOBI(default)"},
+  {{"tol",       1, NULL, 'e'},
+   "  -e<num>,  --tol <num>        The tolerance of the relative residual of iterative solvers (default 1e-10)"},
+  {{"stream",    0, NULL, 'S'},
+   "  -S,       --stream           Compute the edge data of the Laplacian while reading"},
+  {{"stats",     1, NULL, 'j'},
+   "  -j<fmt>,  --stats <fmt>      The run statistics: json (to the standard output, the progress to stderr) or a *.json file"},
+  {{"serve",     1, NULL, 'd'},
+   "  -d<sock>, --serve <sock>     Serve the meshes sent to the Unix socket, keeping them warm"},
+  {{"connect",   1, NULL, 'r'},
+   "  -r<sock>, --connect <sock>   Send the mesh to the service on the Unix socket instead of mapping it here"},
+  {{"budget",    1, NULL, 'b'},
+   "  -b<num>,  --budget <num>     The memory budget of the meshes kept by the service, in MiB (default 1024)"},
+  {{"inline",    0, NULL, 'i'},
+   "  -i,       --inline           Send the mesh itself to the service instead of its path"},
 };
 
+// Whether the option is supported
+static bool isAccepted( const char *accept, const int c ) { return c == 'h' || strchr(accept, c) != nullptr; }
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief  Display the usage.
 ///
-/// @param  bin  the name of binary file.
+/// @param  bin     the name of binary file.
+/// @param  accept  the short names of the supported options.
 ///
-void dispUsage( const char *bin ) {
+static void dispUsage( const char *bin, const char *accept ) {
   cout << "Usage: " << bin << " [OPTIONS]" << endl;
   cout << "Options:" << endl;
-  cout << "  -h,       --help           Display this information" << endl;
-  cout << "  -f<file>, --file <file>    The graph file" << endl;
-  cout << "  -t<num>,  --type <num>     0: KIRCHHOFF(default), 1: COTANGENT" << endl;
-  cout << "  -o<file>, --output <file>  The output file" << endl;
+  for ( const auto &entry : kOption ) {
+    if ( isAccepted(accept, entry.opt.val) ) {
+      cout << entry.usage << endl;
+    }
+  }
 }
 
-void readArgs( int argc, char** argv, const char *&input, const char *&output, Method &method ) {
-  char c = 0;
-  while ( (c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1 ) {
+void readArgs( int argc, char** argv, const char *accept, Arguments &args ) {
+
+  // Build the supported options
+  string short_opt;
+  vector<struct option> long_opt;
+  for ( const auto &entry : kOption ) {
+    if ( isAccepted(accept, entry.opt.val) ) {
+      short_opt += char(entry.opt.val);
+      if ( entry.opt.has_arg ) {
+        short_opt += ':';
+      }
+      long_opt.push_back(entry.opt);
+    }
+  }
+  long_opt.push_back({NULL, 0, NULL, 0});
+
+  int c = 0;
+  while ( (c = getopt_long(argc, argv, short_opt.c_str(), long_opt.data(), NULL)) != -1 ) {
     switch ( c ) {
       case 'h': {
-        dispUsage(argv[0]);
+        dispUsage(argv[0], accept);
         exit(0);
       }
 
       case 'f': {
-        input = optarg;
+        args.input = optarg;
         break;
       }
 
       case 't': {
-        method = static_cast<Method>(atoi(optarg));
-        assert(method >= Method::KIRCHHOFF && method < Method::COUNT );
+        args.method = static_cast<Method>(atoi(optarg));
+        assert(args.method >= Method::KIRCHHOFF && args.method < Method::COUNT );
         break;
       }
 
       case 'o': {
-        output = optarg;
+        args.output = optarg;
+        break;
+      }
+
+      case 'g': {
+        args.guess = optarg;
+        break;
+      }
+
+      case 'z': {
+        args.compare = true;
+        break;
+      }
+
+      case 'c': {
+        args.cache = optarg;
+        break;
+      }
+
+      case 'p': {
+        args.options.precision = static_cast<Precision>(atoi(optarg));
+        assert(args.options.precision >= Precision::DOUBLE && args.options.precision < Precision::COUNT );
+        break;
+      }
+
+      case 'k': {
+        args.options.krylov = static_cast<Krylov>(atoi(optarg));
+        assert(args.options.krylov >= Krylov::CG && args.options.krylov < Krylov::COUNT );
+        break;
+      }
+
+      case 'l': {
+        args.log = optarg;
+        break;
+      }
+
+      case 's': {
+        args.options.solver = optarg;
+        break;
+      }
+
+      case 'm': {
+        args.options.precond = static_cast<Precond>(atoi(optarg));
+        assert(args.options.precond >= Precond::NONE && args.options.precond < Precond::COUNT );
+        break;
+      }
+
+      case 'e': {
+        args.options.tol = atof(optarg);
+        assert(args.options.tol > 0.0);
+        break;
+      }
+
+      case 'S': {
+        args.stream = true;
         break;
       }
 
-      case ':': {
-        cout << "Option -" << c << " requires an argument.\n";
-        abort();
+      case 'j': {
+        args.stats = optarg;
+        break;
+      }
+
+      case 'd': {
+        args.service.serve = optarg;
+        break;
+      }
+
+      case 'r': {
+        args.service.connect = optarg;
+        break;
+      }
+
+      case 'b': {
+        args.service.budget = atol(optarg);
+        assert(args.service.budget > 0);
+        break;
+      }
+
+      case 'i': {
+        args.service.send = true;
+        break;
       }
 
-      case '?': {
-        cout << "Unknown option -" << c << endl;
-        abort();
+      default: {
+        // getopt_long has reported the unsupported option or the missing argument
+        dispUsage(argv[0], accept);
+        exit(1);
       }
     }
   }
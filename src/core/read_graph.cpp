@@ -16,7 +16,6 @@ int readGraph(char *input, int **E, int *E_size){
 	std::fstream pfile;
 	int count = 0, n = 0;
 	int *a, *b;
-	int tmp;
 
 	pfile.open(input,std::ios::in);
     assert( pfile );
@@ -6,73 +6,64 @@
 /// @author  Yuhisang Mike Tsai
 ///
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <harmonic.hpp>
+#include <profiler.hpp>
+#include <simd.hpp>
 using namespace std;
 
-void readObject(
+// The number of values of the first vertex; 3 without color, 6 with color
+static int countValues( ifstream &fin, const char *input ) {
+  // Skip until first vertex
+  while ( fin.peek() != 'v' ) {
+    if ( !fin.ignore(4096, '\n') || fin.peek() == EOF ) {
+      throw HarmonicError(ErrorCode::FORMAT, string("No vertex in \"") + input + "\"!");
+    }
+  }
+  fin.get();
+
+  // Read first vertex
+  string str;
+  getline(fin, str);
+  istringstream sin(str);
+  double v;
+  int count = 0;
+  while (sin >> v) {
+    ++count;
+  }
+  return count;
+}
+
+void scanObject(
     const char *input,
     int *ptr_nv,
-    int *ptr_nf,
-    double **ptr_V,
-    double **ptr_C,
-    int **ptr_F
+    int *ptr_nf
 ) {
 
   int &nv = *ptr_nv;
   int &nf = *ptr_nf;
-  bool mode = 0; // 0: No color; 1: With color
 
-  // CR to LF
-  {
-    stringstream buffer;
-    buffer << "dos2unix " << input;
-    int info = system(buffer.str().c_str());
-    if ( info ) {
-      cerr << "Unable to convert file \"" << input << "\"!" << endl;
-    }
-  }
-
-  // Open file
+  // Open file; the CR of CRLF line ends is skipped as white space, so the file is read as is
   ifstream fin(input);
   if ( fin.fail() ) {
-    cerr << "Unable to open file \"" << input << "\"!" << endl;
-    abort();
+    throw HarmonicError(ErrorCode::IO, string("Unable to open file \"") + input + "\"!");
   }
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   // Determine vertex mode
   {
-    // Skip until first vertex
-    while ( fin.peek() != 'v' ) {
-      fin.ignore(4096, '\n');
-    }
-    fin.get();
-
-    // Read first vertex
-    string str;
-    getline(fin, str);
-    istringstream sin(str);
-    double v;
-    int count = 0;
-    while (sin >> v) {
-      ++count;
-    }
-
-    // Determine mode
+    const int count = countValues(fin, input);
     if ( count == 3 ) {
-      mode = 0;
       cout << "Loads from \"" << input << "\" without color." << endl;
     } else if ( count == 6 ) {
-      mode = 1;
       cout << "Loads from \"" << input << "\" with color." << endl;
     } else {
-      cerr << "Unable to load vertex: the number of values must be 3 or 6!" << endl;
-      abort();
+      throw HarmonicError(ErrorCode::FORMAT, "Unable to load vertex: the number of values must be 3 or 6!");
     }
   }
 
@@ -80,14 +71,52 @@ void readObject(
   // Count vertices and faces
   fin.clear();
   fin.seekg(0, ios::beg);
-  nv = 0; nf = 0;
-  while ( !fin.eof() ) {
-    char c = fin.peek();
-    if ( c == 'v' ) { ++nv; }
-    else if ( c == 'f' ) { ++nf; }
-    fin.ignore(4096, '\n');
+  {
+    static const int kBlock = 1 << 16;
+    char *block = new char[kBlock];
+    long count_v = 0, count_f = 0;
+    char prev = '\n';
+    while ( fin.read(block, kBlock) || fin.gcount() > 0 ) {
+      const long len = fin.gcount();
+      simd().countLines(block, len, prev, &count_v, &count_f);
+      prev = block[len-1];
+    }
+    delete[] block;
+    nv = count_v; nf = count_f;
   }
   cout << "\"" << input << "\" contains " << nv << " vertices and " << nf << " faces." << endl;
+}
+
+void readObject(
+    const char *input,
+    const int nv,
+    const int nf,
+    double *V,
+    double *C,
+    int *F
+) {
+  readObject(input, nv, nf, V, C, F, nf, nullptr, nullptr);
+}
+
+void readObject(
+    const char *input,
+    const int nv,
+    const int nf,
+    double *V,
+    double *C,
+    int *F,
+    const int batch,
+    FaceBatch emit,
+    void *context
+) {
+  SCSC_PROFILE_ZONE("read object");
+
+  // Open file
+  ifstream fin(input);
+  if ( fin.fail() ) {
+    throw HarmonicError(ErrorCode::IO, string("Unable to open file \"") + input + "\"!");
+  }
+  bool mode = (countValues(fin, input) == 6); // 0: No color; 1: With color
 
   ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   // Read vertex and faces
@@ -96,27 +125,35 @@ void readObject(
   fin.clear();
   fin.seekg(0, ios::beg);
 
-  *ptr_V = new double[3*nv];
-  *ptr_C = new double[3*nv];
-  *ptr_F = new int[3*nf];
+  double *Vx = V;
+  double *Vy = V+nv;
+  double *Vz = V+2*nv;
 
-  double *Vx = *ptr_V;
-  double *Vy = *ptr_V+nv;
-  double *Vz = *ptr_V+2*nv;
+  double *Cx = C;
+  double *Cy = C+nv;
+  double *Cz = C+2*nv;
 
-  double *Cx = *ptr_C;
-  double *Cy = *ptr_C+nv;
-  double *Cz = *ptr_C+2*nv;
+  int *F1 = F;
+  int *F2 = F+nf;
+  int *F3 = F+2*nf;
 
-  int *F1 = *ptr_F;
-  int *F2 = *ptr_F+nf;
-  int *F3 = *ptr_F+2*nf;
+  // A malformed line (or a file changed since scanObject) would leave the stream failed or overrun the arrays
+  long line = 0;
+  auto fail = [&]( const char *what ) {
+    throw HarmonicError(ErrorCode::FORMAT, string("Unable to load \"") + input + "\": " + what + " (line " +
+                        to_string(line) + ")!");
+  };
 
+  int nf_emit = 0;
   while ( !fin.eof() ) {
     char c = fin.peek();
+    ++line;
 
     // Read vertex
     if ( c == 'v' ) {
+      if ( Vx - V == nv ) {
+        fail("more vertices than counted");
+      }
       fin.get();
       if ( mode == 0 ) {
         fin >> *Vx++ >> *Vy++ >> *Vz++;
@@ -127,16 +164,59 @@ void readObject(
 
     // Read face
     if ( c == 'f' ) {
+      if ( F1 - F == nf ) {
+        fail("more faces than counted");
+      }
       fin.get();
       fin >> *F1++ >> *F2++ >> *F3++;
     }
 
+    if ( fin.fail() ) {
+      fail("the values can not be parsed");
+    }
+    if ( c == 'f' && (min(F1[-1], min(F2[-1], F3[-1])) < 1 || max(F1[-1], max(F2[-1], F3[-1])) > nv) ) {
+      fail("the face refers to no vertex");
+    }
     fin.ignore(4096, '\n');
+
+    // Hand over a full batch
+    const int nf_read = F1 - F;
+    if ( emit != nullptr && nf_read - nf_emit == batch ) {
+      emit(context, nf_emit, nf_read, Vx - V);
+      nf_emit = nf_read;
+    }
+  }
+
+  // Hand over the last batch
+  if ( emit != nullptr && F1 - F > nf_emit ) {
+    emit(context, nf_emit, F1 - F, Vx - V);
   }
 
   if ( mode == 0 ) {
     for ( int i = 0; i < 3*nv; ++i ) {
-      (*ptr_C)[i] = -1.0;
+      C[i] = -1.0;
     }
   }
 }
+
+void readObject(
+    const char *input,
+    int *ptr_nv,
+    int *ptr_nf,
+    double **ptr_V,
+    double **ptr_C,
+    int **ptr_F
+) {
+  scanObject(input, ptr_nv, ptr_nf);
+  *ptr_V = new double[3 * *ptr_nv];
+  *ptr_C = new double[3 * *ptr_nv];
+  *ptr_F = new int[3 * *ptr_nf];
+  try {
+    readObject(input, *ptr_nv, *ptr_nf, *ptr_V, *ptr_C, *ptr_F);
+  } catch ( ... ) {
+    delete[] *ptr_V;
+    delete[] *ptr_C;
+    delete[] *ptr_F;
+    throw;
+  }
+}
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    reorder_band.cpp
+/// @brief   The implementation of bandwidth-reducing vertex reordering.
+///
+
+#include <algorithm>
+#include <cstdlib>
+#include <harmonic.hpp>
+using namespace std;
+
+void reorderBand(
+    const int nv,
+    const int nb,
+    const int nf,
+    double *V,
+    double *C,
+    int *F,
+    int *ptr_bw,
+    int *ptr_nr
+) {
+  const int ni = nv-nb;
+  int &bw = *ptr_bw;
+  int &nr = *ptr_nr;
+
+  // ====================================================================================================================== //
+  // Build the vertex adjacency (CSR, zero-based, without duplicates)
+
+  int *adj_ptr = new int[nv+1], *adj = new int[6*nf], *pos = new int[nv];
+  fill(adj_ptr, adj_ptr+nv+1, 0);
+  for ( int i = 0; i < 3*nf; ++i ) {
+    adj_ptr[F[i]] += 2;
+  }
+  for ( int i = 0; i < nv; ++i ) {
+    adj_ptr[i+1] += adj_ptr[i];
+  }
+  copy(adj_ptr, adj_ptr+nv, pos);
+  for ( int i = 0; i < nf; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      int a = F[k*nf+i]-1, b = F[((k+1)%3)*nf+i]-1;
+      adj[pos[a]++] = b;
+      adj[pos[b]++] = a;
+    }
+  }
+  int nnz = 0;
+  for ( int i = 0; i < nv; ++i ) {
+    int *begin = adj+adj_ptr[i], *end = adj+adj_ptr[i+1];
+    sort(begin, end);
+    end = unique(begin, end);
+    adj_ptr[i] = nnz;
+    for ( int *p = begin; p < end; ++p ) {
+      adj[nnz++] = *p;
+    }
+  }
+  adj_ptr[nv] = nnz;
+
+  // ====================================================================================================================== //
+  // Cuthill-McKee ordering of the interior vertices, seeded by the interior neighbours of the boundary (in boundary order)
+
+  int *order = new int[ni], *buf = new int[nv];
+  bool *visited = new bool[nv];
+  fill(visited, visited+nb, true);
+  fill(visited+nb, visited+nv, false);
+
+  auto degree = [=]( const int i ) { return adj_ptr[i+1]-adj_ptr[i]; };
+  int count = 0;
+  auto visit = [&]( const int i ) {
+    int m = 0;
+    for ( int j = adj_ptr[i]; j < adj_ptr[i+1]; ++j ) {
+      if ( !visited[adj[j]] ) {
+        visited[adj[j]] = true;
+        buf[m++] = adj[j];
+      }
+    }
+    stable_sort(buf, buf+m, [&]( const int a, const int b ) { return degree(a) < degree(b); });
+    copy(buf, buf+m, order+count);
+    count += m;
+  };
+
+  for ( int i = 0; i < nb; ++i ) {
+    visit(i);
+  }
+  nr = count;
+  for ( int head = 0; count < ni; ++head ) {
+    if ( head == count ) {
+      // An interior component not attached to the boundary; restart from its vertex of minimum degree
+      int s = -1;
+      for ( int i = nb; i < nv; ++i ) {
+        if ( !visited[i] && (s < 0 || degree(i) < degree(s)) ) {
+          s = i;
+        }
+      }
+      visited[s] = true;
+      order[count++] = s;
+    }
+    visit(order[head]);
+  }
+
+  // ====================================================================================================================== //
+  // Reverse the ordering, so that the boundary neighbours become the last nr interior vertices
+
+  int *used = new int[nv];
+  for ( int i = 0; i < nb; ++i ) {
+    used[i] = i;
+  }
+  for ( int k = 0; k < ni; ++k ) {
+    used[order[k]] = nv-1-k;
+  }
+
+  double *V_cp = new double[nv*3], *C_cp = new double[nv*3];
+  copy(V, V+nv*3, V_cp);
+  copy(C, C+nv*3, C_cp);
+  for ( int i = nb; i < nv; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      V[k*nv+used[i]] = V_cp[k*nv+i];
+      C[k*nv+used[i]] = C_cp[k*nv+i];
+    }
+  }
+  for ( int i = 0; i < nf*3; ++i ) {
+    F[i] = used[F[i]-1]+1;
+  }
+
+  // Bandwidth of the interior block
+  bw = 0;
+  for ( int i = nb; i < nv; ++i ) {
+    for ( int j = adj_ptr[i]; j < adj_ptr[i+1]; ++j ) {
+      if ( adj[j] >= nb ) {
+        bw = max(bw, abs(used[i]-used[adj[j]]));
+      }
+    }
+  }
+
+  delete[] adj_ptr;
+  delete[] adj;
+  delete[] pos;
+  delete[] order;
+  delete[] buf;
+  delete[] visited;
+  delete[] used;
+  delete[] V_cp;
+  delete[] C_cp;
+}
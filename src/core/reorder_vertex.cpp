@@ -8,6 +8,8 @@
 #include <harmonic.hpp>
 #include <iostream>
 #include <algorithm>
+#include <thread_pool.hpp>
+#include <workspace.hpp>
 using namespace std;
 
 void reorderVertex(
@@ -17,49 +19,50 @@ void reorderVertex(
     double *V,
     double *C,
     int *F,
-    const int *idx_b
+    const int *idx_b,
+    Workspace *work
 ) {
-  double *V_cp = new double [nv*3], *C_cp = new double [nv*3];
-  int *used = new int [nv];
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  double *V_cp = ws.take<double>(nv*3), *C_cp = ws.take<double>(nv*3);
+  int *used = ws.take<int>(nv);
   for (int i=0; i<nv; i++){
     used[i]=-1;
   }
   copy(V, V+nv*3, V_cp);
   copy(C, C+nv*3, C_cp);
   for (int i=0; i<nb; i++){
-    V[i]=V_cp[idx_b[i]-1];
-    V[nv+i]=V_cp[nv+idx_b[i]-1];
-    V[2*nv+i]=V_cp[2*nv+idx_b[i]-1];
-    C[i]=C_cp[idx_b[i]-1];
-    C[nv+i]=C_cp[nv+idx_b[i]-1];
-    C[2*nv+i]=C_cp[2*nv+idx_b[i]-1];
     used[idx_b[i]-1]=i;
-    // if (idx_b[i]-1>=nv){
-      // cout<<idx_b[i]<<"Q\n";
-    // }
   }
   int index=nb;
-  // cout << nb<<"T\n";
   for (int i=0; i<nv; i++){
     if (used[i]==-1){
-      V[index]=V_cp[i];
-      V[nv+index]=V_cp[nv+i];
-      V[2*nv+index]=V_cp[2*nv+i];
-      C[index]=C_cp[i];
-      C[nv+index]=C_cp[nv+i];
-      C[2*nv+index]=C_cp[2*nv+i];
       used[i]=index;
       index++;
     }
   }
-  for (int i=0; i<nf*3; i++){
-    F[i]=used[F[i]-1]+1;
-  }
   if (index!=nv){
-    cerr<<index<<" Reorder Error"<<nv<<"\n";
+    ws.release(top);
+    throw HarmonicError(ErrorCode::INTERNAL, "reorderVertex: " + to_string(index) + " of " + to_string(nv) +
+                        " vertices are ordered");
   }
-  delete [] V_cp;
-  delete [] C_cp;
-  delete [] used;
+  parallelFor(0, nv, 4096, [=](int begin, int end){
+    for (int i=begin; i<end; i++){
+      const int j=used[i];
+      V[j]=V_cp[i];
+      V[nv+j]=V_cp[nv+i];
+      V[2*nv+j]=V_cp[2*nv+i];
+      C[j]=C_cp[i];
+      C[nv+j]=C_cp[nv+i];
+      C[2*nv+j]=C_cp[2*nv+i];
+    }
+  });
+  parallelFor(0, nf*3, 4096, [=](int begin, int end){
+    for (int i=begin; i<end; i++){
+      F[i]=used[F[i]-1]+1;
+    }
+  });
+  ws.release(top);
   return;
 }
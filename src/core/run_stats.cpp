@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    run_stats.cpp
+/// @brief   The implementation of the machine-readable run statistics.
+///
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <run_stats.hpp>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif  // __linux__
+using namespace std;
+
+// A stage and its time
+struct StageTime {
+  const char *label;
+  double      time;
+};
+
+static mutex              g_lock;            // guards the following
+static vector<StageTime>  g_stage;           // the stages so far
+static const char        *g_path = nullptr;  // the output; null if not collecting
+static FILE              *g_json = nullptr;  // the standard output, once the progress is sent to the standard error
+
+// Write a JSON number; null if not known (negative)
+static void writeNumber( FILE *file, const char *format, const double value ) {
+  if ( value < 0.0 ) {
+    fputs("null", file);
+  } else {
+    fprintf(file, format, value);
+  }
+}
+
+// The peak resident set size of the process, in bytes; negative if not available
+static double peakRss() {
+#ifdef __linux__
+  rusage usage;
+  return (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss * 1024.0 : -1.0;  // in KiB on Linux
+#else  // __linux__
+  return -1.0;
+#endif  // __linux__
+}
+
+void writeJsonString(
+    FILE       *file,
+    const char *str
+) {
+  if ( str == nullptr ) {
+    fputs("null", file);
+    return;
+  }
+  fputc('"', file);
+  for ( ; *str != '\0'; ++str ) {
+    const unsigned char c = *str;
+    switch ( c ) {
+      case '"':  fputs("\\\"", file); break;
+      case '\\': fputs("\\\\", file); break;
+      case '\b': fputs("\\b", file); break;
+      case '\f': fputs("\\f", file); break;
+      case '\n': fputs("\\n", file); break;
+      case '\r': fputs("\\r", file); break;
+      case '\t': fputs("\\t", file); break;
+      default: {
+        if ( c < 0x20 ) {
+          fprintf(file, "\\u%04x", c);
+        } else {
+          fputc(c, file);
+        }
+      }
+    }
+  }
+  fputc('"', file);
+}
+
+void startStats(
+    const char *path
+) {
+  lock_guard<mutex> guard(g_lock);
+  g_path = path;
+  g_stage.clear();
+
+  // Send the progress to the standard error, so that the standard output holds only the JSON
+  if ( strcmp(path, "json") == 0 && g_json == nullptr ) {
+    cout.flush();
+    fflush(stdout);
+    const int fd = dup(STDOUT_FILENO);
+    if ( fd >= 0 && (g_json = fdopen(fd, "w")) != nullptr ) {
+      dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+  }
+}
+
+bool collectingStats() {
+  lock_guard<mutex> guard(g_lock);
+  return g_path != nullptr;
+}
+
+void recordStageStats(
+    const char  *label,
+    const double time
+) {
+  lock_guard<mutex> guard(g_lock);
+  if ( g_path != nullptr ) {
+    g_stage.push_back({label, time});
+  }
+}
+
+bool finishStats(
+    const RunStats &stats
+) {
+  lock_guard<mutex> guard(g_lock);
+  if ( g_path == nullptr ) {
+    return true;
+  }
+  const bool out = (strcmp(g_path, "json") == 0);
+  FILE *file = out ? (g_json != nullptr ? g_json : stdout) : fopen(g_path, "w");
+  if ( file == nullptr ) {
+    cerr << "Can not write the statistics " << g_path << endl;
+    g_path = nullptr;
+    return false;
+  }
+  fflush(stdout);
+
+  // The lower triangle of Lii holds its diagonal and half of the rest
+  const long nnz_lower = (stats.nnz_lii >= 0 && stats.nv >= 0 && stats.nb >= 0)
+                       ? (stats.nnz_lii + stats.nv - stats.nb) / 2 : -1;
+  const long fill_in = (stats.nnz_factor >= 0 && nnz_lower >= 0) ? stats.nnz_factor - nnz_lower : -1;
+
+  fprintf(file, "{\n  \"input\": ");
+  writeJsonString(file, stats.input);
+  fprintf(file, ",\n  \"method\": ");
+  writeJsonString(file, stats.method);
+  fprintf(file, ",\n  \"solver\": ");
+  writeJsonString(file, stats.solver);
+  const struct {
+    const char *name;
+    double      value;
+  } field[] = {
+    {"nv",               double(stats.nv)},
+    {"nf",               double(stats.nf)},
+    {"nb",               double(stats.nb)},
+    {"nnz_lii",          double(stats.nnz_lii)},
+    {"nnz_lib",          double(stats.nnz_lib)},
+    {"bandwidth",        double(stats.bw)},
+    {"factor_bandwidth", double(stats.factor_bw)},
+    {"factor_nnz",       double(stats.nnz_factor)},
+    {"fill_in",          double(fill_in)},
+    {"iterations",       double(stats.iter)},
+  };
+  for ( const auto &f : field ) {
+    fprintf(file, ",\n  \"%s\": ", f.name);
+    writeNumber(file, "%.0f", f.value);
+  }
+  fprintf(file, ",\n  \"residual\": ");
+  writeNumber(file, "%.9e", stats.res);
+
+  double total = 0.0;
+  fprintf(file, ",\n  \"stages\": [");
+  for ( size_t k = 0; k < g_stage.size(); ++k ) {
+    fprintf(file, "%s\n    {\"stage\": ", (k == 0) ? "" : ",");
+    writeJsonString(file, g_stage[k].label);
+    fprintf(file, ", \"time\": %.9e}", g_stage[k].time);
+    total += g_stage[k].time;
+  }
+  fprintf(file, "\n  ],\n  \"total_time\": %.9e,\n  \"peak_rss\": ", total);
+  writeNumber(file, "%.0f", peakRss());
+  fprintf(file, ",\n  \"held\": ");
+  writeNumber(file, "%.0f", stats.held);
+  fprintf(file, "\n}\n");
+
+  const bool ok = out ? (fflush(file) == 0) : (fclose(file) == 0);
+  if ( !ok ) {
+    cerr << "Can not write the statistics " << g_path << endl;
+  }
+  g_path = nullptr;
+  g_stage.clear();
+  return ok;
+}
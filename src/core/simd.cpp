@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    simd.cpp
+/// @brief   The implementation of the generic SIMD kernels and of the selection of the instruction set.
+///
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <simd.hpp>
+using namespace std;
+
+static void spmvGeneric( const int begin, const int end, const double *A_val, const int *A_row, const int *A_col,
+                         const double *x, double *y ) {
+  for ( int i = begin; i < end; ++i ) {
+    double sum = 0.0;
+    for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+      sum += A_val[j] * x[A_col[j]];
+    }
+    y[i] = sum;
+  }
+}
+
+static double dotGeneric( const int n, const double *x, const double *y ) {
+  double sum = 0.0;
+  for ( int i = 0; i < n; ++i ) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+static void axpyGeneric( const int n, const double a, const double *x, double *y ) {
+  for ( int i = 0; i < n; ++i ) {
+    y[i] += a * x[i];
+  }
+}
+
+static void xpbyGeneric( const int n, const double *x, const double b, double *y ) {
+  for ( int i = 0; i < n; ++i ) {
+    y[i] = x[i] + b * y[i];
+  }
+}
+
+// The weight of each corner is -0.5 * cot, i.e. -0.5 * (v' * b) / |v x b| of the edges v and b facing it
+static void cotangentGeneric( const int nv, const int nf, const double *V, const int *F, const int begin, const int end,
+                              double *W ) {
+  for ( int i = begin; i < end; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const int row = F[k*nf+i]-1, col = F[(k+1)%3*nf+i]-1, mid = F[(k+2)%3*nf+i]-1;
+      const double v[3] = {V[row]-V[mid], V[nv+row]-V[nv+mid], V[2*nv+row]-V[2*nv+mid]};
+      const double b[3] = {V[col]-V[mid], V[nv+col]-V[nv+mid], V[2*nv+col]-V[2*nv+mid]};
+      const double z[3] = {v[1]*b[2] - v[2]*b[1], v[2]*b[0] - v[0]*b[2], v[0]*b[1] - v[1]*b[0]};
+      const double dot = ((0.0 + v[0]*b[0]) + v[1]*b[1]) + v[2]*b[2];
+      W[k*nf+i] = -0.5*dot / sqrt(z[0]*z[0] + z[1]*z[1] + z[2]*z[2]);
+    }
+  }
+}
+
+static void countLinesGeneric( const char *buf, const long len, const char prev, long *nv, long *nf ) {
+  for ( long i = 0; i < len; ++i ) {
+    if ( (i == 0 ? prev : buf[i-1]) == '\n' ) {
+      *nv += (buf[i] == 'v');
+      *nf += (buf[i] == 'f');
+    }
+  }
+}
+
+static const SimdKernels kGeneric = {
+  Isa::GENERIC, spmvGeneric, dotGeneric, axpyGeneric, xpbyGeneric, cotangentGeneric, countLinesGeneric
+};
+
+static atomic<const SimdKernels*> g_kernels(&kGeneric);  // the selected kernels
+
+// Select the best instruction set, or the one SCSC_ISA names
+static struct SimdInit {
+  SimdInit() {
+    const char *env = getenv("SCSC_ISA");
+    if ( env != nullptr && env[0] != '\0' ) {
+      if ( selectIsa(findIsa(env)) ) {
+        return;
+      }
+      cerr << "The instruction set " << env << " is not supported; " << isaName(detectIsa()) << " is used." << endl;
+    }
+    selectIsa(detectIsa());
+  }
+} g_init;
+
+const SimdKernels *simdGeneric() {
+  return &kGeneric;
+}
+
+const SimdKernels &simd() {
+  return *g_kernels.load(memory_order_relaxed);
+}
+
+// The kernels of an instruction set if the CPU supports them
+static const SimdKernels *supported( const Isa isa ) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  switch ( isa ) {
+    case Isa::AVX2: {
+      const bool ok = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+      return ok ? simdAvx2() : nullptr;
+    }
+    case Isa::AVX512: {
+      const bool ok = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                      __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("fma");
+      return ok ? simdAvx512() : nullptr;
+    }
+    default: return (isa == Isa::GENERIC) ? &kGeneric : nullptr;
+  }
+#else  // __GNUC__ && x86
+  return (isa == Isa::GENERIC) ? &kGeneric : nullptr;
+#endif  // __GNUC__ && x86
+}
+
+bool selectIsa(
+    const Isa isa
+) {
+  const SimdKernels *kernels = supported(isa);
+  if ( kernels != nullptr ) {
+    g_kernels.store(kernels);
+  }
+  return kernels != nullptr;
+}
+
+Isa detectIsa() {
+  for ( int k = int(Isa::COUNT)-1; k > 0; --k ) {
+    if ( supported(Isa(k)) != nullptr ) {
+      return Isa(k);
+    }
+  }
+  return Isa::GENERIC;
+}
+
+const char *isaName(
+    const Isa isa
+) {
+  switch ( isa ) {
+    case Isa::GENERIC: return "generic";
+    case Isa::AVX2:    return "avx2";
+    case Isa::AVX512:  return "avx512";
+    default:           return "unknown";
+  }
+}
+
+Isa findIsa(
+    const char *name
+) {
+  for ( int k = 0; k < int(Isa::COUNT); ++k ) {
+    if ( strcmp(name, isaName(Isa(k))) == 0 ) {
+      return Isa(k);
+    }
+  }
+  return Isa::COUNT;
+}
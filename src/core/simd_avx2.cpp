@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    simd_avx2.cpp
+/// @brief   The implementation of the AVX2 SIMD kernels.
+///
+/// The kernels are compiled for AVX2 by a pragma after the headers, so that no inline function of the headers is
+/// compiled for AVX2 and picked by the linker for the whole program. The file is compiled with -ffp-contract=off; the
+/// multiply-adds are fused only where written.
+///
+
+#include <cmath>
+#include <simd.hpp>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCSC_SIMD_AVX2
+#endif  // __GNUC__ && x86
+
+#ifdef SCSC_SIMD_AVX2
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+// The lanes l < m of 4 lanes starting at lane l0
+static inline __m256i mask4( const int m, const int l0 ) {
+  return _mm256_cmpgt_epi64(_mm256_set1_epi64x(m), _mm256_setr_epi64x(l0, l0+1, l0+2, l0+3));
+}
+
+static inline __m128i mask4i( const int m, const int l0 ) {
+  return _mm_cmpgt_epi32(_mm_set1_epi32(m), _mm_setr_epi32(l0, l0+1, l0+2, l0+3));
+}
+
+// A full gather; the masked form, since the unmasked one reads an undefined source (GCC warns of it)
+static inline __m256d gather4( const double *base, const __m128i index ) {
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, index, all, 8);
+}
+
+// acc += val[l] * x[col[l]] of the lanes l0 <= l < min(m, l0+4); the others are left as is
+static inline __m256d gatherFma( const double *val, const int *col, const double *x, const int m, const int l0,
+                                 const __m256d acc ) {
+  if ( m >= l0+4 ) {
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col+l0));
+    return _mm256_fmadd_pd(_mm256_loadu_pd(val+l0), gather4(x, c), acc);
+  }
+  const __m256i mask = mask4(m, l0);
+  const __m128i c = _mm_maskload_epi32(col+l0, mask4i(m, l0));
+  const __m256d a = _mm256_maskload_pd(val+l0, mask);
+  const __m256d b = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, c, _mm256_castsi256_pd(mask), 8);
+  return _mm256_fmadd_pd(a, b, acc);
+}
+
+// Sum the lanes of two accumulators; lo holds the lanes 0 to 3
+static inline double sum8( const __m256d lo, const __m256d hi ) {
+  double lane[8];
+  _mm256_storeu_pd(lane, lo);
+  _mm256_storeu_pd(lane+4, hi);
+  return sumLanes(lane);
+}
+
+static void spmvAvx2( const int begin, const int end, const double *A_val, const int *A_row, const int *A_col,
+                      const double *x, double *y ) {
+  for ( int i = begin; i < end; ++i ) {
+    __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+    for ( int j = A_row[i]; j < A_row[i+1]; j += 8 ) {
+      const int m = A_row[i+1] - j;
+      lo = gatherFma(A_val+j, A_col+j, x, m, 0, lo);
+      if ( m > 4 ) {
+        hi = gatherFma(A_val+j, A_col+j, x, m, 4, hi);
+      }
+    }
+    y[i] = sum8(lo, hi);
+  }
+}
+
+static double dotAvx2( const int n, const double *x, const double *y ) {
+  __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+  int i = 0;
+  for ( ; i+8 <= n; i += 8 ) {
+    lo = _mm256_fmadd_pd(_mm256_loadu_pd(x+i),   _mm256_loadu_pd(y+i),   lo);
+    hi = _mm256_fmadd_pd(_mm256_loadu_pd(x+i+4), _mm256_loadu_pd(y+i+4), hi);
+  }
+  if ( i < n ) {
+    const __m256i mlo = mask4(n-i, 0), mhi = mask4(n-i, 4);
+    lo = _mm256_fmadd_pd(_mm256_maskload_pd(x+i, mlo),   _mm256_maskload_pd(y+i, mlo),   lo);
+    hi = _mm256_fmadd_pd(_mm256_maskload_pd(x+i+4, mhi), _mm256_maskload_pd(y+i+4, mhi), hi);
+  }
+  return sum8(lo, hi);
+}
+
+static void axpyAvx2( const int n, const double a, const double *x, double *y ) {
+  const __m256d va = _mm256_set1_pd(a);
+  int i = 0;
+  for ( ; i+4 <= n; i += 4 ) {
+    _mm256_storeu_pd(y+i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x+i), _mm256_loadu_pd(y+i)));
+  }
+  for ( ; i < n; ++i ) {
+    y[i] = fma(a, x[i], y[i]);
+  }
+}
+
+static void xpbyAvx2( const int n, const double *x, const double b, double *y ) {
+  const __m256d vb = _mm256_set1_pd(b);
+  int i = 0;
+  for ( ; i+4 <= n; i += 4 ) {
+    _mm256_storeu_pd(y+i, _mm256_fmadd_pd(vb, _mm256_loadu_pd(y+i), _mm256_loadu_pd(x+i)));
+  }
+  for ( ; i < n; ++i ) {
+    y[i] = fma(b, y[i], x[i]);
+  }
+}
+
+// 4 faces at a time, in the operation order of the generic kernel
+static void cotangentAvx2( const int nv, const int nf, const double *V, const int *F, const int begin, const int end,
+                           double *W ) {
+  const __m128i one = _mm_set1_epi32(1);
+  int i = begin;
+  for ( ; i+4 <= end; i += 4 ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const __m128i row = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(F+k*nf+i)), one);
+      const __m128i col = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(F+(k+1)%3*nf+i)), one);
+      const __m128i mid = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(F+(k+2)%3*nf+i)), one);
+      __m256d v[3], b[3];
+      for ( int d = 0; d < 3; ++d ) {
+        const double *Vd = V + long(d)*nv;
+        const __m256d pm = gather4(Vd, mid);
+        v[d] = _mm256_sub_pd(gather4(Vd, row), pm);
+        b[d] = _mm256_sub_pd(gather4(Vd, col), pm);
+      }
+      const __m256d z0 = _mm256_sub_pd(_mm256_mul_pd(v[1], b[2]), _mm256_mul_pd(v[2], b[1]));
+      const __m256d z1 = _mm256_sub_pd(_mm256_mul_pd(v[2], b[0]), _mm256_mul_pd(v[0], b[2]));
+      const __m256d z2 = _mm256_sub_pd(_mm256_mul_pd(v[0], b[1]), _mm256_mul_pd(v[1], b[0]));
+      __m256d dot = _mm256_add_pd(_mm256_setzero_pd(), _mm256_mul_pd(v[0], b[0]));
+      dot = _mm256_add_pd(dot, _mm256_mul_pd(v[1], b[1]));
+      dot = _mm256_add_pd(dot, _mm256_mul_pd(v[2], b[2]));
+      __m256d nrm = _mm256_add_pd(_mm256_mul_pd(z0, z0), _mm256_mul_pd(z1, z1));
+      nrm = _mm256_sqrt_pd(_mm256_add_pd(nrm, _mm256_mul_pd(z2, z2)));
+      _mm256_storeu_pd(W+k*nf+i, _mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(-0.5), dot), nrm));
+    }
+  }
+  simdGeneric()->cotangent(nv, nf, V, F, i, end, W);
+}
+
+// 32 characters at a time; a line starts after each newline
+static void countLinesAvx2( const char *buf, const long len, const char prev, long *nv, long *nf ) {
+  if ( len < 33 ) {
+    simdGeneric()->countLines(buf, len, prev, nv, nf);
+    return;
+  }
+  simdGeneric()->countLines(buf, 1, prev, nv, nf);
+  const __m256i nl = _mm256_set1_epi8('\n'), cv = _mm256_set1_epi8('v'), cf = _mm256_set1_epi8('f');
+  long i = 1;
+  for ( ; i+32 <= len; i += 32 ) {
+    const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf+i));
+    const __m256i start = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf+i-1)), nl);
+    *nv += __builtin_popcount(unsigned(_mm256_movemask_epi8(_mm256_and_si256(start, _mm256_cmpeq_epi8(cur, cv)))));
+    *nf += __builtin_popcount(unsigned(_mm256_movemask_epi8(_mm256_and_si256(start, _mm256_cmpeq_epi8(cur, cf)))));
+  }
+  simdGeneric()->countLines(buf+i, len-i, buf[i-1], nv, nf);
+}
+
+#pragma GCC pop_options
+
+static const SimdKernels kAvx2 = {
+  Isa::AVX2, spmvAvx2, dotAvx2, axpyAvx2, xpbyAvx2, cotangentAvx2, countLinesAvx2
+};
+
+const SimdKernels *simdAvx2() {
+  return &kAvx2;
+}
+
+#else  // SCSC_SIMD_AVX2
+
+const SimdKernels *simdAvx2() {
+  return nullptr;
+}
+
+#endif  // SCSC_SIMD_AVX2
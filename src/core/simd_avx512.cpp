@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    simd_avx512.cpp
+/// @brief   The implementation of the AVX-512 SIMD kernels.
+///
+/// See simd_avx2.cpp for the pragma; the lanes match the two accumulators of the AVX2 kernels.
+///
+
+#include <cmath>
+#include <simd.hpp>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCSC_SIMD_AVX512
+#endif  // __GNUC__ && x86
+
+#ifdef SCSC_SIMD_AVX512
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vl,fma")
+
+// The lanes l < m of 8 lanes
+static inline __mmask8 mask8( const int m ) {
+  return (m >= 8) ? __mmask8(0xFF) : __mmask8((1u << m) - 1u);
+}
+
+// A full gather and square root; the masked forms, since the unmasked ones read an undefined source (GCC warns of it)
+static inline __m512d gather8( const double *base, const __m256i index ) {
+  return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8(0xFF), index, base, 8);
+}
+
+static inline __m512d sqrt8( const __m512d x ) {
+  return _mm512_maskz_sqrt_pd(__mmask8(0xFF), x);
+}
+
+static inline double sum8( const __m512d acc ) {
+  double lane[8];
+  _mm512_storeu_pd(lane, acc);
+  return sumLanes(lane);
+}
+
+static void spmvAvx512( const int begin, const int end, const double *A_val, const int *A_row, const int *A_col,
+                        const double *x, double *y ) {
+  for ( int i = begin; i < end; ++i ) {
+    __m512d acc = _mm512_setzero_pd();
+    for ( int j = A_row[i]; j < A_row[i+1]; j += 8 ) {
+      const __mmask8 mask = mask8(A_row[i+1] - j);
+      const __m256i c = _mm256_maskz_loadu_epi32(mask, A_col+j);
+      const __m512d b = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, c, x, 8);
+      acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, A_val+j), b, acc);
+    }
+    y[i] = sum8(acc);
+  }
+}
+
+static double dotAvx512( const int n, const double *x, const double *y ) {
+  __m512d acc = _mm512_setzero_pd();
+  int i = 0;
+  for ( ; i+8 <= n; i += 8 ) {
+    acc = _mm512_fmadd_pd(_mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i), acc);
+  }
+  if ( i < n ) {
+    const __mmask8 mask = mask8(n-i);
+    acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x+i), _mm512_maskz_loadu_pd(mask, y+i), acc);
+  }
+  return sum8(acc);
+}
+
+static void axpyAvx512( const int n, const double a, const double *x, double *y ) {
+  const __m512d va = _mm512_set1_pd(a);
+  for ( int i = 0; i < n; i += 8 ) {
+    const __mmask8 mask = mask8(n-i);
+    const __m512d r = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x+i), _mm512_maskz_loadu_pd(mask, y+i));
+    _mm512_mask_storeu_pd(y+i, mask, r);
+  }
+}
+
+static void xpbyAvx512( const int n, const double *x, const double b, double *y ) {
+  const __m512d vb = _mm512_set1_pd(b);
+  for ( int i = 0; i < n; i += 8 ) {
+    const __mmask8 mask = mask8(n-i);
+    const __m512d r = _mm512_fmadd_pd(vb, _mm512_maskz_loadu_pd(mask, y+i), _mm512_maskz_loadu_pd(mask, x+i));
+    _mm512_mask_storeu_pd(y+i, mask, r);
+  }
+}
+
+// 8 faces at a time, in the operation order of the generic kernel
+static void cotangentAvx512( const int nv, const int nf, const double *V, const int *F, const int begin, const int end,
+                             double *W ) {
+  const __m256i one = _mm256_set1_epi32(1);
+  int i = begin;
+  for ( ; i+8 <= end; i += 8 ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const __m256i row = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(F+k*nf+i)), one);
+      const __m256i col = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(F+(k+1)%3*nf+i)), one);
+      const __m256i mid = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(F+(k+2)%3*nf+i)), one);
+      __m512d v[3], b[3];
+      for ( int d = 0; d < 3; ++d ) {
+        const double *Vd = V + long(d)*nv;
+        const __m512d pm = gather8(Vd, mid);
+        v[d] = _mm512_sub_pd(gather8(Vd, row), pm);
+        b[d] = _mm512_sub_pd(gather8(Vd, col), pm);
+      }
+      const __m512d z0 = _mm512_sub_pd(_mm512_mul_pd(v[1], b[2]), _mm512_mul_pd(v[2], b[1]));
+      const __m512d z1 = _mm512_sub_pd(_mm512_mul_pd(v[2], b[0]), _mm512_mul_pd(v[0], b[2]));
+      const __m512d z2 = _mm512_sub_pd(_mm512_mul_pd(v[0], b[1]), _mm512_mul_pd(v[1], b[0]));
+      __m512d dot = _mm512_add_pd(_mm512_setzero_pd(), _mm512_mul_pd(v[0], b[0]));
+      dot = _mm512_add_pd(dot, _mm512_mul_pd(v[1], b[1]));
+      dot = _mm512_add_pd(dot, _mm512_mul_pd(v[2], b[2]));
+      __m512d nrm = _mm512_add_pd(_mm512_mul_pd(z0, z0), _mm512_mul_pd(z1, z1));
+      nrm = sqrt8(_mm512_add_pd(nrm, _mm512_mul_pd(z2, z2)));
+      _mm512_storeu_pd(W+k*nf+i, _mm512_div_pd(_mm512_mul_pd(_mm512_set1_pd(-0.5), dot), nrm));
+    }
+  }
+  simdGeneric()->cotangent(nv, nf, V, F, i, end, W);
+}
+
+// 64 characters at a time; a line starts after each newline
+static void countLinesAvx512( const char *buf, const long len, const char prev, long *nv, long *nf ) {
+  if ( len < 65 ) {
+    simdGeneric()->countLines(buf, len, prev, nv, nf);
+    return;
+  }
+  simdGeneric()->countLines(buf, 1, prev, nv, nf);
+  const __m512i nl = _mm512_set1_epi8('\n'), cv = _mm512_set1_epi8('v'), cf = _mm512_set1_epi8('f');
+  long i = 1;
+  for ( ; i+64 <= len; i += 64 ) {
+    const __m512i cur = _mm512_loadu_si512(buf+i);
+    const __mmask64 start = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(buf+i-1), nl);
+    *nv += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(start, cur, cv));
+    *nf += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(start, cur, cf));
+  }
+  simdGeneric()->countLines(buf+i, len-i, buf[i-1], nv, nf);
+}
+
+#pragma GCC pop_options
+
+static const SimdKernels kAvx512 = {
+  Isa::AVX512, spmvAvx512, dotAvx512, axpyAvx512, xpbyAvx512, cotangentAvx512, countLinesAvx512
+};
+
+const SimdKernels *simdAvx512() {
+  return &kAvx512;
+}
+
+#else  // SCSC_SIMD_AVX512
+
+const SimdKernels *simdAvx512() {
+  return nullptr;
+}
+
+#endif  // SCSC_SIMD_AVX512
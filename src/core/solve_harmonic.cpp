@@ -5,19 +5,295 @@
 /// @author  Nil
 ///
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <vector>
 #include <harmonic.hpp>
+#include <profiler.hpp>
+#include <thread_pool.hpp>
+using namespace std;
+
+static const int kTile = 128;  // the tile size
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @todo  To be implemented!
-///
+// Tile kernels on column-major blocks with leading dimension ld. Only the lower triangle is referenced.
+//
+
+// A := chol(A)
+static int potrfTile( const int n, double *A, const long ld ) {
+  for ( int j = 0; j < n; ++j ) {
+    double *Aj = A + j*ld;
+    for ( int p = 0; p < j; ++p ) {
+      const double *Ap = A + p*ld;
+      const double a = Ap[j];
+      for ( int i = j; i < n; ++i ) {
+        Aj[i] -= Ap[i] * a;
+      }
+    }
+    if ( Aj[j] <= 0.0 ) {
+      return j+1;
+    }
+    const double d = sqrt(Aj[j]);
+    Aj[j] = d;
+    for ( int i = j+1; i < n; ++i ) {
+      Aj[i] /= d;
+    }
+  }
+  return 0;
+}
+
+// B := B * inv(L)'
+static void trsmTile( const int m, const int n, const double *L, double *B, const long ld ) {
+  for ( int j = 0; j < n; ++j ) {
+    double *Bj = B + j*ld;
+    for ( int p = 0; p < j; ++p ) {
+      const double *Bp = B + p*ld;
+      const double l = L[j+p*ld];
+      for ( int i = 0; i < m; ++i ) {
+        Bj[i] -= Bp[i] * l;
+      }
+    }
+    const double d = L[j+j*ld];
+    for ( int i = 0; i < m; ++i ) {
+      Bj[i] /= d;
+    }
+  }
+}
+
+// C := C - A * B'; only the lower triangle (and the upper triangle of the 4 by 4 diagonal blocks) if lower is set
+static void gemmTile( const int m, const int n, const int k, const double *A, const double *B, double *C, const long ld,
+                      const bool lower ) {
+  int j = 0;
+
+  // Four columns of C at a time, so that each column of A is loaded once per four updates
+  for ( ; j+4 <= n; j += 4 ) {
+    double *C0 = C + j*ld, *C1 = C0 + ld, *C2 = C1 + ld, *C3 = C2 + ld;
+    const int i0 = lower ? j : 0;
+    for ( int p = 0; p < k; ++p ) {
+      const double *Ap = A + p*ld;
+      const double *Bp = B + j + p*ld;
+      const double b0 = Bp[0], b1 = Bp[1], b2 = Bp[2], b3 = Bp[3];
+      #pragma omp simd
+      for ( int i = i0; i < m; ++i ) {
+        const double a = Ap[i];
+        C0[i] -= a * b0;
+        C1[i] -= a * b1;
+        C2[i] -= a * b2;
+        C3[i] -= a * b3;
+      }
+    }
+  }
+
+  for ( ; j < n; ++j ) {
+    double *Cj = C + j*ld;
+    const int i0 = lower ? j : 0;
+    for ( int p = 0; p < k; ++p ) {
+      const double *Ap = A + p*ld;
+      const double b = B[j+p*ld];
+      #pragma omp simd
+      for ( int i = i0; i < m; ++i ) {
+        Cj[i] -= Ap[i] * b;
+      }
+    }
+  }
+}
+
+// A tile operation of step k on the tile (i, j): potrf if i == j == k, trsm if j == k < i, and the update by the
+// panel k otherwise. Tiles of lower columns go first, so that the next panel starts while the updates of the previous
+// one are still running (lookahead).
+struct TileTask {
+  int k, i, j;
+  bool operator<( const TileTask &other ) const {
+    return (j != other.j) ? (j > other.j) : (k != other.k) ? (k > other.k) : (i > other.i);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tiled right-looking Cholesky factorization of the n by n matrix A in place. The tile operations run as soon as the
+// tiles they read are final, on one lane per thread of the pool; see TileTask.
+//
+static int factorizeCholesky( const int n, double *A, const long ld ) {
+  SCSC_PROFILE_ZONE("cholesky factorization");
+  // The lower triangle is read and written once
+  SCSC_PROFILE_WORK(8.0*n*n, double(n)*n*n/3.0);
+  const int nt = (n+kTile-1) / kTile;
+
+  // The number of updates applied to each tile, and whether the panel tiles are done; guarded by lock
+  vector<int>  nupdate(long(nt)*nt, 0);
+  vector<char> done(long(nt)*nt, 0);
+  priority_queue<TileTask> ready;
+  long remaining = long(nt)*(nt+1)*(nt+2)/6;
+  int info = 0;
+  mutex lock;
+  condition_variable wake;
+  ready.push(TileTask{0, 0, 0});
+
+  // Queue the operations that the completion of a task makes ready
+  auto complete = [&]( const TileTask &t ) {
+    const int k = t.k, i = t.i, j = t.j;
+    auto update = [&]( const int a, const int b ) {
+      if ( nupdate[a+long(b)*nt] == k && done[a+long(k)*nt] && done[b+long(k)*nt] ) {
+        ready.push(TileTask{k, a, b});
+      }
+    };
+    if ( j != k ) {
+      const int u = ++nupdate[i+long(j)*nt];
+      if ( u < j ) {
+        if ( done[i+long(u)*nt] && done[j+long(u)*nt] ) {
+          ready.push(TileTask{u, i, j});
+        }
+      } else if ( i == j || done[j+long(j)*nt] ) {
+        ready.push(TileTask{j, i, j});
+      }
+      return;
+    }
+    done[i+long(k)*nt] = 1;
+    if ( i == k ) {
+      for ( int a = k+1; a < nt; ++a ) {
+        if ( nupdate[a+long(k)*nt] == k ) {
+          ready.push(TileTask{k, a, k});
+        }
+      }
+    } else {
+      for ( int b = k+1; b <= i; ++b ) {
+        update(i, b);
+      }
+      for ( int a = i+1; a < nt; ++a ) {
+        update(a, i);
+      }
+    }
+  };
+
+  parallelFor(0, min(threadPoolSize(), int(min(remaining, long(INT_MAX)))), 1, [&]( int begin, int end ) {
+    for ( int lane = begin; lane < end; ++lane ) {
+      unique_lock<mutex> guard(lock);
+      while ( true ) {
+        wake.wait(guard, [&]() { return !ready.empty() || remaining == 0 || info != 0; });
+        if ( remaining == 0 || info != 0 ) {
+          break;
+        }
+        const TileTask t = ready.top();
+        ready.pop();
+        guard.unlock();
+
+        const int k0 = t.k*kTile, kn = min(kTile, n-k0);
+        const int i0 = t.i*kTile, in = min(kTile, n-i0);
+        const int j0 = t.j*kTile, jn = min(kTile, n-j0);
+        int err = 0;
+        if ( t.j != t.k ) {
+          gemmTile(in, jn, kn, A + i0 + k0*ld, A + j0 + k0*ld, A + i0 + j0*ld, ld, t.i == t.j);
+        } else if ( t.i != t.k ) {
+          trsmTile(in, kn, A + k0 + k0*ld, A + i0 + k0*ld, ld);
+        } else {
+          err = potrfTile(kn, A + k0 + k0*ld, ld);
+        }
+
+        guard.lock();
+        if ( err ) {
+          info = k0+err;
+        } else {
+          complete(t);
+          --remaining;
+        }
+        wake.notify_all();
+      }
+    }
+  });
+
+  return info;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// B := B - A * X; A is m by k, X is k by 2, B is m by 2. Blocked over rows and columns of A.
+//
+static void gemmBlocked( const int m, const int k, const double *A, const long lda, const double *X, const long ldx,
+                         double *B, const long ldb ) {
+  parallelFor(0, (m+kTile-1) / kTile, 1, [=]( int begin, int end ) {
+    for ( int it = begin; it < end; ++it ) {
+      const int i0 = it*kTile, in = min(kTile, m-i0);
+      for ( int p0 = 0; p0 < k; p0 += kTile ) {
+        const int pn = min(kTile, k-p0);
+        for ( int c = 0; c < 2; ++c ) {
+          double *Bc = B + i0 + c*ldb;
+          for ( int p = p0; p < p0+pn; ++p ) {
+            const double *Ap = A + i0 + p*lda;
+            const double x = X[p+c*ldx];
+            for ( int i = 0; i < in; ++i ) {
+              Bc[i] -= Ap[i] * x;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Solve L * L' * X = B in place; L is the n by n Cholesky factor, B is n by 2.
+//
+static void solveCholesky( const int n, const double *L, const long ld, double *B, const long ldb ) {
+  SCSC_PROFILE_ZONE("cholesky solve");
+  // The lower triangle is read by both sweeps
+  SCSC_PROFILE_WORK(8.0*n*n, 4.0*n*n);
+  // L * Y = B
+  for ( int j = 0; j < n; ++j ) {
+    const double *Lj = L + j*ld;
+    for ( int c = 0; c < 2; ++c ) {
+      double *Bc = B + c*ldb;
+      const double y = (Bc[j] /= Lj[j]);
+      for ( int i = j+1; i < n; ++i ) {
+        Bc[i] -= Lj[i] * y;
+      }
+    }
+  }
+
+  // L' * X = Y
+  for ( int j = n-1; j >= 0; --j ) {
+    const double *Lj = L + j*ld;
+    for ( int c = 0; c < 2; ++c ) {
+      double *Bc = B + c*ldb;
+      double s = Bc[j];
+      for ( int i = j+1; i < n; ++i ) {
+        s -= Lj[i] * Bc[i];
+      }
+      Bc[j] = s / Lj[j];
+    }
+  }
+}
+
 void solveHarmonic(
     const int nv,
     const int nb,
     double *L,
     double *U
 ) {
-  static_cast<void>(nv);
-  static_cast<void>(nb);
-  static_cast<void>(L);
-  static_cast<void>(U);
+  const int ni = nv-nb;
+
+  const double *Lib = L;
+  double       *Lii = L+long(nb)*ni;
+  const double *Ub  = U;
+  double       *Ui  = U+nb;
+
+  // ====================================================================================================================== //
+  // Solve Lii * Ui = - Lib Ub
+
+  // Tmp [in Ui] := - Lib * Ub
+  fill(Ui, Ui+ni, 0.0);
+  fill(Ui+nv, Ui+nv+ni, 0.0);
+  gemmBlocked(ni, nb, Lib, ni, Ub, nv, Ui, nv);
+
+  // Lii := chol(Lii)
+  int info = factorizeCholesky(ni, Lii, ni);
+  if ( info != 0 ) {
+    throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization failed: the leading minor of order " +
+                        to_string(info) + " is not positive definite.");
+  }
+
+  // Solve Lii * Ui = Tmp [in Ui]
+  solveCholesky(ni, Lii, ni, Ui, nv);
 }
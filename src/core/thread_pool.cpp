@@ -0,0 +1,356 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    thread_pool.cpp
+/// @brief   The implementation of the shared work-stealing thread pool.
+///
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <perf_counter.hpp>
+#include <thread_pool.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+#ifdef SCSC_USE_MKL
+#include <mkl.h>
+#endif  // SCSC_USE_MKL
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif  // __linux__
+using namespace std;
+
+// A loop submitted to the pool
+struct Job {
+  LoopBody      body;
+  const void   *context;
+  atomic<int>   pending;  // the number of chunks not finished
+  atomic<bool>  failed;   // whether a chunk has thrown; the chunks left are skipped
+  mutex         lock;     // guards error
+  exception_ptr error;    // the first error of the chunks; rethrown to the caller of the loop
+};
+
+// A chunk of a loop
+struct Task {
+  Job *job;
+  int  begin;
+  int  end;
+};
+
+// The deque of a thread; the owner pushes and pops at the back, the thieves steal from the front
+struct TaskDeque {
+  mutex       lock;
+  deque<Task> task;
+};
+
+// The pool; queue[w] belongs to worker w, and the last one is shared by the threads outside the pool, of which one at a
+// time (the one holding the slot) runs chunks
+struct Pool {
+  int                nthread;
+  vector<TaskDeque*> queue;
+  vector<thread>     worker;
+  mutex              sleep_lock;  // guards stop and slot_free; held to notify wake and done
+  condition_variable wake;        // the workers wait for chunks
+  condition_variable done;        // the waiting callers of loops wait for their loop, chunks, or the slot
+  atomic<long>       nqueued;
+  bool               stop;
+  bool               slot_free;
+};
+
+static const int kMaxPartial = 1024;  // the maximum number of partial sums of parallelSum
+
+static atomic<Pool*> g_pool(nullptr);
+static mutex g_init_lock;
+
+// The deque of this thread (-1 outside the pool) and the depth of the nested loops it runs
+static thread_local int  t_self  = -1;
+static thread_local int  t_depth = 0;
+static thread_local bool t_slot  = false;  // whether this thread outside the pool holds the slot
+
+// Pop a task from the own deque, or steal one from another deque
+static bool takeTask( Pool *pool, const int self, Task &task ) {
+  const int own = (self >= 0) ? self : pool->nthread-1;
+  for ( int k = 0; k < pool->nthread; ++k ) {
+    TaskDeque *q = pool->queue[(own+k) % pool->nthread];
+    lock_guard<mutex> guard(q->lock);
+    if ( !q->task.empty() ) {
+      if ( k == 0 ) {
+        task = q->task.back();
+        q->task.pop_back();
+      } else {
+        task = q->task.front();
+        q->task.pop_front();
+      }
+      --pool->nqueued;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Run a chunk; its error is kept for the caller of the loop, since it can not unwind a worker
+static void runTask( Pool *pool, const Task &task ) {
+  Job *job = task.job;
+  if ( !job->failed.load(memory_order_relaxed) ) {
+    try {
+      job->body(job->context, task.begin, task.end);
+    } catch ( ... ) {
+      lock_guard<mutex> guard(job->lock);
+      if ( !job->error ) {
+        job->error = current_exception();
+      }
+      job->failed.store(true, memory_order_relaxed);
+    }
+  }
+  if ( job->pending.fetch_sub(1, memory_order_acq_rel) == 1 ) {
+    lock_guard<mutex> guard(pool->sleep_lock);
+    pool->done.notify_all();
+  }
+}
+
+static void workerLoop( Pool *pool, const int self ) {
+  t_self  = self;
+  t_depth = 1;
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif  // _OPENMP
+#ifdef SCSC_USE_MKL
+  mkl_set_num_threads_local(1);
+#endif  // SCSC_USE_MKL
+  attachPerfCounters();
+
+  Task task;
+  while ( true ) {
+    if ( takeTask(pool, self, task) ) {
+      runTask(pool, task);
+      continue;
+    }
+    unique_lock<mutex> guard(pool->sleep_lock);
+    pool->wake.wait(guard, [=]() { return pool->stop || pool->nqueued.load() > 0; });
+    if ( pool->stop ) {
+      return;
+    }
+  }
+}
+
+static Pool *startPool( int nthread, const bool affinity ) {
+  const int ncpu = max(1u, thread::hardware_concurrency());
+  if ( nthread <= 0 ) {
+    nthread = ncpu;
+  }
+  Pool *pool = new Pool;
+  pool->nthread = nthread;
+  pool->nqueued   = 0;
+  pool->stop      = false;
+  pool->slot_free = true;
+  for ( int w = 0; w < nthread; ++w ) {
+    pool->queue.push_back(new TaskDeque);
+  }
+  for ( int w = 0; w+1 < nthread; ++w ) {
+    pool->worker.emplace_back(workerLoop, pool, w);
+#ifdef __linux__
+    // The threads outside the pool are left to the scheduler; worker w takes CPU w+1
+    if ( affinity ) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET((w+1) % ncpu, &set);
+      pthread_setaffinity_np(pool->worker.back().native_handle(), sizeof(cpu_set_t), &set);
+    }
+#else
+    static_cast<void>(affinity);
+#endif  // __linux__
+  }
+  return pool;
+}
+
+static void stopPool( Pool *pool ) {
+  {
+    lock_guard<mutex> guard(pool->sleep_lock);
+    pool->stop = true;
+  }
+  pool->wake.notify_all();
+  for ( thread &worker : pool->worker ) {
+    worker.join();
+  }
+  for ( TaskDeque *q : pool->queue ) {
+    delete q;
+  }
+  delete pool;
+}
+
+// Stop the pool at exit
+static struct PoolGuard {
+  ~PoolGuard() {
+    Pool *pool = g_pool.exchange(nullptr);
+    if ( pool != nullptr ) {
+      stopPool(pool);
+    }
+  }
+} g_guard;
+
+static Pool *getPool() {
+  Pool *pool = g_pool.load(memory_order_acquire);
+  if ( pool != nullptr ) {
+    return pool;
+  }
+  lock_guard<mutex> guard(g_init_lock);
+  pool = g_pool.load(memory_order_acquire);
+  if ( pool == nullptr ) {
+    const char *nthread  = getenv("SCSC_NUM_THREADS");
+    const char *affinity = getenv("SCSC_AFFINITY");
+    pool = startPool(nthread ? atoi(nthread) : 0, affinity && strcmp(affinity, "1") == 0);
+    g_pool.store(pool, memory_order_release);
+  }
+  return pool;
+}
+
+void initThreadPool(
+    const int  nthread,
+    const bool affinity
+) {
+  lock_guard<mutex> guard(g_init_lock);
+  Pool *pool = g_pool.exchange(nullptr);
+  if ( pool != nullptr ) {
+    stopPool(pool);
+  }
+  g_pool.store(startPool(nthread, affinity), memory_order_release);
+}
+
+int threadPoolSize() {
+  return getPool()->nthread;
+}
+
+void parallelFor(
+    const int   begin,
+    const int   end,
+    const int   grain,
+    LoopBody    body,
+    const void *context
+) {
+  const int n = end - begin;
+  if ( n <= 0 ) {
+    return;
+  }
+  Pool *pool = getPool();
+  const int nchunk = min((n + max(grain, 1) - 1) / max(grain, 1), 4 * pool->nthread);
+  if ( pool->nthread == 1 || nchunk == 1 ) {
+    body(context, begin, end);
+    return;
+  }
+
+  Job job;
+  job.body    = body;
+  job.context = context;
+  job.pending = nchunk;
+  job.failed  = false;
+  {
+    TaskDeque *q = pool->queue[(t_self >= 0) ? t_self : pool->nthread-1];
+    lock_guard<mutex> guard(q->lock);
+    for ( int c = nchunk-1; c >= 0; --c ) {
+      q->task.push_back(Task{&job, begin + int(long(n) * c / nchunk), begin + int(long(n) * (c+1) / nchunk)});
+    }
+  }
+  pool->nqueued += nchunk;
+  {
+    lock_guard<mutex> guard(pool->sleep_lock);
+    pool->wake.notify_all();
+    pool->done.notify_all();
+  }
+
+  // The libraries run single-threaded while a thread outside the pool takes part
+#ifdef _OPENMP
+  const int nomp = omp_get_max_threads();
+  if ( t_depth == 0 ) {
+    omp_set_num_threads(1);
+  }
+#endif  // _OPENMP
+#ifdef SCSC_USE_MKL
+  const int nmkl = (t_depth == 0) ? mkl_set_num_threads_local(1) : 0;
+#endif  // SCSC_USE_MKL
+
+  // Run the chunks of this loop, or of any other, until this loop is done; a thread outside the pool runs chunks only
+  // while it holds the slot. Sleep while there is nothing to run.
+  const bool acquire = (t_self < 0 && !t_slot);
+  ++t_depth;
+  Task task;
+  while ( job.pending.load(memory_order_acquire) > 0 ) {
+    const bool slot = (t_self >= 0 || t_slot);
+    if ( slot && takeTask(pool, t_self, task) ) {
+      runTask(pool, task);
+      continue;
+    }
+    unique_lock<mutex> guard(pool->sleep_lock);
+    if ( !slot && pool->slot_free ) {
+      pool->slot_free = false;
+      t_slot = true;
+      continue;
+    }
+    pool->done.wait(guard, [&]() {
+      return job.pending.load(memory_order_acquire) == 0 || (slot ? pool->nqueued.load() > 0 : pool->slot_free);
+    });
+  }
+  --t_depth;
+  if ( acquire && t_slot ) {
+    lock_guard<mutex> guard(pool->sleep_lock);
+    pool->slot_free = true;
+    t_slot = false;
+    pool->done.notify_all();
+  }
+
+#ifdef _OPENMP
+  if ( t_depth == 0 ) {
+    omp_set_num_threads(nomp);
+  }
+#endif  // _OPENMP
+#ifdef SCSC_USE_MKL
+  if ( t_depth == 0 ) {
+    mkl_set_num_threads_local(nmkl);
+  }
+#endif  // SCSC_USE_MKL
+
+  if ( job.error ) {
+    rethrow_exception(job.error);
+  }
+}
+
+void parallelSum(
+    const int   begin,
+    const int   end,
+    const int   grain,
+    const int   nsum,
+    SumBody     body,
+    const void *context,
+    double     *sum
+) {
+  fill(sum, sum+nsum, 0.0);
+  const int n = end - begin;
+  if ( n <= 0 ) {
+    return;
+  }
+  const int nthread = threadPoolSize();
+  int nchunk = (nthread == 1) ? 1 : min((n + max(grain, 1) - 1) / max(grain, 1), 4 * nthread);
+  nchunk = max(1, min(nchunk, kMaxPartial / max(nsum, 1)));
+  if ( nchunk == 1 ) {
+    body(context, begin, end, sum);
+    return;
+  }
+
+  double partial[kMaxPartial];
+  fill(partial, partial + nchunk * nsum, 0.0);
+  parallelFor(0, nchunk, 1, [&]( int b, int e ) {
+    for ( int c = b; c < e; ++c ) {
+      body(context, begin + int(long(n) * c / nchunk), begin + int(long(n) * (c+1) / nchunk), partial + c * nsum);
+    }
+  });
+  for ( int c = 0; c < nchunk; ++c ) {
+    for ( int j = 0; j < nsum; ++j ) {
+      sum[j] += partial[c * nsum + j];
+    }
+  }
+}
@@ -41,15 +41,23 @@ void verifyBoundary(
     Gb[p[2]*nv + p[0]]--;
   }
 
-  // List boundary
+  // List boundary; a closed mesh has no boundary edge
   int idx0 = (find(Gb, Gb+nv*nv, 1)-Gb) / nv;
+  if ( idx0 == nv ) {
+    delete[] Gb;
+    throw HarmonicError(ErrorCode::FORMAT, "The mesh has no boundary; a disk topology is needed.");
+  }
   int idx = idx0;
   for ( nb = 0; nb < nv; ) {
     idx_b[nb] = idx+1;
     idx = find(Gb+idx*nv, Gb+(idx+1)*nv, 1) - (Gb+idx*nv);
     ++nb;
-    if ( idx == idx0 ) {
+    if ( idx == idx0 || idx == nv ) {
       break;
     }
   }
+  delete[] Gb;
+  if ( idx != idx0 ) {
+    throw HarmonicError(ErrorCode::FORMAT, "The boundary is not one loop; a disk topology is needed.");
+  }
 }
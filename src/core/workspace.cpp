@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    workspace.cpp
+/// @brief   The implementation of the scratch workspace.
+///
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory_tracker.hpp>
+#include <workspace.hpp>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+using namespace std;
+
+static const size_t kAlign    = 64;              // the alignment of buffers
+static const size_t kHugePage = size_t(2) << 20;  // the size of a huge page
+
+// Whether large blocks are mapped with huge pages; SCSC_HUGE_PAGES=0 disables
+static bool useHugePages() {
+  static const bool use = [] {
+    const char *env = getenv("SCSC_HUGE_PAGES");
+    return env == nullptr || strcmp(env, "0") != 0;
+  }();
+  return use;
+}
+
+// Allocate a block of at least the given size; large blocks are mapped and backed by huge pages where available
+static char *allocBlock( size_t *size, bool *mapped ) {
+#ifdef __linux__
+  if ( *size >= kHugePage && useHugePages() ) {
+    const size_t bytes = (*size + kHugePage-1) & ~(kHugePage-1);
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if ( p == MAP_FAILED ) {
+      p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if ( p != MAP_FAILED ) {
+        madvise(p, bytes, MADV_HUGEPAGE);
+      }
+#endif
+    }
+    if ( p != MAP_FAILED ) {
+      trackMemory(bytes);
+      *size   = bytes;
+      *mapped = true;
+      return static_cast<char*>(p);
+    }
+  }
+#endif
+  *mapped = false;
+  return new char[*size];
+}
+
+// Free a block
+static void freeBlock( char *data, const size_t size, const bool mapped ) {
+#ifdef __linux__
+  if ( mapped ) {
+    munmap(data, size);
+    trackMemory(-long(size));
+    return;
+  }
+#else
+  static_cast<void>(size);
+  static_cast<void>(mapped);
+#endif
+  delete[] data;
+}
+
+Workspace::Workspace() : cur_(0), offset_(0), base_(0), peak_(0) {}
+
+Workspace::~Workspace() {
+  for ( Block &b : block_ ) {
+    freeBlock(b.data, b.size, b.mapped);
+  }
+}
+
+void *Workspace::take(
+    const size_t bytes
+) {
+  // The first block from the current one that fits
+  for ( ; cur_ < int(block_.size()); base_ += block_[cur_].size, ++cur_, offset_ = 0 ) {
+    const Block &b = block_[cur_];
+    const uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+    const size_t start = ((base + offset_ + kAlign-1) & ~uintptr_t(kAlign-1)) - base;
+    if ( start + bytes <= b.size ) {
+      offset_ = start + bytes;
+      peak_ = max(peak_, used());
+      return b.data + start;
+    }
+  }
+
+  // A new block; at least as large as all others, so that the number of blocks stays logarithmic
+  Block b;
+  b.size = max(bytes + kAlign, capacity());
+  b.data = allocBlock(&b.size, &b.mapped);
+  block_.push_back(b);
+  cur_ = block_.size()-1;
+  const uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+  const size_t start = ((base + kAlign-1) & ~uintptr_t(kAlign-1)) - base;
+  offset_ = start + bytes;
+  peak_ = max(peak_, used());
+  return b.data + start;
+}
+
+Workspace::Mark Workspace::mark() const {
+  Mark m;
+  m.block  = cur_;
+  m.offset = offset_;
+  return m;
+}
+
+void Workspace::release(
+    const Mark &mark
+) {
+  cur_    = mark.block;
+  offset_ = mark.offset;
+  base_   = 0;
+  for ( int i = 0; i < cur_; ++i ) {
+    base_ += block_[i].size;
+  }
+
+  // Merge the blocks once empty
+  if ( cur_ == 0 && offset_ == 0 && block_.size() > 1 ) {
+    Block b;
+    b.size = capacity();
+    for ( Block &old : block_ ) {
+      freeBlock(old.data, old.size, old.mapped);
+    }
+    block_.clear();
+    b.data = allocBlock(&b.size, &b.mapped);
+    block_.push_back(b);
+  }
+}
+
+void Workspace::clear() {
+  Mark m;
+  m.block  = 0;
+  m.offset = 0;
+  release(m);
+}
+
+size_t Workspace::capacity() const {
+  size_t size = 0;
+  for ( const Block &b : block_ ) {
+    size += b.size;
+  }
+  return size;
+}
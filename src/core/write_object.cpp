@@ -5,40 +5,113 @@
 /// @author  Yuhsiang Mike Tsai
 ///
 #include <harmonic.hpp>
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <profiler.hpp>
+#include <thread_pool.hpp>
+#include <workspace.hpp>
 using namespace std;
 
+static const int kLine  = 4096;  // the number of lines of a chunk
+static const int kChunk = 64;    // the number of chunks formatted at a time
+
+// Write n lines of at most width characters; the chunks are formatted in the thread pool and written in order
+template <typename Line>
+static void writeLines( ofstream &fout, const int n, const int width, Workspace &ws, const Line &line ) {
+  const Workspace::Mark top = ws.mark();
+  char *buf = ws.take<char>(long(min(n, kChunk*kLine)) * width);
+  int  *len = ws.take<int>(kChunk);
+  for ( int r0 = 0; r0 < n; r0 += kChunk*kLine ) {
+    const int nc = min(kChunk, (n-r0+kLine-1) / kLine);
+    parallelFor(0, nc, 1, [&]( int begin, int end ) {
+      for ( int c = begin; c < end; ++c ) {
+        char *s = buf + long(c)*kLine*width;
+        int l = 0;
+        for ( int i = r0+c*kLine; i < min(n, r0+(c+1)*kLine); ++i ) {
+          l += line(i, s+l);
+        }
+        len[c] = l;
+      }
+    });
+    for ( int c = 0; c < nc; ++c ) {
+      fout.write(buf + long(c)*kLine*width, len[c]);
+    }
+  }
+  ws.release(top);
+}
+
+// Write an object file; vertex(i, s) formats the vertex line i in at most width characters
+template <typename Vertex>
+static void writeFile( const char *input, const int nv, const int nf, const int *F, Workspace *work, const int width,
+                       const Vertex &vertex ) {
+  cout << "Stores in \"" << input << "\"." << endl;
+  ofstream fout(input, ofstream::out);
+  if ( fout.good() == 0 ) {
+    throw HarmonicError(ErrorCode::IO, string("Can not write the file ") + input);
+  }
+
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+
+  fout<<"# "<<nv<<" vertex\n";
+  writeLines(fout, nv, width, ws, vertex);
+
+  fout<<"# "<<nf<<" faces\n";
+  writeLines(fout, nf, 48, ws, [=](int i, char *s){
+    return snprintf(s, 48, "f %d %d %d\n", F[i], F[nf+i], F[2*nf+i]);
+  });
+  fout.close();
+  if ( fout.fail() ) {
+    throw HarmonicError(ErrorCode::IO, string("Can not write the file ") + input);
+  }
+}
+
 void writeObject(
     const char *input,
     const int nv,
     const int nf,
     double *U,
     double *C,
-    int *F
+    int *F,
+    Workspace *work
 ) {
-  cout << "Stores in \"" << input << "\"." << endl;
-  ofstream fout(input, ofstream::out);
-  if ( fout.good() == 0 ) {
-    cerr<<"Can not write the file "<<input<<"\n";
-    exit(1);
-  }
+  SCSC_PROFILE_ZONE("write object");
 
-  fout<<"# "<<nv<<" vertex\n";
+  // %g matches the default formatting of streams
   if ( C[0] == -1 ) {
-    for (int i=0; i<nv; i++){
-      fout<<"v "<<U[i]<<" "<<U[nv+i]<<" 0\n";
-    }
+    writeFile(input, nv, nf, F, work, 48, [=](int i, char *s){
+      return snprintf(s, 48, "v %g %g 0\n", U[i], U[nv+i]);
+    });
   }
   else {
-    for (int i=0; i<nv; i++){
-      fout<<"v "<<U[i]<<" "<<U[nv+i]<<" 0 "<<C[i]<<" "<<C[nv+i]<<" "<<C[2*nv+i]<<"\n";
-    }
+    writeFile(input, nv, nf, F, work, 96, [=](int i, char *s){
+      return snprintf(s, 96, "v %g %g 0 %g %g %g\n", U[i], U[nv+i], C[i], C[nv+i], C[2*nv+i]);
+    });
   }
+}
 
-  fout<<"# "<<nf<<" faces\n";
-  for (int i=0; i<nf; i++) {
-    fout<<"f "<<F[i]<<" "<<F[nf+i]<<" "<<F[2*nf+i]<<"\n";
+void writeMesh(
+    const char *output,
+    const int nv,
+    const int nf,
+    const double *V,
+    const double *C,
+    const int *F,
+    Workspace *work
+) {
+  SCSC_PROFILE_ZONE("write object");
+
+  // %.9g keeps the fine grids of generated meshes apart
+  if ( C[0] == -1 ) {
+    writeFile(output, nv, nf, F, work, 64, [=](int i, char *s){
+      return snprintf(s, 64, "v %.9g %.9g %.9g\n", V[i], V[nv+i], V[2*nv+i]);
+    });
+  }
+  else {
+    writeFile(output, nv, nf, F, work, 128, [=](int i, char *s){
+      return snprintf(s, 128, "v %.9g %.9g %.9g %g %g %g\n", V[i], V[nv+i], V[2*nv+i], C[i], C[nv+i], C[2*nv+i]);
+    });
   }
-  fout.close();
 }
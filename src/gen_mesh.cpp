@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    gen_mesh.cpp
+/// @brief   The generator of synthetic disk-topology meshes, for scaling studies.
+///
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <getopt.h>
+#include <harmonic.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+const char* const short_opt = "hn:k:r:xo:";
+
+const struct option long_opt[] = {
+  {"help",    0, NULL, 'h'},
+  {"faces",   1, NULL, 'n'},
+  {"kind",    1, NULL, 'k'},
+  {"seed",    1, NULL, 'r'},
+  {"shuffle", 0, NULL, 'x'},
+  {"output",  1, NULL, 'o'},
+  {NULL,      0, NULL, 0}
+};
+
+// Display the usage
+static void dispUsage( const char *bin ) {
+  cout << "Usage: " << bin << " [OPTIONS]" << endl;
+  cout << "Options:" << endl;
+  cout << "  -h,        --help            Display this information" << endl;
+  cout << "  -n<num>,   --faces <num>     The number of faces, rounded to 2n^2 for n <= " << kMaxMeshCells
+       << " cells per side (e.g. 1e8; default 1e6)" << endl;
+  cout << "  -k<name>,  --kind <name>     grid, jitter, or bumpy (default grid)" << endl;
+  cout << "  -r<num>,   --seed <num>      The random seed (default 0)" << endl;
+  cout << "  -x,        --shuffle         Shuffle the order of vertices" << endl;
+  cout << "  -o<file>,  --output <file>   The output object file (default output.obj)" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run the program; the errors of the routines are passed on to main.
+///
+static int run( int argc, char** argv ) {
+
+  const char *output = "output.obj";
+  double faces = 1e6;
+  MeshShape shape = MeshShape::GRID;
+  uint64_t seed = 0;
+  bool shuffle = false;
+
+  // Read arguments
+  int c = 0;
+  while ( (c = getopt_long(argc, argv, short_opt, long_opt, NULL)) != -1 ) {
+    switch ( c ) {
+      case 'h': dispUsage(argv[0]); return 0;
+      case 'n': faces = atof(optarg); break;
+      case 'k': {
+        shape = findMeshShape(optarg);
+        if ( shape == MeshShape::COUNT ) {
+          cerr << "Unknown kind " << optarg << endl;
+          return 1;
+        }
+        break;
+      }
+      case 'r': seed = strtoull(optarg, NULL, 0); break;
+      case 'x': shuffle = true; break;
+      case 'o': output = optarg; break;
+      default: dispUsage(argv[0]); return 1;
+    }
+  }
+
+  // The number of cells per side; the 3 x 2n^2 entries of the faces must fit the indices
+  const int n = int(min(max(round(sqrt(faces / 2.0)), 1.0), double(kMaxMeshCells)));
+  int nv, nf;
+  scanMesh(n, &nv, &nf);
+  cout << "Generating a " << meshShapeName(shape) << (shuffle ? " (shuffled)" : "") << " mesh of " << n << " x " << n
+       << " cells: " << nv << " vertices, " << nf << " faces." << endl;
+
+  ProfileStage stage;
+  double *V = new double[3L*nv], *C = new double[3L*nv];
+  int *F = new int[3L*nf];
+
+  stage.start("Generating mesh");
+  generateMesh(shape, n, seed, shuffle, V, C, F);
+  stage.stop();
+
+  stage.start("Writing object");
+  writeMesh(output, nv, nf, V, C, F);
+  stage.stop();
+
+  delete[] V;
+  delete[] C;
+  delete[] F;
+
+  // Write the profile (if SCSC_PROFILE is set)
+  finishProfile();
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+  try {
+    return run(argc, argv);
+  } catch ( const HarmonicError &e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
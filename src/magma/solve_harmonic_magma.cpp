@@ -6,36 +6,51 @@
 ///
 
 #include <harmonic.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
 #include "magma_v2.h"
 #include "magmasparse.h"
 #include "magma_lapack.h"
 using namespace std;
 
-void solveHarmonic(
+void initMagma() {
+  // magma_init per call would tear MAGMA down under the other solves of the process
+  static once_flag once;
+  call_once(once, []() {
+    magma_init();
+    atexit([]() { magma_finalize(); });
+  });
+}
+
+void solveHarmonicMagma(
     const int nv,
     const int nb,
     double *L,
     double *U
 ) {
   // Liiui=Libub
-  magma_init();
+  initMagma();
   magma_queue_t queue;
   magma_queue_create(0, &queue);
   double *dL = NULL, *dU = NULL;
-  magma_malloc((void **)&dL, nv*nv*sizeof(double));
+  const int ni = nv-nb;
+  magma_malloc((void **)&dL, ni*nv*sizeof(double));
   magma_malloc((void **)&dU, nv*2*sizeof(double));
-  magma_setvector(nv*nv, sizeof(double), L, 1, dL, 1, queue);
+  magma_setvector(ni*nv, sizeof(double), L, 1, dL, 1, queue);
   magma_setvector(nv*2, sizeof(double), U, 1, dU, 1, queue);
-  magmablas_dgemm(MagmaNoTrans, MagmaNoTrans, nv-nb, 2, nb, -1, dL+nb, nv, dU, nv, 0, dU+nb, nv, queue);
+  magmablas_dgemm(MagmaNoTrans, MagmaNoTrans, ni, 2, nb, -1, dL, ni, dU, nv, 0, dU+nb, nv, queue);
   //
   int *ipiv=new int [nv-nb], info = 0;
-  magma_dgesv_gpu(nv-nb, 2, dL+nv*nb+nb, nv, ipiv, dU+nb, nv, &info);
-  if (info != 0){
-    cerr<<info<<" Magma Solve Error\n";
+  magma_dgesv_gpu(ni, 2, dL+ni*nb, ni, ipiv, dU+nb, nv, &info);
+  delete [] ipiv;
+  if (info == 0){
+    magma_getvector(nv*2, sizeof(double), dU, 1, U, 1, queue);
   }
-  magma_getvector(nv*2, sizeof(double), dU, 1, U, 1, queue);
   magma_free(dL);
   magma_free(dU);
-  magma_finalize();
+  magma_queue_destroy(queue);
+  if (info != 0){
+    throw HarmonicError(ErrorCode::NUMERIC, "MAGMA solve failed with error " + to_string(info) + ".");
+  }
 }
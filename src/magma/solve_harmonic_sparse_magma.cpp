@@ -6,6 +6,8 @@
 ///
 
 #include <harmonic.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "magma_v2.h"
 #include "magmasparse.h"
@@ -38,7 +40,7 @@ magma_dcsrset_gpu(
 }
 
 
-void solveHarmonicSparse(
+void solveHarmonicSparseMagma(
   const int nv,
   const int nb,
   const double *Lii_val,
@@ -47,9 +49,13 @@ void solveHarmonicSparse(
   const double *Lib_val,
   const int *Lib_row,
   const int *Lib_col,
-  double *U
+  double *U,
+  const double *U0,
+  const SolveOptions &options,
+  SolveInfo *info
 ) {
-  magma_init();
+  const Monitor &monitor = options.monitor;
+  initMagma();
   magma_queue_t queue;
   magma_queue_create(0, &queue);
   int ni=nv-nb;
@@ -82,26 +88,64 @@ void solveHarmonicSparse(
 //   magma_d_mtransfer(Lii, &dLii, Magma_CPU, Magma_DEV, queue);
 //   magma_d_mtransfer(Lib, &dLib, Magma_CPU, Magma_DEV, queue);
 
+  // The solver options; set directly rather than parsed from a command line by magma_dparse_opts
   magma_dopts dopts;
-  int argc=4, k=1;
-  char *argv[]={"./solver", "--solver", "CG", "A.mtx"};
+  memset(&dopts, 0, sizeof(dopts));
+  dopts.solver_par.solver     = (options.precond == Precond::NONE) ? Magma_CG : Magma_PCG;
+  dopts.solver_par.version    = 0;
+  dopts.solver_par.atol       = 0.0;
+  dopts.solver_par.rtol       = options.tol;
+  dopts.solver_par.maxiter    = 10*ni+100;
+  dopts.solver_par.restart    = 50;
+  dopts.solver_par.verbose    = monitor ? 1 : 0;  // Record the residual of every iteration for the monitor
+  dopts.precond_par.solver    = (options.precond == Precond::NONE) ? Magma_NONE : Magma_JACOBI;
+  dopts.precond_par.trisolver = Magma_CUSOLVE;
+  dopts.precond_par.maxiter   = 100;
+  dopts.precond_par.atol      = 0.0;
+  dopts.precond_par.rtol      = 1e-10;
+  dopts.precond_par.levels    = 0;
+  dopts.precond_par.sweeps    = 5;
+  dopts.input_format          = Magma_CSR;
+  dopts.output_format         = Magma_CSR;
+  dopts.scaling               = Magma_NOSCALE;
+  SolveInfo stat = {0, 0.0, 0.0, 0, 0, false, 0, 0};
   for (int i=0; i<2; i++){
     magma_setvector(nb, sizeof(double), U+i*nv, 1, du.dval, 1, queue);
     magma_d_spmv(-1, dLib, du, 0, drhs, queue);
-    magma_dparse_opts(argc, argv, &dopts, &k, queue);
-    // magma_dsolverinfo_init( &dopts.solver_par, &dopts.precond_par, queue );
+    // Start from the initial guess (or zero)
+    if (U0 != NULL) {
+      magma_setvector(ni, sizeof(double), U0+i*nv+nb, 1, dx.dval, 1, queue);
+    } else {
+      magmablas_dlaset(MagmaFull, ni, 1, 0.0, 0.0, dx.dval, ni, queue);
+    }
+    magma_dsolverinfo_init( &dopts.solver_par, &dopts.precond_par, queue );
     magma_d_precondsetup( dLii, drhs, &dopts.solver_par, &dopts.precond_par, queue );
     magma_d_solver( dLii, drhs, &dx, &dopts, queue );
-    // magma_dsolverinfo (&dopts.solver_par, &dopts.precond_par, queue);
+    double nrmb = magma_dnrm2(ni, drhs.dval, 1, queue);
+    if (nrmb == 0) nrmb = 1;
+    double res0 = dopts.solver_par.init_res / nrmb, res = dopts.solver_par.final_res / nrmb;
+    stat.iter += dopts.solver_par.numiter;
+    stat.res0 = max(stat.res0, res0);
+    stat.res = max(stat.res, res);
+    // Replay the recorded residuals to the monitor; MAGMA neither splits the time nor stops early
+    if (monitor) {
+      for (int j=0; j<=dopts.solver_par.numiter; j++) {
+        IterationInfo it = {i, j, dopts.solver_par.res_vec[j] / nrmb, dopts.solver_par.timing[j], 0.0, 0.0};
+        if (!monitor(it)) break;
+      }
+    }
     magma_getvector(ni, sizeof(double), dx.dval, 1, U+i*nv+nb, 1, queue);
     // magma_getvector(nv*2, sizeof(double), dU, 1, U, 1, queue);
-    // magma_dsolverinfo_free( &dopts.solver_par, &dopts.precond_par, queue );
+    magma_dsolverinfo_free( &dopts.solver_par, &dopts.precond_par, queue );
   }
   magma_dmfree(&dLii, queue);
   magma_dmfree(&dLib, queue);
   magma_dmfree(&dx, queue);
   magma_dmfree(&du, queue);
   magma_dmfree(&drhs, queue);
-  magma_finalize();
+  magma_queue_destroy(queue);
+  if (info != NULL) {
+    *info = stat;
+  }
 
 }
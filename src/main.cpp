@@ -5,75 +5,128 @@
 /// @author  Mu Yang <<emfomy@gmail.com>>
 ///
 
-#include <cmath>
 #include <climits>
 #include <iostream>
 #include <harmonic.hpp>
-#include <timer.hpp>
+#include <profiler.hpp>
+#include <run_stats.hpp>
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Main function
+/// @brief  Run the program; the errors of the routines are passed on to main.
 ///
-int main( int argc, char** argv ) {
-
-  const char *input  = "input.obj";
-  const char *output = "output.obj";
-  Method method  = Method::KIRCHHOFF;
+static int run( int argc, char** argv ) {
+  Arguments args;
 
-  int nv, nf, nb, *F = nullptr, *idx_b;
-  double timer, *V = nullptr, *C = nullptr, *L, *U;
+  int nv, nf, nb, bw, nr, *F = nullptr, *idx_b;
+  double *V = nullptr, *C = nullptr, *L, *U;
+  ProfileStage stage;
 
   // Read arguments
-  readArgs(argc, argv, input, output, method);
+  readArgs(argc, argv, "ftosj", args);
+  if ( args.stats != nullptr ) {
+    startStats(args.stats);
+  }
 
-  // Read object
-  readObject(input, &nv, &nf, &V, &C, &F);
-  if ( nv > sqrt(INT_MAX) ) {
-    cerr << "The size of the Laplacian matrix (" << nv << " x " << nv << " = " << long(nv) * long(nv)
-         << ") exceed the maximum value of integer (" << INT_MAX << ")" << endl;
-    abort();
+  // Check the solver backend
+  const DenseBackend *solver = findDenseBackend(args.options.solver);
+  if ( solver == nullptr ) {
+    const DenseBackend *backend;
+    const int nbackend = listDenseBackends(&backend);
+    cerr << "Unknown solver " << args.options.solver << "; the available ones are:" << endl;
+    for ( int i = 0; i < nbackend; ++i ) {
+      cerr << "  " << backend[i].name << ": " << backend[i].description << endl;
+    }
+    return 1;
   }
 
+  // Read object
+  readObject(args.input, &nv, &nf, &V, &C, &F);
+
   cout << endl;
 
-  // Verify boundary
+  // Verify boundary; the dense version builds an nv by nv graph
   idx_b = new int[nv];
-  cout << "Verifying boundary ....................." << flush;
-  tic(&timer);
-  verifyBoundary(nv, nf, F, &nb, idx_b); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Verifying boundary");
+  if ( long(nv) * long(nv) <= INT_MAX ) {
+    verifyBoundary(nv, nf, F, &nb, idx_b);
+  } else {
+    verifyBoundarySparse(nv, nf, F, &nb, idx_b);
+  }
+  stage.stop();
 
   // Reorder vertices
-  cout << "Reordering vertices ...................." << flush;
-  tic(&timer);
-  reorderVertex(nv, nb, nf, V, C, F, idx_b); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Reordering vertices");
+  reorderVertex(nv, nb, nf, V, C, F, idx_b);
+  stage.stop();
+
+  // Reduce bandwidth
+  stage.start("Reducing bandwidth");
+  reorderBand(nv, nb, nf, V, C, F, &bw, &nr);
+  stage.stop();
+
+  // Use the banded storage unless the band covers most of Lii or a solver backend is given
+  const int ni = nv-nb;
+  const bool band = (2 * (bw+1) <= ni) && args.options.solver == nullptr;
+  if ( !band && long(ni) * long(nv) > INT_MAX ) {
+    throw HarmonicError(ErrorCode::UNAVAILABLE, "The size of the Laplacian matrix (" + to_string(ni) + " x " +
+                        to_string(nv) + " = " + to_string(long(ni) * long(nv)) + ") exceeds the maximum value of integer (" +
+                        to_string(INT_MAX) + ")");
+  }
 
   // Construct Laplacian
-  L = new double[nv * nv];
-  cout << "Constructing Laplacian ................." << flush;
-  tic(&timer);
-  constructLaplacian(method, nv, nf, V, F, L); cout << " Done.  ";
-  toc(&timer);
+  L = band ? new double[long(bw+1) * ni + long(nr) * nb] : new double[long(ni) * nv];
+  stage.start("Constructing Laplacian");
+  if ( band ) {
+    constructLaplacianBand(args.method, nv, nb, nf, V, F, bw, nr, L);
+  } else {
+    constructLaplacian(args.method, nv, nb, nf, V, F, L);
+  }
+  stage.stop();
 
   // Map boundary
   U = new double[2 * nv];
-  cout << "Mapping Boundary ......................." << flush;
-  tic(&timer);
-  mapBoundary(nv, nb, V, U); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Mapping Boundary");
+  mapBoundary(nv, nb, V, U);
+  stage.stop();
 
   // Solve harmonic
-  cout << "Solving Harmonic ......................." << flush;
-  tic(&timer);
-  solveHarmonic(nv, nb, L, U); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Solving Harmonic");
+  if ( band ) {
+    solveHarmonicBand(nv, nb, bw, nr, L, U);
+  } else {
+    solver->solve(nv, nb, L, U);
+  }
+  stage.stop();
+
+  cout << "Laplacian bandwidth: " << bw << " of " << ni << (band ? " (banded storage)" : " (dense storage)") << endl;
+  if ( !band ) {
+    cout << "Solver backend: " << solver->name << endl;
+  }
 
   cout << endl;
 
   // Write object
-  writeObject(output, nv, nf, U, C, F);
+  writeObject(args.output, nv, nf, U, C, F);
+
+  // Write the run statistics (if --stats is given); the direct solvers factorize the band or the whole of Lii
+  if ( args.stats != nullptr ) {
+    const long fbw = band ? bw : ni-1;
+    RunStats stats;
+    stats.input      = args.input;
+    stats.method     = (args.method == Method::KIRCHHOFF) ? "kirchhoff" : "cotangent";
+    stats.solver     = band ? "band" : solver->name;
+    stats.nv         = nv;
+    stats.nf         = nf;
+    stats.nb         = nb;
+    stats.bw         = bw;
+    stats.factor_bw  = fbw;
+    stats.nnz_factor = (fbw+1) * ni - fbw*(fbw+1) / 2;
+    stats.iter       = 0;
+    stats.held       = ((band ? long(bw+1) * ni + long(nr) * nb : long(ni) * nv) + 8L * nv) * sizeof(double)
+                     + (3L * nf + nv) * sizeof(int);
+    finishStats(stats);
+  }
 
   // Free memory
   delete[] V;
@@ -83,5 +136,20 @@ int main( int argc, char** argv ) {
   delete[] U;
   delete[] idx_b;
 
+  // Write the profile (if SCSC_PROFILE is set)
+  finishProfile();
+
   return 0;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+  try {
+    return run(argc, argv);
+  } catch ( const HarmonicError &e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    main_mpi.cpp
+/// @brief   The main function. (MPI version)
+///
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <harmonic.hpp>
+#include <distributed.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run the program; the errors of the routines are passed on to main.
+///
+/// Rank 0 reads the object, partitions the interior vertices, and scatters the faces and coordinates; each rank then
+/// assembles and solves its own rows. Run by `mpirun -np <N> main_mpi [OPTIONS]`.
+///
+static int run( int argc, char** argv ) {
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm comm = MPI_COMM_WORLD;
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+
+  Arguments args;
+
+  int nv = 0, nf = 0, nb = 0, *F = nullptr, *Lii_row, *Lii_col, *Lib_row, *Lib_col;
+  double *V = nullptr, *C = nullptr, *U = nullptr, *Lii_val, *Lib_val;
+  SolveInfo info;
+  Halo halo;
+
+  // The steps are timed on rank 0, from the slowest rank
+  ProfileStage stage(rank == 0);
+  auto begin = [&]( const char *step ) {
+    MPI_Barrier(comm);
+    stage.start(step);
+  };
+  auto end = [&]() {
+    MPI_Barrier(comm);
+    stage.stop();
+  };
+
+  // Read arguments
+  readArgs(argc, argv, "fto", args);
+
+  // Read object
+  if ( rank == 0 ) {
+    readObject(args.input, &nv, &nf, &V, &C, &F);
+    cout << endl;
+  }
+
+  // Verify boundary and reorder vertices
+  int *start = new int[size+1];
+  begin("Verifying boundary");
+  if ( rank == 0 ) {
+    int *idx_b = new int[nv];
+    verifyBoundarySparse(nv, nf, F, &nb, idx_b);
+    reorderVertex(nv, nb, nf, V, C, F, idx_b);
+    delete[] idx_b;
+  }
+  end();
+
+  // Partition the interior vertices; the vertices of each part are made contiguous
+  begin("Partitioning mesh");
+  if ( rank == 0 ) {
+    const int ni = nv-nb;
+    int *order = new int[ni], *idx = new int[nv];
+    partitionMesh(nv, nb, nf, F, size, order, start);
+    for ( int i = 0; i < nb; ++i ) {
+      idx[i] = i+1;
+    }
+    for ( int i = 0; i < ni; ++i ) {
+      idx[nb+i] = nb+order[i]+1;
+    }
+    reorderVertex(nv, nv, nf, V, C, F, idx);
+    delete[] order;
+    delete[] idx;
+  }
+  end();
+
+  // Map boundary
+  begin("Mapping Boundary");
+  if ( rank == 0 ) {
+    U = new double[2 * nv];
+    mapBoundary(nv, nb, V, U);
+  }
+  end();
+
+  // Distribute the mesh; the boundary is replicated, the faces go to the owners of their interior vertices
+  begin("Distributing mesh");
+  int sizes[3] = {nv, nb, int(args.method)};
+  MPI_Bcast(sizes, 3, MPI_INT, 0, comm);
+  MPI_Bcast(start, size+1, MPI_INT, 0, comm);
+  nv = sizes[0];
+  nb = sizes[1];
+  args.method = static_cast<Method>(sizes[2]);
+  const int nown = start[rank+1] - start[rank];
+  auto owner = [=]( const int i ) { return int(upper_bound(start, start+size+1, i-nb) - start) - 1; };
+
+  double *Vb = new double[3 * nb], *Ub = new double[2 * nb];
+  if ( rank == 0 ) {
+    for ( int k = 0; k < 3; ++k ) {
+      copy(V+k*nv, V+k*nv+nb, Vb+k*nb);
+    }
+    for ( int k = 0; k < 2; ++k ) {
+      copy(U+k*nv, U+k*nv+nb, Ub+k*nb);
+    }
+  }
+  MPI_Bcast(Vb, 3*nb, MPI_DOUBLE, 0, comm);
+  MPI_Bcast(Ub, 2*nb, MPI_DOUBLE, 0, comm);
+
+  int *count = new int[size], *displ = new int[size+1], *Fs = nullptr, nfl;
+  if ( rank == 0 ) {
+    vector<vector<int>> Fp(size);
+    for ( int i = 0; i < nf; ++i ) {
+      int p[3];
+      for ( int k = 0; k < 3; ++k ) {
+        p[k] = (F[k*nf+i]-1 >= nb) ? owner(F[k*nf+i]-1) : -1;
+      }
+      for ( int k = 0; k < 3; ++k ) {
+        if ( p[k] >= 0 && (k == 0 || p[k] != p[0]) && (k < 2 || p[k] != p[1]) ) {
+          Fp[p[k]].insert(Fp[p[k]].end(), {F[i], F[nf+i], F[2*nf+i]});
+        }
+      }
+    }
+    displ[0] = 0;
+    for ( int p = 0; p < size; ++p ) {
+      count[p] = Fp[p].size();
+      displ[p+1] = displ[p] + count[p];
+    }
+    Fs = new int[displ[size]];
+    for ( int p = 0; p < size; ++p ) {
+      copy(Fp[p].begin(), Fp[p].end(), Fs+displ[p]);
+    }
+  }
+  MPI_Scatter(count, 1, MPI_INT, &nfl, 1, MPI_INT, 0, comm);
+  int *Fr = new int[nfl];
+  MPI_Scatterv(Fs, count, displ, MPI_INT, Fr, nfl, MPI_INT, 0, comm);
+  nfl /= 3;
+  delete[] Fs;
+
+  // The ghost vertices; the interior vertices of the local faces owned by other ranks
+  vector<int> ghost;
+  for ( int i = 0; i < 3*nfl; ++i ) {
+    const int g = Fr[i]-1-nb;
+    if ( g >= 0 && (g < start[rank] || g >= start[rank+1]) ) {
+      ghost.push_back(g);
+    }
+  }
+  sort(ghost.begin(), ghost.end());
+  ghost.erase(unique(ghost.begin(), ghost.end()), ghost.end());
+  const int nghost = ghost.size(), nl = nb+nown+nghost;
+  constructHalo(comm, start, nghost, ghost.data(), &halo);
+
+  // The local faces in local numbering
+  int *Fl = new int[3 * nfl];
+  for ( int i = 0; i < nfl; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const int g = Fr[3*i+k]-1;
+      int l = g;
+      if ( g >= nb && owner(g) == rank ) {
+        l = g - start[rank];
+      } else if ( g >= nb ) {
+        l = nb + nown + int(lower_bound(ghost.begin(), ghost.end(), g-nb) - ghost.begin());
+      }
+      Fl[k*nfl+i] = l+1;
+    }
+  }
+  delete[] Fr;
+
+  // The local coordinates; the owned ones are scattered, the ghost ones are exchanged
+  double *Vl = new double[3 * nl];
+  for ( int p = 0; p < size; ++p ) {
+    count[p] = start[p+1] - start[p];
+  }
+  for ( int k = 0; k < 3; ++k ) {
+    copy(Vb+k*nb, Vb+k*nb+nb, Vl+k*nl);
+    MPI_Scatterv((rank == 0) ? V+k*nv+nb : nullptr, count, start, MPI_DOUBLE, Vl+k*nl+nb, nown, MPI_DOUBLE, 0, comm);
+    startHalo(comm, &halo, Vl+k*nl+nb);
+    finishHalo(&halo);
+  }
+  end();
+
+  // Construct Laplacian
+  begin("Constructing Laplacian");
+  constructLaplacianMpi(args.method, nl, nb, nown, nfl, Vl, Fl, &Lii_val, &Lii_row, &Lii_col, &Lib_val, &Lib_row, &Lib_col);
+  end();
+
+  // Solve harmonic
+  double *Ui = new double[2 * nown];
+  begin("Solving Harmonic");
+  solveHarmonicMpi(comm, &halo, nb, Lii_val, Lii_row, Lii_col, Lib_val, Lib_row, Lib_col, Ub, Ui, &info);
+  end();
+
+  // Gather the interior vertices
+  for ( int k = 0; k < 2; ++k ) {
+    MPI_Gatherv(Ui+k*nown, nown, MPI_DOUBLE, (rank == 0) ? U+k*nv+nb : nullptr, count, start, MPI_DOUBLE, 0, comm);
+  }
+
+  // The sizes of the parts and of the halo
+  int nown_min = nown, nown_max = nown, nghost_sum = nghost;
+  MPI_Reduce((rank == 0) ? MPI_IN_PLACE : &nown_min, &nown_min, 1, MPI_INT, MPI_MIN, 0, comm);
+  MPI_Reduce((rank == 0) ? MPI_IN_PLACE : &nown_max, &nown_max, 1, MPI_INT, MPI_MAX, 0, comm);
+  MPI_Reduce((rank == 0) ? MPI_IN_PLACE : &nghost_sum, &nghost_sum, 1, MPI_INT, MPI_SUM, 0, comm);
+
+  if ( rank == 0 ) {
+    cout << "Ranks: " << size << ", interior vertices per rank: " << nown_min << " to " << nown_max
+         << ", ghost vertices: " << nghost_sum << endl;
+    cout << "Solver iterations: " << info.iter << ", relative residual: " << info.res << endl;
+    cout << endl;
+
+    // Write object
+    writeObject(args.output, nv, nf, U, C, F);
+  }
+
+  // Free memory
+  destroyHalo(&halo);
+  delete[] V;
+  delete[] C;
+  delete[] F;
+  delete[] U;
+  delete[] start;
+  delete[] count;
+  delete[] displ;
+  delete[] Vb;
+  delete[] Ub;
+  delete[] Fl;
+  delete[] Vl;
+  delete[] Lii_val;
+  delete[] Lii_row;
+  delete[] Lii_col;
+  delete[] Lib_val;
+  delete[] Lib_row;
+  delete[] Lib_col;
+  delete[] Ui;
+
+  // Write the profile (if SCSC_PROFILE is set); the zones of rank 0 only
+  if ( rank == 0 ) {
+    finishProfile();
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+  try {
+    return run(argc, argv);
+  } catch ( const HarmonicError &e ) {
+    cerr << e.what() << endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+    return 1;
+  }
+}
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    main_multigrid.cpp
+/// @brief   The main function. (geometric multigrid version)
+///
+
+#include <iostream>
+#include <vector>
+#include <harmonic.hpp>
+#include <multigrid.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run the program; the errors of the routines are passed on to main.
+///
+static int run( int argc, char** argv ) {
+  Arguments args;
+
+  int nv, nf, nb, *F = nullptr, *idx_b, *Lii_row = nullptr, *Lii_col = nullptr, *Lib_row = nullptr, *Lib_col = nullptr;
+  double *V = nullptr, *C = nullptr, *Lii_val = nullptr, *Lib_val = nullptr, *U, *U0 = nullptr;
+  SolveInfo info;
+  ProfileStage stage;
+  Multigrid mg;
+
+  // Read arguments
+  readArgs(argc, argv, "ftogz", args);
+
+  // Read object
+  readObject(args.input, &nv, &nf, &V, &C, &F);
+
+  // Read initial guess; a previous output of the same mesh, mapped by vertex index
+  if ( args.guess != nullptr ) {
+    int nv0, nf0, *F0 = nullptr;
+    double *C0 = nullptr;
+    readObject(args.guess, &nv0, &nf0, &U0, &C0, &F0);
+    delete[] C0;
+    delete[] F0;
+    if ( nv0 != nv ) {
+      cerr << "The initial guess has " << nv0 << " vertices but the object has " << nv << "; ignored." << endl;
+      delete[] U0;
+      U0 = nullptr;
+    }
+  }
+
+  cout << endl;
+
+  // Verify boundary
+  idx_b = new int[nv];
+  stage.start("Verifying boundary");
+  verifyBoundarySparse(nv, nf, F, &nb, idx_b);
+  stage.stop();
+
+  // Reorder vertices
+  stage.start("Reordering vertices");
+  reorderVertex(nv, nb, nf, V, C, F, idx_b);
+  stage.stop();
+
+  // Construct Laplacian
+  stage.start("Constructing Laplacian");
+  constructLaplacianSparse(args.method, nv, nb, nf, V, F, &Lii_val, &Lii_row, &Lii_col, &Lib_val, &Lib_row, &Lib_col);
+  stage.stop();
+
+  // Construct multigrid
+  stage.start("Constructing multigrid");
+  constructMultigrid(args.method, nv, nb, nf, V, F, Lii_val, Lii_row, Lii_col, &mg);
+  stage.stop();
+
+  // Map boundary
+  U = new double[2 * nv];
+  stage.start("Mapping Boundary");
+  mapBoundary(nv, nb, V, U);
+  stage.stop();
+
+  // Solve harmonic
+  stage.start("Solving Harmonic");
+  solveHarmonicMultigrid(nv, nb, &mg, Lib_val, Lib_row, Lib_col, U, U0, &info);
+  stage.stop();
+
+  cout << "Multigrid levels (interior vertices):";
+  for ( int l = 0; l < mg.nlevel; ++l ) {
+    cout << " " << mg.level[l].ni;
+  }
+  cout << endl;
+  if ( mg.coarse_bw >= 0 ) {
+    cout << "The coarsest level is too large for a dense factor; it is factored in band storage (bandwidth "
+         << mg.coarse_bw << ")." << endl;
+  }
+
+  if ( info.iter > 0 ) {
+    cout << "Solver iterations: " << info.iter << endl;
+  }
+
+  // Compare with starting from zero (if --compare is given; not timed)
+  if ( U0 != nullptr && args.compare && info.iter > 0 ) {
+    SolveInfo info_cold;
+    vector<double> U_cold(U, U+2*nv);
+    solveHarmonicMultigrid(nv, nb, &mg, Lib_val, Lib_row, Lib_col, U_cold.data(), nullptr, &info_cold);
+    cout << "Initial guess: relative residual " << info.res0 << ", " << info_cold.iter - info.iter
+         << " of " << info_cold.iter << " iterations saved." << endl;
+  } else if ( U0 != nullptr ) {
+    cout << "Initial guess: relative residual " << info.res0 << ", " << info.iter << " iterations" << endl;
+  }
+
+  cout << endl;
+
+  // Write object
+  writeObject(args.output, nv, nf, U, C, F);
+
+  // Free memory
+  destroyMultigrid(&mg);
+  delete[] V;
+  delete[] C;
+  delete[] F;
+  delete[] Lii_val;
+  delete[] Lii_row;
+  delete[] Lii_col;
+  delete[] Lib_val;
+  delete[] Lib_row;
+  delete[] Lib_col;
+  delete[] U;
+  delete[] U0;
+  delete[] idx_b;
+
+  // Write the profile (if SCSC_PROFILE is set)
+  finishProfile();
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+  try {
+    return run(argc, argv);
+  } catch ( const HarmonicError &e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
@@ -5,82 +5,285 @@
 /// @author  Mu Yang <<emfomy@gmail.com>>
 ///
 
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 #include <harmonic.hpp>
-#include <timer.hpp>
+#include <harmonic_mapper.hpp>
+#include <factor_cache.hpp>
+#include <mesh_service.hpp>
+#include <profiler.hpp>
+#include <run_stats.hpp>
+#include <workspace.hpp>
+#include <unistd.h>
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @brief  Main function
+/// @brief  Map the mesh by the service on a socket, and write the mapped mesh.
 ///
-int main( int argc, char** argv ) {
+/// @note  Given the path of the mesh, the service writes the output itself, and the mesh is not read here. An inline
+///        mesh is read here, and written with the coordinates on the disk that the service returns.
+///
+static int runRemote( const ServiceOptions &service, const char *input, const char *output, const Method method,
+                      const SolveOptions &options ) {
+  int nv = 0, nf = 0, *F = nullptr;
+  double *V = nullptr, *C = nullptr;
+
+  // Send the mesh, or its real path and the absolute path of the output
+  MapRequest request;
+  char path[PATH_MAX], cwd[PATH_MAX];
+  string output_path = output;
+  if ( service.send ) {
+    readObject(input, &nv, &nf, &V, &C, &F);
+    request.nv = nv;
+    request.nf = nf;
+    request.V  = V;
+    request.F  = F;
+  } else {
+    request.input = (realpath(input, path) != nullptr) ? path : input;
+    if ( output[0] != '/' && getcwd(cwd, sizeof(cwd)) != nullptr ) {
+      output_path = string(cwd) + "/" + output;
+    }
+    request.output = output_path.c_str();
+  }
+  request.method  = method;
+  request.options = options;
+
+  vector<double> U;
+  MapReply reply;
+  try {
+    requestMap(service.connect, request, U, &reply);
+    if ( service.send && reply.nv != nv ) {
+      throw HarmonicError(ErrorCode::INTERNAL, "The service mapped " + to_string(reply.nv) + " vertices of " +
+                          to_string(nv) + ".");
+    }
+    cout << "Mapped by the service on " << service.connect << ": mesh " << (reply.warm ? "warm" : "cold")
+         << ", factorization " << (reply.factored ? "warm" : "cold") << ", " << reply.time << " s" << endl;
+    if ( reply.info.iter > 0 ) {
+      cout << "Solver iterations: " << reply.info.iter << ", relative residual: " << reply.info.res << endl;
+    }
+    if ( service.send ) {
+      writeObject(output, nv, nf, U.data(), C, F);
+    } else {
+      cout << "Stores in \"" << output << "\" (by the service)." << endl;
+    }
+  } catch ( ... ) {
+    delete[] V;
+    delete[] C;
+    delete[] F;
+    throw;
+  }
+
+  delete[] V;
+  delete[] C;
+  delete[] F;
+  return 0;
+}
 
-  const char *input  = "input.obj";
-  const char *output = "output.obj";
-  Method method  = Method::KIRCHHOFF;
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Run the program; the errors of the routines are passed on to main.
+///
+static int run( int argc, char** argv ) {
+  Arguments args;
 
-  int nv, nf, nb, *F = nullptr, *idx_b, *Lii_row = nullptr, *Lii_col = nullptr, *Lib_row = nullptr, *Lib_col = nullptr;
-  double timer, *V = nullptr, *C = nullptr, *Lii_val = nullptr, *Lib_val = nullptr, *U;
+  double *U0 = nullptr;
+  SolveInfo info;
+  ProfileStage stage;
+  FactorCache cache;
+  HarmonicMapper mapper;
 
 
   // Read arguments
-  readArgs(argc, argv, input, output, method);
+  readArgs(argc, argv, "ftogzcpklsmeSjdrbi", args);
+  if ( args.stats != nullptr ) {
+    startStats(args.stats);
+  }
+
+  // Check the solver backend
+  if ( args.options.solver != nullptr && findSparseBackend(args.options.solver) == nullptr ) {
+    const SparseBackend *backend;
+    const int nbackend = listSparseBackends(&backend);
+    cerr << "Unknown solver " << args.options.solver << "; the available ones are:" << endl;
+    for ( int i = 0; i < nbackend; ++i ) {
+      cerr << "  " << backend[i].name << ": " << backend[i].description << endl;
+    }
+    return 1;
+  }
+
+  // Serve the meshes sent to the socket, keeping them warm (if --serve is given)
+  if ( args.service.serve != nullptr ) {
+    MeshService server(size_t(args.service.budget) << 20);
+    serveMeshes(args.service.serve, server);
+    finishProfile();
+    return 0;
+  }
 
-  // Read object
-  readObject(input, &nv, &nf, &V, &C, &F);
+  // Map the mesh by the service instead (if --connect is given)
+  if ( args.service.connect != nullptr ) {
+    return runRemote(args.service, args.input, args.output, args.method, args.options);
+  }
+
+  // Read object; compute the edge data while reading if streaming
+  if ( args.stream ) {
+    mapper.stream(args.input, args.method);
+  } else {
+    mapper.load(args.input);
+  }
+  const int nv = mapper.nv();
+
+  // Read initial guess; a previous output of the same mesh, mapped by vertex index
+  if ( args.guess != nullptr ) {
+    int nv0, nf0, *F0 = nullptr;
+    double *C0 = nullptr;
+    readObject(args.guess, &nv0, &nf0, &U0, &C0, &F0);
+    delete[] C0;
+    delete[] F0;
+    if ( nv0 != nv ) {
+      cerr << "The initial guess has " << nv0 << " vertices but the object has " << nv << "; ignored." << endl;
+      delete[] U0;
+      U0 = nullptr;
+    }
+  }
 
   cout << endl;
 
   // Verify boundary
-  idx_b = new int[nv];
-  cout << "Verifying boundary ....................." << flush;
-  tic(&timer);
-  verifyBoundarySparse(nv, nf, F, &nb, idx_b); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Verifying boundary");
+  mapper.verifyBoundary();
+  stage.stop();
 
   // Reorder vertices
-  cout << "Reordering vertices ...................." << flush;
-  tic(&timer);
-  reorderVertex(nv, nb, nf, V, C, F, idx_b); cout << " Done.  ";
-  toc(&timer);
-
-  // Construct Laplacian
-  cout << "Constructing Laplacian ................." << flush;
-  tic(&timer);
-  constructLaplacianSparse(method, nv, nb, nf, V, F, &Lii_val, &Lii_row, &Lii_col, &Lib_val, &Lib_row, &Lib_col);
-  cout << " Done.  ";
-  toc(&timer);
+  stage.start("Reordering vertices");
+  mapper.reorderVertex();
+  stage.stop();
+
+  // Factorization cache key; the reordered faces determine the pattern of Lii
+  if ( args.cache != nullptr ) {
+    initFactorCache(args.cache, args.method, nv, mapper.nb(), mapper.nf(), mapper.F(), &cache);
+  }
+
+  // Construct Laplacian; update the cached one if only some vertices moved
+  stage.start("Constructing Laplacian");
+  mapper.constructLaplacian(args.method, args.cache ? &cache : nullptr);
+  stage.stop();
 
   // Map boundary
-  U = new double[2 * nv];
-  cout << "Mapping Boundary ......................." << flush;
-  tic(&timer);
-  mapBoundary(nv, nb, V, U); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Mapping Boundary");
+  mapper.mapBoundary();
+  stage.stop();
+
+  // Record the convergence history
+  vector<IterationInfo> history;
+  if ( args.log != nullptr ) {
+    args.options.monitor = [&]( const IterationInfo &it ) {
+      history.push_back(it);
+      return true;
+    };
+  }
 
   // Solve harmonic
-  cout << "Solving Harmonic ......................." << flush;
-  tic(&timer);
-  solveHarmonicSparse(nv, nb, Lii_val, Lii_row, Lii_col, Lib_val, Lib_row, Lib_col, U); cout << " Done.  ";
-  toc(&timer);
+  stage.start("Solving Harmonic");
+  args.options.cache = args.cache ? &cache : nullptr;
+  mapper.solve(args.options, U0, &info);
+  stage.stop();
+
+  if ( args.options.solver != nullptr ) {
+    cout << "Solver backend: " << args.options.solver << ", relative residual: " << info.res << endl;
+  }
+
+  if ( info.iter > 0 ) {
+    cout << "Solver iterations: " << info.iter << endl;
+  }
+
+  if ( args.log != nullptr && writeConvergence(args.log, history.size(), history.data()) ) {
+    cout << "Convergence history: " << args.log << " (" << history.size() << " records)" << endl;
+  }
+
+  if ( args.options.precision == Precision::MIXED ) {
+    cout << "Refinement steps: " << info.nrefine << ", relative residual: " << info.res;
+    cout << (info.fallback ? " (stagnated; refactorized in double precision)" : "") << endl;
+  }
+
+  if ( args.cache != nullptr ) {
+    cout << "Factorization cache: " << cache.path << endl;
+    if ( mapper.nmoved() >= 0 ) {
+      cout << "Moved vertices: " << mapper.nmoved() << ", rank-one factor updates: " << info.nupdate << endl;
+    }
+  }
+
+  // Compare with starting from zero (if --compare is given; not timed), in its own scratch and without a monitor
+  if ( U0 != nullptr && args.compare && info.iter > 0 ) {
+    SolveInfo info_cold;
+    Workspace work_cold;
+    vector<double> U_cold(mapper.U(), mapper.U()+2*nv);
+    SolveOptions options_cold = args.options;
+    options_cold.cache   = nullptr;
+    options_cold.monitor = nullptr;
+    options_cold.work    = &work_cold;
+    mapper.solve(options_cold, nullptr, U_cold.data(), &info_cold);
+    cout << "Initial guess: relative residual " << info.res0 << ", " << info_cold.iter - info.iter
+         << " of " << info_cold.iter << " iterations saved." << endl;
+  } else if ( U0 != nullptr ) {
+    cout << "Initial guess: relative residual " << info.res0 << ", " << info.iter << " iterations" << endl;
+  }
 
   cout << endl;
 
   // Write object
-  writeObject(output, nv, nf, U, C, F);
+  mapper.write(args.output);
+
+  // Report the scratch memory of each stage
+  const char *stage_name[] = {"verify", "reorder", "laplacian", "solve", "write"};
+  cout << "Scratch high-water (MiB):";
+  for ( int i = 0; i < static_cast<int>(HarmonicMapper::Stage::COUNT); ++i ) {
+    cout << " " << stage_name[i] << " " << mapper.highWater(static_cast<HarmonicMapper::Stage>(i)) / 1048576.0
+         << (i+1 < static_cast<int>(HarmonicMapper::Stage::COUNT) ? "," : ";");
+  }
+  cout << " total held " << mapper.capacity() / 1048576.0 << " MiB" << endl;
+
+  // Update the cached Laplacian (not timed)
+  if ( args.cache != nullptr && mapper.nmoved() != 0 ) {
+    mapper.storeLaplacian(&cache);
+  }
+
+  // Write the run statistics (if --stats is given)
+  if ( args.stats != nullptr ) {
+    RunStats stats;
+    stats.input      = args.input;
+    stats.method     = (args.method == Method::KIRCHHOFF) ? "kirchhoff" : "cotangent";
+    stats.solver     = sparseBackendName(args.options);
+    stats.nv         = nv;
+    stats.nf         = mapper.nf();
+    stats.nb         = mapper.nb();
+    stats.nnz_lii    = mapper.nnzLii();
+    stats.nnz_lib    = mapper.nnzLib();
+    stats.bw         = mapper.bandwidth();
+    stats.factor_bw  = (info.bw > 0) ? info.bw : -1;
+    stats.nnz_factor = (info.nfactor > 0) ? info.nfactor : -1;
+    stats.iter       = info.iter;
+    stats.res        = info.res;
+    stats.held       = mapper.capacity();
+    finishStats(stats);
+  }
 
   // Free memory
-  delete[] V;
-  delete[] C;
-  delete[] F;
-  delete[] Lii_val;
-  delete[] Lii_row;
-  delete[] Lii_col;
-  delete[] Lib_val;
-  delete[] Lib_row;
-  delete[] Lib_col;
-  delete[] U;
-  delete[] idx_b;
+  delete[] U0;
+
+  // Write the profile (if SCSC_PROFILE is set)
+  finishProfile();
 
   return 0;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief  Main function
+///
+int main( int argc, char** argv ) {
+  try {
+    return run(argc, argv);
+  } catch ( const HarmonicError &e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
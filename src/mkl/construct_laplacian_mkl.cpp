@@ -14,6 +14,7 @@
 void constructLaplacian(
     const Method method,
     const int nv,
+    const int nb,
     const int nf,
     const double *V,
     const int *F,
@@ -22,8 +23,11 @@ void constructLaplacian(
 
   static_cast<void>(V);
 
+  // Only the interior rows are formed; L[i, j] is stored in L[(i-nb) + j*ni]
+  const int ni = nv-nb;
+
   // L := 0
-  cblas_dscal(nv*nv, 0.0, L, 1);
+  cblas_dscal(ni*nv, 0.0, L, 1);
 
   switch ( method ) {
 
@@ -37,31 +41,21 @@ void constructLaplacian(
         int fy = F[i+nf]-1;
         int fz = F[i+nf*2]-1;
 
-        L[fx+fy*nv] = -1;
-        L[fy+fz*nv] = -1;
-        L[fz+fx*nv] = -1;
-        L[fy+fx*nv] = -1;
-        L[fz+fy*nv] = -1;
-        L[fx+fz*nv] = -1;
+        if ( fx >= nb ) { L[(fx-nb)+fy*ni] = -1; L[(fx-nb)+fz*ni] = -1; }
+        if ( fy >= nb ) { L[(fy-nb)+fz*ni] = -1; L[(fy-nb)+fx*ni] = -1; }
+        if ( fz >= nb ) { L[(fz-nb)+fx*ni] = -1; L[(fz-nb)+fy*ni] = -1; }
       }
 
-      // L[i, i] := - sum( L[i-col] )
-      for ( int i = 0; i < nv; ++i ) {
-        L[i+i*nv] = cblas_dasum(nv, L+i*nv, 1);
+      // L[i, i] := - sum( L[i-row] )
+      for ( int i = 0; i < ni; ++i ) {
+        L[i+(nb+i)*ni] = cblas_dasum(nv, L+i, ni);
       }
 
-      // // L[i, i] := - sum( L[i-col] )
-      // double dnone = -1.0;
-      // for ( int i = 0; i < nv; ++i ) {
-      //   L[i+i*nv] = cblas_ddot(nv, L+i*nv, 1, &dnone, 0);
-      // }
-
       break;
     }
 
     default: {
-      std::cerr << "Method " << int(method) << " is not available!";
-      abort();
+      throw HarmonicError(ErrorCode::UNAVAILABLE, "Method " + std::to_string(int(method)) + " is not available!");
     }
   }
 }
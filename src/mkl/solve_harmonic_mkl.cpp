@@ -8,7 +8,7 @@
 #include <harmonic.hpp>
 #include <mkl.h>
 
-void solveHarmonic(
+void solveHarmonicMkl(
     const int nv,
     const int nb,
     double *L,
@@ -16,20 +16,20 @@ void solveHarmonic(
 ) {
   const int ni = nv-nb;
 
-  const double *Lib = L+nb;
-  double       *Lii = L+nb+nb*nv;
+  const double *Lib = L;
+  double       *Lii = L+nb*ni;
   const double *Ub  = U;
   double       *Ui  = U+nb;
 
-  int *ipiv = new int[ni];
-
   // ====================================================================================================================== //
   // Solve Lii * Ui = - Lib Ub
 
   // Tmp [in Ui] := - Lib * Ub
-  cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, ni, 2, nb, -1.0, Lib, nv, Ub, nv, 0.0, Ui, nv);
+  cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, ni, 2, nb, -1.0, Lib, ni, Ub, nv, 0.0, Ui, nv);
 
-  // Solve Lii * Ui = Tmp [in Ui]
-  int info = LAPACKE_dgesv(LAPACK_COL_MAJOR, ni, 2, Lii, nv, ipiv, Ui, nv);
-  assert(info == 0);
+  // Solve Lii * Ui = Tmp [in Ui]; Lii is symmetric positive definite
+  const int info = LAPACKE_dposv(LAPACK_COL_MAJOR, 'L', ni, 2, Lii, ni, Ui, nv);
+  if ( info != 0 ) {
+    throw HarmonicError(ErrorCode::NUMERIC, "LAPACKE_dposv failed with info " + std::to_string(info) + ".");
+  }
 }
@@ -6,7 +6,13 @@
 ///
 
 #include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <harmonic.hpp>
+#include <factor_cache.hpp>
+#include <iterative.hpp>
+#include <workspace.hpp>
 #include <mkl.h>
 using namespace std;
 
@@ -20,7 +26,114 @@ using namespace std;
 //   }
 // }
 
-void solveHarmonicSparse(
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factorize Lii in single precision and refine both right-hand sides against Lii in double precision (as LAPACK dsposv).
+// Returns false if the refinement stagnates. The nonzeros of the factor are returned in ptr_nfactor.
+//
+static bool solveMixed(
+  int ni,
+  const double *Lii_val,
+  const int *Lii_row,
+  const int *Lii_col,
+  const double *b,
+  double *x,
+  int *perm,
+  const int perm_mode,
+  int *ptr_nrefine,
+  int *ptr_nfactor
+) {
+  const int maxrefine = 30;
+  char trans='N';
+
+  int iparm[64], mtype = 11, maxfct = 1, mnum = 1, phase, error = 0, msglvl = 0, nrhs = 2;
+  void *pt[64];
+  for (int i=0; i<64; i++){
+    iparm[i]=0;
+    pt[i]=0;
+  }
+  iparm[0]  = 1;          // No solver default
+  iparm[1]  = 3;          // Fill-in reordering from METIS
+  iparm[4]  = perm_mode;  // User fill-in reducing permutation, as the double precision solve
+  iparm[7]  = 0;          // No iterative refinement in single precision
+  iparm[9]  = 13;         // Perturb the pivot elements with 1E-13
+  iparm[10] = 1;          // Use nonsymmetric permutation and scaling MPS
+  iparm[12] = 1;          // Maximum weighted matching algorithm is switched-on
+  iparm[17] = -1;         // Output: Number of nonzeros in the factor LU
+  iparm[23] = 1;          // Classic parallel factorization control.
+  iparm[27] = 1;          // Single precision; a, b, and x are float arrays
+  iparm[34] = 1;          // Zero-based indexing
+
+  // ||Lii||_inf * sqrt(n) * eps bounds the attainable residual relative to ||x||_inf
+  const int nnz = Lii_row[ni];
+  double nrma = 0.0;
+  for (int i=0; i<ni; i++){
+    double sum = 0.0;
+    for (int j=Lii_row[i]; j<Lii_row[i+1]; j++){
+      sum += fabs(Lii_val[j]);
+    }
+    nrma = max(nrma, sum);
+  }
+  const double cte = nrma * sqrt(double(ni)) * DBL_EPSILON;
+
+  float *a = new float[nnz], *r32 = new float[2*ni], *d32 = new float[2*ni];
+  double *r = new double[2*ni];
+  for (int i=0; i<nnz; i++){
+    a[i] = float(Lii_val[i]);
+  }
+
+  phase = 12;
+  pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, a, Lii_row, Lii_col, perm, &nrhs, iparm, &msglvl, NULL, NULL, &error);
+  bool good = (error == 0);
+  *ptr_nfactor = iparm[17];
+
+  // Each step solves Lii * d = b - Lii * x with the single precision factor
+  fill(x, x+2*ni, 0.0);
+  copy(b, b+2*ni, r);
+  double nrmr_prev = HUGE_VAL;
+  for (int step=0; good; step++){
+    for (int i=0; i<2*ni; i++){
+      r32[i] = float(r[i]);
+    }
+    phase = 33;
+    pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, a, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, r32, d32, &error);
+    if (error != 0){
+      good = false;
+      break;
+    }
+    for (int i=0; i<2*ni; i++){
+      x[i] += d32[i];
+    }
+
+    // r := b - Lii * x
+    mkl_cspblas_dcsrgemv(&trans, &ni, Lii_val, Lii_row, Lii_col, x,    r);
+    mkl_cspblas_dcsrgemv(&trans, &ni, Lii_val, Lii_row, Lii_col, x+ni, r+ni);
+    double nrmr = 0.0, nrmx = 0.0;
+    for (int i=0; i<2*ni; i++){
+      r[i] = b[i] - r[i];
+      nrmr = max(nrmr, fabs(r[i]));
+      nrmx = max(nrmx, fabs(x[i]));
+    }
+    if (nrmr <= nrmx * cte){
+      *ptr_nrefine = 2*step;
+      break;
+    }
+    if (step == maxrefine || nrmr > 0.5 * nrmr_prev){
+      good = false;
+    }
+    nrmr_prev = nrmr;
+  }
+
+  phase = -1;
+  pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, a, Lii_row, Lii_col, perm, &nrhs, iparm, &msglvl, NULL, NULL, &error);
+
+  delete [] a;
+  delete [] r32;
+  delete [] d32;
+  delete [] r;
+  return good;
+}
+
+void solveHarmonicSparseMkl(
   const int nv,
   const int nb,
   const double *Lii_val,
@@ -29,11 +142,20 @@ void solveHarmonicSparse(
   const double *Lib_val,
   const int *Lib_row,
   const int *Lib_col,
-  double *U
+  double *U,
+  const double *U0,
+  const SolveOptions &options,
+  SolveInfo *info
 ) {
+  static_cast<void>(U0);
+  const FactorCache *cache = options.cache;
+  const Precision precision = options.precision;
   int ni=nv-nb;
   char trans='N';
-  double *b=new double[ni*2], *x=new double [ni*2];
+  Workspace local;
+  Workspace &ws = (options.work != nullptr) ? *options.work : local;
+  const Workspace::Mark top = ws.mark();
+  double *b=ws.take<double>(ni*2), *x=ws.take<double>(ni*2);
 
   mkl_cspblas_dcsrgemv(&trans, &ni, Lib_val, Lib_row, Lib_col, U,    U+nb);
   mkl_cspblas_dcsrgemv(&trans, &ni, Lib_val, Lib_row, Lib_col, U+nv, U+nb+nv);
@@ -52,7 +174,7 @@ void solveHarmonicSparse(
   iparm[0]  = 1;   // No solver default
   iparm[1]  = 3;   // Fill-in reordering from METIS
   iparm[3]  = 0;   // No iterative-direct algorithm
-  iparm[4]  = 0;   // No user fill-in reducing permutation
+  iparm[4]  = 0;   // No user fill-in reducing permutation (set below if cached)
   iparm[5]  = 0;   // Write solution into x
   iparm[6]  = 0;   // Not in use
   iparm[7]  = 5;   // Max numbers of iterative refinement steps
@@ -77,31 +199,85 @@ void solveHarmonicSparse(
   for(int i = 0; i < 64; i++) {
   pt[i] = 0;
   }
-  phase = 11;
-  int nrhs=2;
-  pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, NULL, NULL, &error);
-  if (error != 0){
-      cerr<<"Symbolic Factor Error\n";
-      exit(1);
+  // The fill-in reducing permutation is cached; PARDISO does not export its numeric factor
+  FactorData data;
+  int *perm = ws.take<int>(ni);
+  bool cached = false;
+  if ( cache != nullptr && loadFactorCache(cache, ni, &data) ) {
+    // Only the orderings stored by PARDISO (without a numeric factor) are used
+    if ( data.factor == nullptr ) {
+      copy(data.perm, data.perm+ni, perm);
+      cached = true;
+    }
+    releaseFactorCache(&data);
   }
-  phase = 22;
-  pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, b, x, &error);
-  if (error != 0){
-      cerr<<"Numerical Factor Error\n";
-      exit(1);
+  if ( cached ) {
+    iparm[4] = 1;  // User fill-in reducing permutation
+  } else if ( cache != nullptr ) {
+    iparm[4] = 2;  // Return the computed permutation
   }
-  phase = 33;
-  pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, b, x, &error);
-  if (error !=0){
-      cerr<<"Solve Error\n";
-      exit(1);
+
+  // Mixed precision; falls back to double precision if the refinement stagnates
+  int nrefine = 0, nfactor = 0;
+  bool fallback = false;
+  if (precision == Precision::MIXED) {
+    fallback = !solveMixed(ni, Lii_val, Lii_row, Lii_col, b, x, perm, iparm[4], &nrefine, &nfactor);
+    if (!fallback && cache != nullptr && !cached) {
+      storeFactorCache(cache, ni, 0, perm, nullptr, 0, nullptr, 0);
+    }
+  }
+
+  if (precision == Precision::DOUBLE || fallback) {
+    phase = 11;
+    int nrhs=2;
+
+    // Release the memory of PARDISO and the workspace before passing an error on
+    auto fail = [&](const char *what) {
+      const int code = error;
+      phase = -1;
+      pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, perm, &nrhs, iparm, &msglvl, NULL, NULL, &error);
+      ws.release(top);
+      throw HarmonicError(ErrorCode::NUMERIC, string("PARDISO ") + what + " failed with error " + to_string(code) + ".");
+    };
+
+    pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, perm, &nrhs, iparm, &msglvl, NULL, NULL, &error);
+    if (error != 0){
+      fail("symbolic factorization");
+    }
+    if ( cache != nullptr && !cached ) {
+      storeFactorCache(cache, ni, 0, perm, nullptr, 0, nullptr, 0);
+    }
+    phase = 22;
+    pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, b, x, &error);
+    if (error != 0){
+      fail("numerical factorization");
+    }
+    nfactor = iparm[17];
+    phase = 33;
+    pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, NULL, &nrhs, iparm, &msglvl, b, x, &error);
+    if (error !=0){
+      fail("solve");
+    }
+
+    phase = -1;
+    pardiso (pt, &maxfct, &mnum, &mtype, &phase, &ni, Lii_val, Lii_row, Lii_col, perm, &nrhs, iparm, &msglvl, NULL, NULL, &error);
   }
   for (int i=0; i<2; i++){
     for (int j=0; j<ni; j++){
       U[i*nv+nb+j]=x[i*ni+j];
     }
   }
+  if (info != nullptr) {
+    info->iter = 0;
+    info->res0 = 1.0;
+    info->nupdate = 0;
+    info->nrefine = nrefine;
+    info->fallback = fallback;
+    info->bw = 0;
+    info->nfactor = std::max(nfactor, 0);
+    info->res = std::max(residualSparse(ni, Lii_val, Lii_row, Lii_col, b, x, &ws),
+                         residualSparse(ni, Lii_val, Lii_row, Lii_col, b+ni, x+ni, &ws));
+  }
 
-  delete [] b;
-  delete [] x;
+  ws.release(top);
 }
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    halo_mpi.cpp
+/// @brief   The implementation of the halo exchange. (MPI version)
+///
+
+#include <algorithm>
+#include <distributed.hpp>
+using namespace std;
+
+void constructHalo(
+    MPI_Comm   comm,
+    const int *start,
+    const int  nghost,
+    const int *ghost,
+    Halo      *halo
+) {
+  int rank, size;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+
+  // The number of ghost entries owned by each rank, and the number of owned entries each rank needs
+  int *nrecv = new int[size], *nsend = new int[size];
+  fill(nrecv, nrecv+size, 0);
+  for ( int i = 0; i < nghost; ++i ) {
+    ++nrecv[upper_bound(start, start+size+1, ghost[i]) - start - 1];
+  }
+  MPI_Alltoall(nrecv, 1, MPI_INT, nsend, 1, MPI_INT, comm);
+
+  int *rdispl = new int[size+1], *sdispl = new int[size+1];
+  rdispl[0] = sdispl[0] = 0;
+  for ( int p = 0; p < size; ++p ) {
+    rdispl[p+1] = rdispl[p] + nrecv[p];
+    sdispl[p+1] = sdispl[p] + nsend[p];
+  }
+
+  // Tell the owners which entries to send; the ghost entries are sorted, thus grouped by owner
+  halo->send_idx = new int[sdispl[size]];
+  MPI_Alltoallv(ghost, nrecv, rdispl, MPI_INT, halo->send_idx, nsend, sdispl, MPI_INT, comm);
+  for ( int i = 0; i < sdispl[size]; ++i ) {
+    halo->send_idx[i] -= start[rank];
+  }
+
+  // The neighbours; both sides of a pair see each other
+  halo->nown      = start[rank+1] - start[rank];
+  halo->nghost    = nghost;
+  halo->nneighbor = 0;
+  for ( int p = 0; p < size; ++p ) {
+    halo->nneighbor += (nrecv[p] > 0 || nsend[p] > 0);
+  }
+  halo->neighbor = new int[halo->nneighbor];
+  halo->send_ptr = new int[halo->nneighbor+1];
+  halo->recv_ptr = new int[halo->nneighbor+1];
+  for ( int p = 0, k = 0; p < size; ++p ) {
+    if ( nrecv[p] > 0 || nsend[p] > 0 ) {
+      halo->neighbor[k] = p;
+      halo->send_ptr[k] = sdispl[p];
+      halo->recv_ptr[k] = rdispl[p];
+      ++k;
+    }
+  }
+  halo->send_ptr[halo->nneighbor] = sdispl[size];
+  halo->recv_ptr[halo->nneighbor] = rdispl[size];
+  halo->buffer  = new double[sdispl[size]];
+  halo->request = new MPI_Request[2*halo->nneighbor];
+
+  delete[] nrecv;
+  delete[] nsend;
+  delete[] rdispl;
+  delete[] sdispl;
+}
+
+void startHalo(
+    MPI_Comm  comm,
+    Halo     *halo,
+    double   *x
+) {
+  const int nn = halo->nneighbor;
+  for ( int k = 0; k < nn; ++k ) {
+    MPI_Irecv(x+halo->nown+halo->recv_ptr[k], halo->recv_ptr[k+1]-halo->recv_ptr[k], MPI_DOUBLE,
+              halo->neighbor[k], 0, comm, &halo->request[k]);
+  }
+  for ( int i = 0; i < halo->send_ptr[nn]; ++i ) {
+    halo->buffer[i] = x[halo->send_idx[i]];
+  }
+  for ( int k = 0; k < nn; ++k ) {
+    MPI_Isend(halo->buffer+halo->send_ptr[k], halo->send_ptr[k+1]-halo->send_ptr[k], MPI_DOUBLE,
+              halo->neighbor[k], 0, comm, &halo->request[nn+k]);
+  }
+}
+
+void finishHalo(
+    Halo *halo
+) {
+  MPI_Waitall(2*halo->nneighbor, halo->request, MPI_STATUSES_IGNORE);
+}
+
+void destroyHalo(
+    Halo *halo
+) {
+  delete[] halo->neighbor;
+  delete[] halo->send_ptr;
+  delete[] halo->send_idx;
+  delete[] halo->recv_ptr;
+  delete[] halo->buffer;
+  delete[] halo->request;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    laplacian_mpi.cpp
+/// @brief   The implementation of local Laplacian construction. (MPI version)
+///
+
+#include <algorithm>
+#include <cmath>
+#include <distributed.hpp>
+using namespace std;
+
+// An entry of a sparse matrix
+struct Entry {
+  int    row;
+  int    col;
+  double val;
+};
+
+// The cotangent weight of the edge row-col opposite to mid; as in constructLaplacianSparse
+static double cotWeight( const int nv, const double *V, const int row, const int col, const int mid ) {
+  double v[3] = {V[row]-V[mid], V[nv+row]-V[nv+mid], V[2*nv+row]-V[2*nv+mid]};
+  double b[3] = {V[col]-V[mid], V[nv+col]-V[nv+mid], V[2*nv+col]-V[2*nv+mid]};
+  double z[3] = {v[1]*b[2]-v[2]*b[1], v[2]*b[0]-v[0]*b[2], v[0]*b[1]-v[1]*b[0]};
+  return -0.5*(v[0]*b[0]+v[1]*b[1]+v[2]*b[2]) / sqrt(z[0]*z[0]+z[1]*z[1]+z[2]*z[2]);
+}
+
+// Sort the entries and sum the duplicates into CSR format
+static void entryToCsr( const int n, const int nnz, Entry *A, double **ptr_val, int **ptr_row, int **ptr_col ) {
+  sort(A, A+nnz, []( const Entry &a, const Entry &b ) { return a.row < b.row || (a.row == b.row && a.col < b.col); });
+  int count = 0;
+  for ( int i = 0; i < nnz; ++i ) {
+    count += (i == 0 || A[i].row != A[i-1].row || A[i].col != A[i-1].col);
+  }
+  double *val = *ptr_val = new double[count];
+  int    *row = *ptr_row = new int[n+1];
+  int    *col = *ptr_col = new int[count];
+  fill(row, row+n+1, 0);
+  count = 0;
+  for ( int i = 0; i < nnz; ++i ) {
+    if ( i == 0 || A[i].row != A[i-1].row || A[i].col != A[i-1].col ) {
+      val[count] = A[i].val;
+      col[count] = A[i].col;
+      ++row[A[i].row+1];
+      ++count;
+    } else {
+      val[count-1] += A[i].val;
+    }
+  }
+  for ( int i = 0; i < n; ++i ) {
+    row[i+1] += row[i];
+  }
+}
+
+void constructLaplacianMpi(
+    const Method   method,
+    const int      nl,
+    const int      nb,
+    const int      nown,
+    const int      nf,
+    const double  *V,
+    const int     *F,
+    double       **ptr_Lii_val,
+    int          **ptr_Lii_row,
+    int          **ptr_Lii_col,
+    double       **ptr_Lib_val,
+    int          **ptr_Lib_row,
+    int          **ptr_Lib_col
+) {
+  auto owned = [=]( const int i ) { return i >= nb && i < nb+nown; };
+
+  // The diagonal entries come first, so that they are present even without neighbours
+  Entry *Lii = new Entry[nown + 6*nf];
+  Entry *Lib = new Entry[6*nf];
+  int nnz_ii = nown, nnz_ib = 0;
+  for ( int i = 0; i < nown; ++i ) {
+    Lii[i] = Entry{i, i, 0.0};
+  }
+
+  // Add w to the entry (row, col) and -w to the diagonal
+  auto add = [&]( const int row, const int col, const double w ) {
+    if ( col >= nb ) {
+      Lii[nnz_ii++] = Entry{row-nb, col-nb, w};
+    } else {
+      Lib[nnz_ib++] = Entry{row-nb, col, w};
+    }
+    Lii[row-nb].val -= w;
+  };
+
+  for ( int i = 0; i < nf; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const int row = F[k*nf+i]-1;
+      const int col = F[(k+1)%3*nf+i]-1;
+      const int mid = F[(k+2)%3*nf+i]-1;
+      if ( method == Method::KIRCHHOFF ) {
+        // The opposite half edge belongs to the neighbouring face
+        if ( owned(row) ) {
+          add(row, col, -1.0);
+        }
+      } else {
+        if ( !owned(row) && !owned(col) ) {
+          continue;
+        }
+        const double w = cotWeight(nl, V, row, col, mid);
+        if ( owned(row) ) {
+          add(row, col, w);
+        }
+        if ( owned(col) ) {
+          add(col, row, w);
+        }
+      }
+    }
+  }
+
+  entryToCsr(nown, nnz_ii, Lii, ptr_Lii_val, ptr_Lii_row, ptr_Lii_col);
+  entryToCsr(nown, nnz_ib, Lib, ptr_Lib_val, ptr_Lib_row, ptr_Lib_col);
+
+  delete[] Lii;
+  delete[] Lib;
+}
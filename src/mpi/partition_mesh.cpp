@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    partition_mesh.cpp
+/// @brief   The implementation of mesh partitioning.
+///
+
+#include <algorithm>
+#include <vector>
+#include <distributed.hpp>
+using namespace std;
+
+// A range of order to be split into parts
+struct Segment {
+  int lo, hi, npart, part;
+};
+
+void partitionMesh(
+    const int  nv,
+    const int  nb,
+    const int  nf,
+    const int *F,
+    const int  npart,
+    int       *order,
+    int       *start
+) {
+  const int ni = nv-nb;
+
+  // The graph of the interior vertices; CSR format (an edge is listed once per incident face)
+  int *A_row = new int[ni+1];
+  fill(A_row, A_row+ni+1, 0);
+  for ( int i = 0; i < nf; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const int a = F[k*nf+i]-1-nb, b = F[(k+1)%3*nf+i]-1-nb;
+      if ( a >= 0 && b >= 0 ) {
+        ++A_row[a+1];
+        ++A_row[b+1];
+      }
+    }
+  }
+  for ( int i = 0; i < ni; ++i ) {
+    A_row[i+1] += A_row[i];
+  }
+  int *A_col = new int[A_row[ni]];
+  int *pos   = new int[ni];
+  copy(A_row, A_row+ni, pos);
+  for ( int i = 0; i < nf; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      const int a = F[k*nf+i]-1-nb, b = F[(k+1)%3*nf+i]-1-nb;
+      if ( a >= 0 && b >= 0 ) {
+        A_col[pos[a]++] = b;
+        A_col[pos[b]++] = a;
+      }
+    }
+  }
+
+  int  *mark    = new int[ni];
+  int  *stamp   = new int[ni];
+  int  *queue   = new int[ni];
+  int  *bfs     = new int[ni];
+  bool *visited = new bool[ni];
+  fill(mark, mark+ni, -1);
+  fill(stamp, stamp+ni, -1);
+  fill(visited, visited+ni, false);
+  for ( int i = 0; i < ni; ++i ) {
+    order[i] = i;
+  }
+
+  auto degree = [=]( const int i ) { return A_row[i+1]-A_row[i]; };
+
+  // Breadth-first search from root within the segment; returns the number of levels and the start of the last level
+  int nseg = 0, nstamp = 0;
+  auto search = [&]( const int root, int *ptr_last, int *ptr_end ) {
+    int head = 0, end = 0, last = 0, nlevel = 0;
+    stamp[root] = nstamp;
+    queue[end++] = root;
+    while ( head < end ) {
+      last = head;
+      ++nlevel;
+      for ( int level_end = end; head < level_end; ++head ) {
+        const int i = queue[head];
+        for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+          if ( mark[A_col[j]] == nseg && stamp[A_col[j]] != nstamp ) {
+            stamp[A_col[j]] = nstamp;
+            queue[end++] = A_col[j];
+          }
+        }
+      }
+    }
+    ++nstamp;
+    *ptr_last = last;
+    *ptr_end  = end;
+    return nlevel;
+  };
+
+  // Pseudo-peripheral vertex (George & Liu) of the component of s within the segment
+  auto peripheral = [&]( const int s ) {
+    int root = s, last, end;
+    int nlevel = search(root, &last, &end);
+    for ( int j = 0; j < end; ++j ) {
+      if ( degree(queue[j]) < degree(root) ) {
+        root = queue[j];
+      }
+    }
+    nlevel = search(root, &last, &end);
+    while ( true ) {
+      int x = queue[last];
+      for ( int j = last; j < end; ++j ) {
+        if ( degree(queue[j]) < degree(x) ) {
+          x = queue[j];
+        }
+      }
+      int last_x, end_x;
+      int nlevel_x = search(x, &last_x, &end_x);
+      if ( nlevel_x <= nlevel ) {
+        return root;
+      }
+      root = x;
+      nlevel = nlevel_x;
+      last = last_x;
+      end = end_x;
+    }
+  };
+
+  // Recursive bisection; the parts are laid out in order
+  vector<Segment> stack(1, Segment{0, ni, npart, 0});
+  while ( !stack.empty() ) {
+    const Segment seg = stack.back();
+    stack.pop_back();
+    if ( seg.npart == 1 ) {
+      start[seg.part] = seg.lo;
+      continue;
+    }
+
+    // Breadth-first ordering of the segment, one component after another
+    ++nseg;
+    for ( int i = seg.lo; i < seg.hi; ++i ) {
+      mark[order[i]] = nseg;
+    }
+    int count = seg.lo;
+    for ( int s = seg.lo; s < seg.hi; ++s ) {
+      if ( visited[order[s]] ) {
+        continue;
+      }
+      const int root = peripheral(order[s]);
+      visited[root] = true;
+      bfs[count++] = root;
+      for ( int head = count-1; head < count; ++head ) {
+        const int i = bfs[head];
+        for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+          if ( mark[A_col[j]] == nseg && !visited[A_col[j]] ) {
+            visited[A_col[j]] = true;
+            bfs[count++] = A_col[j];
+          }
+        }
+      }
+    }
+    for ( int i = seg.lo; i < seg.hi; ++i ) {
+      order[i] = bfs[i];
+      visited[order[i]] = false;
+    }
+
+    // Split the ordering in proportion to the number of parts on each side
+    const int npart0 = seg.npart / 2;
+    const int split  = seg.lo + int(long(seg.hi-seg.lo) * npart0 / seg.npart);
+    stack.push_back(Segment{split, seg.hi, seg.npart-npart0, seg.part+npart0});
+    stack.push_back(Segment{seg.lo, split, npart0, seg.part});
+  }
+  start[npart] = ni;
+
+  delete[] A_row;
+  delete[] A_col;
+  delete[] pos;
+  delete[] mark;
+  delete[] stamp;
+  delete[] queue;
+  delete[] bfs;
+  delete[] visited;
+}
@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    pcg_mpi.cpp
+/// @brief   The implementation of the distributed preconditioned conjugate gradient method. (MPI version)
+///
+
+#include <algorithm>
+#include <cmath>
+#include <distributed.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+static void spmvRows( const int begin, const int end, const double *A_val, const int *A_row, const int *A_col,
+                      const double *x, double *y ) {
+  for ( int i = begin; i < end; ++i ) {
+    double sum = 0.0;
+    for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+      sum += A_val[j] * x[A_col[j]];
+    }
+    y[i] = sum;
+  }
+}
+
+static double dot( MPI_Comm comm, const int n, const double *x, const double *y ) {
+  double sum = 0.0;
+  for ( int i = 0; i < n; ++i ) {
+    sum += x[i] * y[i];
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, comm);
+  return sum;
+}
+
+// Two inner products summed over all ranks at once
+static void dot2( MPI_Comm comm, const int n, const double *x1, const double *y1, const double *x2, const double *y2,
+                  double *ptr_dot1, double *ptr_dot2 ) {
+  double sum[2] = {0.0, 0.0};
+  for ( int i = 0; i < n; ++i ) {
+    sum[0] += x1[i] * y1[i];
+    sum[1] += x2[i] * y2[i];
+  }
+  MPI_Allreduce(MPI_IN_PLACE, sum, 2, MPI_DOUBLE, MPI_SUM, comm);
+  *ptr_dot1 = sum[0];
+  *ptr_dot2 = sum[1];
+}
+
+void spmvMpi(
+    MPI_Comm      comm,
+    Halo         *halo,
+    const double *A_val,
+    const int    *A_row,
+    const int    *A_col,
+    double       *x,
+    double       *y
+) {
+  SCSC_PROFILE_ZONE("spmv");
+  const int n = halo->nown;
+  const double nnz = A_row[n] - A_row[0];
+  SCSC_PROFILE_WORK(12.0*nnz + 20.0*n + 4.0, 2.0*nnz);
+
+  // The rows whose last (largest) column is owned do not wait for the ghost entries
+  startHalo(comm, halo, x);
+  for ( int i = 0; i < n; ++i ) {
+    if ( A_row[i+1] == A_row[i] || A_col[A_row[i+1]-1] < n ) {
+      spmvRows(i, i+1, A_val, A_row, A_col, x, y);
+    }
+  }
+  {
+    SCSC_PROFILE_ZONE("halo wait");
+    finishHalo(halo);
+  }
+  for ( int i = 0; i < n; ++i ) {
+    if ( A_row[i+1] > A_row[i] && A_col[A_row[i+1]-1] >= n ) {
+      spmvRows(i, i+1, A_val, A_row, A_col, x, y);
+    }
+  }
+}
+
+int solvePcgMpi(
+    MPI_Comm              comm,
+    Halo                 *halo,
+    const double         *A_val,
+    const int            *A_row,
+    const int            *A_col,
+    const double         *b,
+    double               *x,
+    const Preconditioner &precond,
+    const double          tol,
+    const int             maxit,
+    double               *ptr_res
+) {
+  SCSC_PROFILE_ZONE("pcg");
+  const int n = halo->nown;
+  double *r = new double[n];
+  double *z = new double[n];
+  double *p = new double[n+halo->nghost];
+  double *q = new double[n];
+
+  // r := b - A * x
+  spmvMpi(comm, halo, A_val, A_row, A_col, x, r);
+  for ( int i = 0; i < n; ++i ) {
+    r[i] = b[i] - r[i];
+  }
+
+  // z := inv(M) * r
+  precond(r, z);
+  double bb, rr, rz;
+  dot2(comm, n, b, b, r, r, &bb, &rr);
+  double nrmb = sqrt(bb);
+  if ( nrmb == 0.0 ) {
+    nrmb = 1.0;
+  }
+  double res = sqrt(rr) / nrmb;
+
+  int iter = 0;
+  if ( res > tol ) {
+    rz = dot(comm, n, r, z);
+    copy(z, z+n, p);
+
+    while ( iter < maxit ) {
+      ++iter;
+
+      // alpha := (r' * z) / (p' * A * p)
+      spmvMpi(comm, halo, A_val, A_row, A_col, p, q);
+      double alpha = rz / dot(comm, n, p, q);
+
+      // x += alpha * p;  r -= alpha * q
+      for ( int i = 0; i < n; ++i ) {
+        x[i] += alpha * p[i];
+        r[i] -= alpha * q[i];
+      }
+
+      // ||r|| and r' * z share one reduction
+      precond(r, z);
+      double rz_new;
+      dot2(comm, n, r, r, r, z, &rr, &rz_new);
+      res = sqrt(rr) / nrmb;
+      if ( res <= tol ) {
+        break;
+      }
+
+      // p := z + beta * p
+      double beta = rz_new / rz;
+      rz = rz_new;
+      for ( int i = 0; i < n; ++i ) {
+        p[i] = z[i] + beta * p[i];
+      }
+    }
+  }
+
+  if ( ptr_res != nullptr ) {
+    *ptr_res = res;
+  }
+
+  delete[] r;
+  delete[] z;
+  delete[] p;
+  delete[] q;
+
+  return iter;
+}
+
+void solveHarmonicMpi(
+    MPI_Comm      comm,
+    Halo         *halo,
+    const int     nb,
+    const double *Lii_val,
+    const int    *Lii_row,
+    const int    *Lii_col,
+    const double *Lib_val,
+    const int    *Lib_row,
+    const int    *Lib_col,
+    const double *Ub,
+    double       *Ui,
+    SolveInfo    *info
+) {
+  const int n = halo->nown;
+  const double tol = 1e-10;
+
+  // Jacobi preconditioner
+  double *dinv = new double[n];
+  for ( int i = 0; i < n; ++i ) {
+    dinv[i] = 1.0;
+    for ( int j = Lii_row[i]; j < Lii_row[i+1]; ++j ) {
+      if ( Lii_col[j] == i ) {
+        dinv[i] = 1.0 / Lii_val[j];
+      }
+    }
+  }
+  auto precond = [=]( const double *r, double *z ) {
+    for ( int i = 0; i < n; ++i ) {
+      z[i] = dinv[i] * r[i];
+    }
+  };
+
+  // The size of the whole problem bounds the number of iterations
+  int ni = n;
+  MPI_Allreduce(MPI_IN_PLACE, &ni, 1, MPI_INT, MPI_SUM, comm);
+
+  // Solve Lii * Ui = - Lib * Ub, starting from zero
+  SolveInfo stat = {0, 0.0, 0.0, 0, 0, false, 0, 0};
+  double *b = new double[n];
+  double *x = new double[n+halo->nghost];
+  for ( int k = 0; k < 2; ++k ) {
+    spmvRows(0, n, Lib_val, Lib_row, Lib_col, Ub+k*nb, b);
+    for ( int i = 0; i < n; ++i ) {
+      b[i] = -b[i];
+    }
+    fill(x, x+n+halo->nghost, 0.0);
+    double res;
+    int iter = solvePcgMpi(comm, halo, Lii_val, Lii_row, Lii_col, b, x, precond, tol, 10*ni+100, &res);
+    copy(x, x+n, Ui+k*n);
+    stat.iter += iter;
+    stat.res0 = max(stat.res0, (iter > 0) ? 1.0 : res);  // the relative residual of zero
+    stat.res = max(stat.res, res);
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+
+  delete[] b;
+  delete[] x;
+  delete[] dinv;
+}
@@ -7,8 +7,12 @@
 ///
 
 #include <harmonic.hpp>
+#include <profiler.hpp>
+#include <simd.hpp>
+#include <workspace.hpp>
 #include <iostream>
 #include <cmath>
+#include <memory>
 #include <tuple>
 using namespace std;
 
@@ -62,19 +66,23 @@ void coo2csr(
   const int csr_row_num,
   double ** csr_a,
   int **csr_row,
-  int **csr_col
+  int **csr_col,
+  Workspace *out
 ){
+  SCSC_PROFILE_ZONE("coo2csr");
+  // The triplets are sorted in place and read once more, giving at most one entry each; the duplicates are summed
+  SCSC_PROFILE_WORK(60.0*coo_num + 4.0*(csr_row_num+1), coo_num);
 
   qsort(coo, coo_num, sizeof(tuple<int,int,double>), compareTuple);
-  *csr_row = new int [csr_row_num+1];
+  *csr_row = out ? out->take<int>(csr_row_num+1) : new int [csr_row_num+1];
   int nnz=1;
   for (int i=1; i<coo_num; i++) {
     if (get<0>(coo[i])!=get<0>(coo[i-1]) || get<1>(coo[i])!=get<1>(coo[i-1])){
       nnz++;
     }
   }
-  *csr_a = new double [nnz];
-  *csr_col = new int [nnz];
+  *csr_a = out ? out->take<double>(nnz) : new double [nnz];
+  *csr_col = out ? out->take<int>(nnz) : new int [nnz];
   double *A=*csr_a;
   int *row=*csr_row, *col=*csr_col;
   for (int i=0; i<csr_row_num+1; i++){
@@ -108,8 +116,12 @@ void coo2csr(
     row[i]=index;
   }
   if (index!=nnz){
-    cerr<<"coo2csr Error\n";
-    exit(1);
+    if (out == nullptr) {
+      delete[] *csr_a;
+      delete[] *csr_row;
+      delete[] *csr_col;
+    }
+    throw HarmonicError(ErrorCode::INTERNAL, "coo2csr: the entries do not match the counted nonzeros");
   }
 }
 
@@ -125,7 +137,10 @@ void constructLaplacianSparse(
   int **ptr_Lii_col,
   double **ptr_Lib_val,
   int **ptr_Lib_row,
-  int **ptr_Lib_col
+  int **ptr_Lib_col,
+  Workspace *work,
+  Workspace *out,
+  const double *W
 ) {
   int Lii_nnz=nv-nb, Lib_nnz=0, F_x=0, F_y=0, F_z=0;
   for (int i=0; i<nf; i++) {
@@ -148,8 +163,13 @@ void constructLaplacianSparse(
     }
 
   }
-  tuple<int, int, double> *Lib= new tuple<int, int , double> [Lib_nnz];
-  tuple<int, int, double> *Lii= new tuple<int, int , double> [Lii_nnz];
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  tuple<int, int, double> *Lib= ws.take<tuple<int, int, double>>(Lib_nnz);
+  tuple<int, int, double> *Lii= ws.take<tuple<int, int, double>>(Lii_nnz);
+  uninitialized_fill_n(Lib, Lib_nnz, tuple<int, int, double>());
+  uninitialized_fill_n(Lii, Lii_nnz, tuple<int, int, double>());
   for (int i=0; i<nv-nb; i++) {
     get<2>(Lii[i])=0;
     get<1>(Lii[i])=i;
@@ -181,8 +201,8 @@ void constructLaplacianSparse(
       }
     }
     if (index_Lib!=Lib_nnz || index_Lii != Lii_nnz) {
-      cerr<<"SIMPLE: nnz, index  Error\n";
-      exit(1);
+      ws.release(top);
+      throw HarmonicError(ErrorCode::INTERNAL, "Kirchhoff Laplacian: the entries do not match the counted nonzeros");
     }
 
   }else if (method == Method::COTANGENT) // Cotangent Laplacian Matrix
@@ -197,20 +217,26 @@ void constructLaplacianSparse(
         int row=F[k*nf+i]-1;
         int col=F[(k+1)%3*nf+i]-1;
         int mid=F[(k+2)%3*nf+i]-1;
-        // double v[3]={V[F]-V[col], V[nv+row]-V[nv+col], V[2*nv+row]-V[2*nv+col]};
-        double v[3]={V[row]-V[mid], V[nv+row]-V[nv+mid], V[2*nv+row]-V[2*nv+mid]};
-        double b[3]={V[col]-V[mid], V[nv+col]-V[nv+mid], V[2*nv+col]-V[2*nv+mid]};
+        double w;
+        if (W != nullptr) {
+          w=W[k*nf+i];
+        } else {
+          // double v[3]={V[F]-V[col], V[nv+row]-V[nv+col], V[2*nv+row]-V[2*nv+col]};
+          double v[3]={V[row]-V[mid], V[nv+row]-V[nv+mid], V[2*nv+row]-V[2*nv+mid]};
+          double b[3]={V[col]-V[mid], V[nv+col]-V[nv+mid], V[2*nv+col]-V[2*nv+mid]};
+          w=-0.5*Dot(3, v, b)/CrossNorm(v, b);
+        }
         if (row >= nb && col >= nb) {
           // Lii
           get<0>(Lii[index_Lii])=row-nb;
           get<1>(Lii[index_Lii])=col-nb;
-          get<2>(Lii[index_Lii])=-0.5*Dot(3, v, b)/CrossNorm(v, b);
+          get<2>(Lii[index_Lii])=w;
           get<2>(Lii[row-nb])-=get<2>(Lii[index_Lii]);
           index_Lii++;
           //swap
           get<0>(Lii[index_Lii])=col-nb;
           get<1>(Lii[index_Lii])=row-nb;
-          get<2>(Lii[index_Lii])=-0.5*Dot(3, v, b)/CrossNorm(v, b);
+          get<2>(Lii[index_Lii])=w;
           get<2>(Lii[col-nb])-=get<2>(Lii[index_Lii]);
           index_Lii++;
         }
@@ -218,7 +244,7 @@ void constructLaplacianSparse(
           // Lib
           get<0>(Lib[index_Lib])=row-nb;
           get<1>(Lib[index_Lib])=col;
-          get<2>(Lib[index_Lib])=-0.5*Dot(3, v, b)/CrossNorm(v, b);
+          get<2>(Lib[index_Lib])=w;
           get<2>(Lii[row-nb])-=get<2>(Lib[index_Lib]);
           index_Lib++;
         }
@@ -226,21 +252,36 @@ void constructLaplacianSparse(
           // Lbi swap col, row
           get<0>(Lib[index_Lib])=col-nb;
           get<1>(Lib[index_Lib])=row;
-          get<2>(Lib[index_Lib])=-0.5*Dot(3, v, b)/CrossNorm(v, b);
+          get<2>(Lib[index_Lib])=w;
           get<2>(Lii[col-nb])-=get<2>(Lib[index_Lib]);
           index_Lib++;
         }
       }
     }
     if (index_Lib != Lib_nnz || index_Lii != Lii_nnz) {
-      cerr<<"Complex: index, nnz Error\n";
-      cerr<<index_Lib<<" "<<Lib_nnz<<"\n";
-      exit(1);
+      ws.release(top);
+      throw HarmonicError(ErrorCode::INTERNAL, "Cotangent Laplacian: the entries do not match the counted nonzeros");
     }
 
   }
-  coo2csr(Lib_nnz, Lib, nv-nb, ptr_Lib_val, ptr_Lib_row, ptr_Lib_col);
-  coo2csr(Lii_nnz, Lii, nv-nb, ptr_Lii_val, ptr_Lii_row, ptr_Lii_col);
-  delete [] Lii;
-  delete [] Lib;
+  // The faces, the vertices (unless the weights are given), and the triplets; a cotangent weight costs 31 flops
+  const bool weigh = (method == Method::COTANGENT && W == nullptr);
+  SCSC_PROFILE_WORK(12.0*nf + (weigh ? 72.0*nf : (W ? 24.0*nf : 0.0)) + 16.0*(Lii_nnz+Lib_nnz),
+                    (weigh ? 93.0*nf : 0.0) + Lii_nnz + Lib_nnz);
+  coo2csr(Lib_nnz, Lib, nv-nb, ptr_Lib_val, ptr_Lib_row, ptr_Lib_col, out);
+  coo2csr(Lii_nnz, Lii, nv-nb, ptr_Lii_val, ptr_Lii_row, ptr_Lii_col, out);
+  ws.release(top);
+}
+
+void cotangentWeightSparse(
+  const int nv,
+  const int nf,
+  const double *V,
+  const int *F,
+  const int begin,
+  const int end,
+  double *W
+) {
+  SCSC_PROFILE_WORK(108.0*(end-begin), 93.0*(end-begin));
+  simd().cotangent(nv, nf, V, F, begin, end, W);
 }
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    convergence_log.cpp
+/// @brief   The implementation of the convergence history writer.
+///
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterative.hpp>
+using namespace std;
+
+bool writeConvergence(
+    const char          *path,
+    const int            n,
+    const IterationInfo *history
+) {
+  FILE *file = fopen(path, "w");
+  if ( file == nullptr ) {
+    cerr << "Can not write the convergence history " << path << endl;
+    return false;
+  }
+
+  const size_t len = strlen(path);
+  const bool json = len >= 5 && strcmp(path+len-5, ".json") == 0;
+  if ( json ) {
+    fprintf(file, "[\n");
+    for ( int i = 0; i < n; ++i ) {
+      const IterationInfo &h = history[i];
+      fprintf(file, "  {\"rhs\": %d, \"iter\": %d, \"res\": %.9e, \"time\": %.9e, \"time_precond\": %.9e, "
+                    "\"time_spmv\": %.9e}%s\n",
+              h.rhs, h.iter, h.res, h.time, h.time_precond, h.time_spmv, (i+1 < n) ? "," : "");
+    }
+    fprintf(file, "]\n");
+  } else {
+    fprintf(file, "rhs,iter,res,time,time_precond,time_spmv\n");
+    for ( int i = 0; i < n; ++i ) {
+      const IterationInfo &h = history[i];
+      fprintf(file, "%d,%d,%.9e,%.9e,%.9e,%.9e\n", h.rhs, h.iter, h.res, h.time, h.time_precond, h.time_spmv);
+    }
+  }
+
+  if ( fclose(file) != 0 ) {
+    cerr << "Can not write the convergence history " << path << endl;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,308 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    factor_cache.cpp
+/// @brief   The implementation of the factorization cache.
+///
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <factor_cache.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+static const char kFactorMagic[8]    = {'S', 'C', 'S', 'C', 'F', 'A', 'C', '2'};
+static const char kLaplacianMagic[8] = {'S', 'C', 'S', 'C', 'L', 'A', 'P', '1'};
+
+// The file header; the sections follow in order, each 8-byte aligned
+struct CacheHeader {
+  char     magic[8];
+  uint64_t topology;
+  int32_t  n;
+  int32_t  bw;
+  int64_t  len[7];
+};
+
+// A section of a cache file
+struct Section {
+  const void *data;
+  size_t      size;
+};
+
+static size_t align8( const size_t size ) {
+  return (size + 7) / 8 * 8;
+}
+
+uint64_t hashBytes(
+    uint64_t     h,
+    const void  *data,
+    const size_t size
+) {
+  const unsigned char *p = static_cast<const unsigned char*>(data);
+  for ( size_t i = 0; i < size; ++i ) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+static atomic<unsigned> g_serial(0);  // the serial number of the temporary files of this process
+
+// Write the header and the sections to a temporary file and rename it, so that readers never see a partial file; the
+// temporary file is unique to the call, so that the threads of a process may write the same cache
+static bool writeCache( const char *path, const CacheHeader &header, const Section *section, const int nsection ) {
+  char tmp[4096+48];
+  snprintf(tmp, sizeof(tmp), "%s.%d.%u", path, int(getpid()), g_serial.fetch_add(1));
+  FILE *file = fopen(tmp, "wb");
+  if ( file == nullptr ) {
+    cerr << "Can not write the cache file " << tmp << endl;
+    return false;
+  }
+  const char pad[8] = {0};
+  bool good = fwrite(&header, sizeof(header), 1, file) == 1;
+  for ( int i = 0; i < nsection && good; ++i ) {
+    const size_t npad = align8(section[i].size) - section[i].size;
+    good = fwrite(section[i].data, 1, section[i].size, file) == section[i].size && fwrite(pad, 1, npad, file) == npad;
+  }
+  good = (fclose(file) == 0) && good;
+  if ( !good || rename(tmp, path) != 0 ) {
+    cerr << "Can not write the cache file " << path << endl;
+    remove(tmp);
+    return false;
+  }
+  return true;
+}
+
+// Map a cache file and locate its sections; the sizes of the sections are given by the header
+static void* mapCache( const char *path, const char *magic, const uint64_t topology, const int n,
+                       const int *elem, const int nsection, const void **section, size_t *ptr_size ) {
+  int fd = open(path, O_RDONLY);
+  if ( fd < 0 ) {
+    return nullptr;
+  }
+  struct stat st;
+  if ( fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CacheHeader) ) {
+    close(fd);
+    return nullptr;
+  }
+  void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( map == MAP_FAILED ) {
+    return nullptr;
+  }
+
+  const CacheHeader *header = static_cast<const CacheHeader*>(map);
+  size_t offset = sizeof(CacheHeader);
+  for ( int i = 0; i < nsection; ++i ) {
+    section[i] = static_cast<const char*>(map) + offset;
+    offset += align8(elem[i] * header->len[i]);
+  }
+  if ( memcmp(header->magic, magic, 8) != 0 || header->topology != topology || header->n != n ||
+       offset != size_t(st.st_size) ) {
+    cerr << "The cache file " << path << " does not match; ignored." << endl;
+    munmap(map, st.st_size);
+    return nullptr;
+  }
+  *ptr_size = st.st_size;
+  return map;
+}
+
+void initFactorCache(
+    const char   *dir,
+    const Method  method,
+    const int     nv,
+    const int     nb,
+    const int     nf,
+    const int    *F,
+    FactorCache  *cache
+) {
+  const int sizes[4] = {int(method), nv, nb, nf};
+  cache->topology = hashBytes(hashBytes(kHashBasis, sizes, sizeof(sizes)), F, sizeof(int)*3*nf);
+  snprintf(cache->path, sizeof(cache->path), "%s/%016llx", dir, static_cast<unsigned long long>(cache->topology));
+}
+
+bool loadFactorCache(
+    const FactorCache *cache,
+    const int          n,
+    FactorData        *data
+) {
+  if ( cache->memory != nullptr ) {
+    const FactorMemory *memory = cache->memory;
+    memset(data, 0, sizeof(FactorData));
+    data->n = n;
+    if ( memory->n != n ) {
+      return false;
+    }
+    data->bw      = memory->bw;
+    data->perm    = memory->perm;
+    data->factor  = memory->factor;
+    data->nfactor = memory->nfactor;
+    data->val     = memory->val;
+    data->nval    = memory->nval;
+    return true;
+  }
+
+  char path[sizeof(cache->path)+8];
+  snprintf(path, sizeof(path), "%s.fac", cache->path);
+
+  const int elem[3] = {sizeof(int), sizeof(double), sizeof(double)};
+  const void *section[3];
+  memset(data, 0, sizeof(FactorData));
+  data->n = n;
+  data->map = mapCache(path, kFactorMagic, cache->topology, n, elem, 3, section, &data->size);
+  if ( data->map == nullptr ) {
+    return false;
+  }
+
+  const CacheHeader *header = static_cast<const CacheHeader*>(data->map);
+  data->bw      = header->bw;
+  data->perm    = static_cast<const int*>(section[0]);
+  data->nfactor = header->len[1];
+  data->factor  = (data->nfactor > 0) ? static_cast<const double*>(section[1]) : nullptr;
+  data->nval    = header->len[2];
+  data->val     = (data->nval > 0) ? static_cast<const double*>(section[2]) : nullptr;
+  return true;
+}
+
+bool storeFactorCache(
+    const FactorCache *cache,
+    const int          n,
+    const int          bw,
+    const int         *perm,
+    const double      *factor,
+    const long         nfactor,
+    const double      *val,
+    const long         nval
+) {
+  if ( cache->memory != nullptr ) {
+    FactorMemory *memory = cache->memory;
+    memory->store.clear();
+    memory->n       = n;
+    memory->bw      = bw;
+    memory->perm    = memory->store.take<int>(n);
+    memory->nfactor = (factor != nullptr) ? nfactor : 0;
+    memory->factor  = (factor != nullptr) ? memory->store.take<double>(nfactor) : nullptr;
+    memory->nval    = (factor != nullptr && val != nullptr) ? nval : 0;
+    memory->val     = (memory->nval > 0) ? memory->store.take<double>(nval) : nullptr;
+    copy(perm, perm+n, memory->perm);
+    copy(factor, factor+memory->nfactor, memory->factor);
+    copy(val, val+memory->nval, memory->val);
+    return true;
+  }
+
+  char path[sizeof(cache->path)+8];
+  snprintf(path, sizeof(path), "%s.fac", cache->path);
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kFactorMagic, 8);
+  header.topology = cache->topology;
+  header.n        = n;
+  header.bw       = bw;
+  header.len[0]   = n;
+  header.len[1]   = (factor != nullptr) ? nfactor : 0;
+  header.len[2]   = (factor != nullptr && val != nullptr) ? nval : 0;
+
+  const Section section[3] = {
+    {perm,   sizeof(int) * header.len[0]},
+    {factor, sizeof(double) * header.len[1]},
+    {val,    sizeof(double) * header.len[2]},
+  };
+  return writeCache(path, header, section, 3);
+}
+
+void releaseFactorCache(
+    FactorData *data
+) {
+  if ( data->map != nullptr ) {
+    munmap(data->map, data->size);
+  }
+  memset(data, 0, sizeof(FactorData));
+}
+
+bool loadLaplacianCache(
+    const FactorCache *cache,
+    const int          nv,
+    const int          nb,
+    LaplacianData     *data
+) {
+  char path[sizeof(cache->path)+8];
+  snprintf(path, sizeof(path), "%s.lap", cache->path);
+
+  const int elem[7] = {sizeof(double), sizeof(int), sizeof(int), sizeof(double),
+                       sizeof(int), sizeof(int), sizeof(double)};
+  const void *section[7];
+  memset(data, 0, sizeof(LaplacianData));
+  data->map = mapCache(path, kLaplacianMagic, cache->topology, nv-nb, elem, 7, section, &data->size);
+  if ( data->map == nullptr ) {
+    return false;
+  }
+
+  const CacheHeader *header = static_cast<const CacheHeader*>(data->map);
+  if ( header->len[0] != 3L*nv || header->len[1] != nv-nb+1 || header->len[4] != nv-nb+1 ) {
+    releaseLaplacianCache(data);
+    return false;
+  }
+  data->V       = static_cast<const double*>(section[0]);
+  data->Lii_row = static_cast<const int*>(section[1]);
+  data->Lii_col = static_cast<const int*>(section[2]);
+  data->Lii_val = static_cast<const double*>(section[3]);
+  data->Lib_row = static_cast<const int*>(section[4]);
+  data->Lib_col = static_cast<const int*>(section[5]);
+  data->Lib_val = static_cast<const double*>(section[6]);
+  return true;
+}
+
+bool storeLaplacianCache(
+    const FactorCache *cache,
+    const int          nv,
+    const int          nb,
+    const double      *V,
+    const double      *Lii_val,
+    const int         *Lii_row,
+    const int         *Lii_col,
+    const double      *Lib_val,
+    const int         *Lib_row,
+    const int         *Lib_col
+) {
+  const int ni = nv-nb;
+  char path[sizeof(cache->path)+8];
+  snprintf(path, sizeof(path), "%s.lap", cache->path);
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kLaplacianMagic, 8);
+  header.topology = cache->topology;
+  header.n        = ni;
+  header.len[0]   = 3L*nv;
+  header.len[1]   = ni+1;
+  header.len[2]   = Lii_row[ni];
+  header.len[3]   = Lii_row[ni];
+  header.len[4]   = ni+1;
+  header.len[5]   = Lib_row[ni];
+  header.len[6]   = Lib_row[ni];
+
+  const Section section[7] = {
+    {V,       sizeof(double) * header.len[0]},
+    {Lii_row, sizeof(int)    * header.len[1]},
+    {Lii_col, sizeof(int)    * header.len[2]},
+    {Lii_val, sizeof(double) * header.len[3]},
+    {Lib_row, sizeof(int)    * header.len[4]},
+    {Lib_col, sizeof(int)    * header.len[5]},
+    {Lib_val, sizeof(double) * header.len[6]},
+  };
+  return writeCache(path, header, section, 7);
+}
+
+void releaseLaplacianCache(
+    LaplacianData *data
+) {
+  if ( data->map != nullptr ) {
+    munmap(data->map, data->size);
+  }
+  memset(data, 0, sizeof(LaplacianData));
+}
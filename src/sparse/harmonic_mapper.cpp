@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    harmonic_mapper.cpp
+/// @brief   The implementation of the reusable harmonic mapper. (sparse version)
+///
+
+#include <algorithm>
+#include <cstdlib>
+#include <harmonic_mapper.hpp>
+#include <factor_cache.hpp>
+using namespace std;
+
+HarmonicMapper::HarmonicMapper()
+  : nv_(0), nf_(0), nb_(0), nm_(-1),
+    V_(nullptr), C_(nullptr), U_(nullptr), F_(nullptr), idx_b_(nullptr), E_(nullptr), W_(nullptr),
+    Lii_val_(nullptr), Lib_val_(nullptr),
+    Lii_row_(nullptr), Lii_col_(nullptr), Lib_row_(nullptr), Lib_col_(nullptr) {
+  fill(peak_, peak_+static_cast<int>(Stage::COUNT), 0);
+}
+
+// The scope of a stage; the scratch starts empty, and is released in bulk after recording its high-water mark
+class StageScope {
+ public:
+  StageScope( Workspace &scratch, size_t &peak ) : scratch_(scratch), peak_(peak) {
+    scratch_.clear();
+    scratch_.resetHighWater();
+  }
+  ~StageScope() {
+    peak_ = scratch_.highWater();
+    scratch_.clear();
+  }
+ private:
+  Workspace &scratch_;
+  size_t    &peak_;
+};
+
+// Take the mesh arrays of the given sizes
+static void takeMesh( Workspace &mesh, const int nv, const int nf, double **V, double **C, int **F, int **idx_b ) {
+  mesh.clear();
+  *V     = mesh.take<double>(3L*nv);
+  *C     = mesh.take<double>(3L*nv);
+  *F     = mesh.take<int>(3L*nf);
+  *idx_b = mesh.take<int>(nv);
+}
+
+void HarmonicMapper::load(
+    const char *input
+) {
+  scanObject(input, &nv_, &nf_);
+  takeMesh(mesh_, nv_, nf_, &V_, &C_, &F_, &idx_b_);
+  readObject(input, nv_, nf_, V_, C_, F_);
+  E_  = nullptr;
+  W_  = nullptr;
+  nb_ = 0;
+  nm_ = -1;
+}
+
+void HarmonicMapper::stream(
+    const char  *input,
+    const Method method
+) {
+  scanObject(input, &nv_, &nf_);
+  takeMesh(mesh_, nv_, nf_, &V_, &C_, &F_, &idx_b_);
+  E_ = mesh_.take<uint64_t>(3L*nf_);
+  W_ = (method == Method::COTANGENT) ? mesh_.take<double>(3L*nf_) : nullptr;
+  streamObjectSparse(input, nv_, nf_, V_, C_, F_, E_, W_);
+  nb_ = 0;
+  nm_ = -1;
+}
+
+void HarmonicMapper::setMesh(
+    const int     nv,
+    const int     nf,
+    const double *V,
+    const double *C,
+    const int    *F
+) {
+  nv_ = nv;
+  nf_ = nf;
+  takeMesh(mesh_, nv_, nf_, &V_, &C_, &F_, &idx_b_);
+  copy(V, V+3L*nv, V_);
+  copy(C, C+3L*nv, C_);
+  copy(F, F+3L*nf, F_);
+  E_  = nullptr;
+  W_  = nullptr;
+  nb_ = 0;
+  nm_ = -1;
+}
+
+void HarmonicMapper::generate(
+    const MeshShape shape,
+    const int       n,
+    const uint64_t  seed,
+    const bool      shuffle
+) {
+  scanMesh(n, &nv_, &nf_);
+  takeMesh(mesh_, nv_, nf_, &V_, &C_, &F_, &idx_b_);
+  generateMesh(shape, n, seed, shuffle, V_, C_, F_);
+  E_  = nullptr;
+  W_  = nullptr;
+  nb_ = 0;
+  nm_ = -1;
+}
+
+void HarmonicMapper::verifyBoundary() {
+  StageScope scope(scratch_, peak_[static_cast<int>(Stage::VERIFY)]);
+  if ( E_ != nullptr ) {
+    verifyBoundarySparse(nf_, E_, &nb_, idx_b_, &scratch_);
+    E_ = nullptr;
+  } else {
+    verifyBoundarySparse(nv_, nf_, F_, &nb_, idx_b_, &scratch_);
+  }
+}
+
+void HarmonicMapper::reorderVertex() {
+  StageScope scope(scratch_, peak_[static_cast<int>(Stage::REORDER)]);
+  ::reorderVertex(nv_, nb_, nf_, V_, C_, F_, idx_b_, &scratch_);
+}
+
+// The numbering of reorderVertex: the boundary vertices in the order found, then the others in their order
+void HarmonicMapper::vertexOrder(
+    int *order
+) const {
+  fill(order, order+nv_, -1);
+  for ( int i = 0; i < nb_; ++i ) {
+    order[idx_b_[i]-1] = i;
+  }
+  int index = nb_;
+  for ( int i = 0; i < nv_; ++i ) {
+    if ( order[i] == -1 ) {
+      order[i] = index++;
+    }
+  }
+}
+
+void HarmonicMapper::constructLaplacian(
+    const Method       method,
+    const FactorCache *cache
+) {
+  StageScope scope(scratch_, peak_[static_cast<int>(Stage::LAPLACIAN)]);
+  lap_.clear();
+  nm_ = -1;
+
+  // Update the cached Laplacian if only some vertices moved
+  LaplacianData data;
+  if ( cache != nullptr && loadLaplacianCache(cache, nv_, nb_, &data) ) {
+    const int ni = nv_-nb_, nnz_ii = data.Lii_row[ni], nnz_ib = data.Lib_row[ni];
+    Lii_val_ = lap_.take<double>(nnz_ii); Lii_row_ = lap_.take<int>(ni+1); Lii_col_ = lap_.take<int>(nnz_ii);
+    Lib_val_ = lap_.take<double>(nnz_ib); Lib_row_ = lap_.take<int>(ni+1); Lib_col_ = lap_.take<int>(nnz_ib);
+    copy(data.Lii_val, data.Lii_val+nnz_ii, Lii_val_);
+    copy(data.Lii_row, data.Lii_row+ni+1,   Lii_row_);
+    copy(data.Lii_col, data.Lii_col+nnz_ii, Lii_col_);
+    copy(data.Lib_val, data.Lib_val+nnz_ib, Lib_val_);
+    copy(data.Lib_row, data.Lib_row+ni+1,   Lib_row_);
+    copy(data.Lib_col, data.Lib_col+nnz_ib, Lib_col_);
+    int *moved = scratch_.take<int>(nv_);
+    nm_ = 0;
+    for ( int i = 0; i < nv_; ++i ) {
+      if ( V_[i] != data.V[i] || V_[nv_+i] != data.V[nv_+i] || V_[2*nv_+i] != data.V[2*nv_+i] ) {
+        moved[nm_++] = i;
+      }
+    }
+    updateLaplacianSparse(method, nv_, nb_, nf_, data.V, V_, F_, nm_, moved,
+                          Lii_val_, Lii_row_, Lii_col_, Lib_val_, Lib_row_, Lib_col_);
+    releaseLaplacianCache(&data);
+    return;
+  }
+
+  constructLaplacianSparse(method, nv_, nb_, nf_, V_, F_, &Lii_val_, &Lii_row_, &Lii_col_, &Lib_val_, &Lib_row_, &Lib_col_,
+                           &scratch_, &lap_, (method == Method::COTANGENT) ? W_ : nullptr);
+}
+
+void HarmonicMapper::storeLaplacian(
+    const FactorCache *cache
+) const {
+  storeLaplacianCache(cache, nv_, nb_, V_, Lii_val_, Lii_row_, Lii_col_, Lib_val_, Lib_row_, Lib_col_);
+}
+
+void HarmonicMapper::mapBoundary() {
+  sol_.clear();
+  U_ = sol_.take<double>(2L*nv_);
+  ::mapBoundary(nv_, nb_, V_, U_);
+}
+
+void HarmonicMapper::solve(
+    const SolveOptions &options,
+    const double       *U0,
+    SolveInfo          *info
+) {
+  solve(options, U0, U_, info);
+}
+
+void HarmonicMapper::solve(
+    const SolveOptions &options,
+    const double       *U0,
+    double             *U,
+    SolveInfo          *info
+) {
+  StageScope scope(scratch_, peak_[static_cast<int>(Stage::SOLVE)]);
+  if ( options.work != nullptr ) {
+    solveHarmonicSparse(nv_, nb_, Lii_val_, Lii_row_, Lii_col_, Lib_val_, Lib_row_, Lib_col_, U, U0, options, info);
+  } else {
+    SolveOptions own = options;
+    own.work = &scratch_;
+    solveHarmonicSparse(nv_, nb_, Lii_val_, Lii_row_, Lii_col_, Lib_val_, Lib_row_, Lib_col_, U, U0, own, info);
+  }
+}
+
+void HarmonicMapper::write(
+    const char *output
+) {
+  StageScope scope(scratch_, peak_[static_cast<int>(Stage::WRITE)]);
+  writeObject(output, nv_, nf_, U_, C_, F_, &scratch_);
+}
+
+int HarmonicMapper::bandwidth() const {
+  int bw = 0;
+  for ( int i = 0; i < nv_-nb_; ++i ) {
+    for ( int j = Lii_row_[i]; j < Lii_row_[i+1]; ++j ) {
+      bw = max(bw, abs(Lii_col_[j] - i));
+    }
+  }
+  return bw;
+}
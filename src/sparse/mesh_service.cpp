@@ -0,0 +1,562 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    mesh_service.cpp
+/// @brief   The implementation of the resident mesh service. (sparse version)
+///
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <mesh_service.hpp>
+#include <harmonic_mapper.hpp>
+#include <factor_cache.hpp>
+#include <workspace.hpp>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+static_assert(sizeof(int) == 4, "The faces are sent as 32-bit integers.");
+
+static const char *kErrorName[] = {"io", "format", "numeric", "unavailable", "internal"};
+
+// A cached mesh; the mapper holds the Laplacian once ready
+struct MeshService::Entry {
+  string         key;
+  mutex          lock;            // one request at a time
+  bool           ready = false;   // whether the mapper is past mapBoundary
+  HarmonicMapper mapper;
+  FactorMemory   factor;          // the factorization of Lii of the direct solvers
+  FactorCache    cache;           // the key of factor
+  vector<int>    order;           // the index of each vertex in the mapper; see HarmonicMapper::vertexOrder
+  size_t         bytes = 0;       // the memory accounted for; guarded by the lock of the service
+};
+
+// The key of the mesh of a request; the path, size, and modification time of a file, or the hash of an inline mesh
+static string meshKey( const MapRequest &request ) {
+  char key[PATH_MAX+128];
+  if ( request.input != nullptr ) {
+    char path[PATH_MAX];
+    struct stat st;
+    if ( realpath(request.input, path) == nullptr || stat(path, &st) != 0 ) {
+      throw HarmonicError(ErrorCode::IO, string("Unable to open file \"") + request.input + "\"!");
+    }
+    snprintf(key, sizeof(key), "%d:file:%s:%lld:%lld.%09ld", int(request.method), path,
+             static_cast<long long>(st.st_size), static_cast<long long>(st.st_mtim.tv_sec), st.st_mtim.tv_nsec);
+  } else {
+    uint64_t h = hashBytes(kHashBasis, request.V, sizeof(double)*3*request.nv);
+    h = hashBytes(h, request.F, sizeof(int)*3*request.nf);
+    snprintf(key, sizeof(key), "%d:inline:%d:%d:%016llx", int(request.method), request.nv, request.nf,
+             static_cast<unsigned long long>(h));
+  }
+  return key;
+}
+
+MeshService::MeshService(
+    const size_t budget
+) : budget_(budget), bytes_(0), hits_(0), misses_(0) {}
+
+MeshService::~MeshService() {}
+
+int MeshService::size() const {
+  lock_guard<mutex> guard(lock_);
+  return static_cast<int>(lru_.size());
+}
+
+size_t MeshService::bytes() const {
+  lock_guard<mutex> guard(lock_);
+  return bytes_;
+}
+
+shared_ptr<MeshService::Entry> MeshService::acquire( const string &key, bool *found ) {
+  lock_guard<mutex> guard(lock_);
+  auto it = index_.find(key);
+  *found = (it != index_.end());
+  if ( *found ) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return lru_.front();
+  }
+  lru_.push_front(make_shared<Entry>());
+  lru_.front()->key = key;
+  index_[key] = lru_.begin();
+  return lru_.front();
+}
+
+void MeshService::account( const shared_ptr<Entry> &entry ) {
+  const size_t bytes = entry->mapper.capacity() + entry->factor.store.capacity() + sizeof(int)*entry->order.capacity();
+  lock_guard<mutex> guard(lock_);
+  auto it = index_.find(entry->key);
+  if ( it == index_.end() || *it->second != entry ) {
+    return;
+  }
+  bytes_ = bytes_ - entry->bytes + bytes;
+  entry->bytes = bytes;
+  while ( bytes_ > budget_ && !lru_.empty() ) {
+    bytes_ -= lru_.back()->bytes;
+    index_.erase(lru_.back()->key);
+    lru_.pop_back();
+  }
+}
+
+void MeshService::discard( const shared_ptr<Entry> &entry ) {
+  lock_guard<mutex> guard(lock_);
+  auto it = index_.find(entry->key);
+  if ( it != index_.end() && *it->second == entry ) {
+    bytes_ -= entry->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+}
+
+void MeshService::map(
+    const MapRequest    &request,
+    std::vector<double> &U,
+    MapReply            *reply
+) {
+  const auto start = chrono::steady_clock::now();
+  if ( request.input == nullptr ) {
+    if ( request.nv <= 0 || request.nf <= 0 ) {
+      throw HarmonicError(ErrorCode::FORMAT, "The mesh has no vertex or no face.");
+    }
+    for ( long i = 0; i < 3L*request.nf; ++i ) {
+      if ( request.F[i] < 1 || request.F[i] > request.nv ) {
+        throw HarmonicError(ErrorCode::FORMAT, "The face " + to_string(i % request.nf + 1) +
+                            " refers to a vertex out of range.");
+      }
+    }
+  }
+
+  bool found;
+  shared_ptr<Entry> entry = acquire(meshKey(request), &found);
+  (found ? hits_ : misses_)++;
+  lock_guard<mutex> guard(entry->lock);
+  HarmonicMapper &mapper = entry->mapper;
+
+  // Map the mesh up to the solve, unless cached
+  const bool warm = entry->ready;
+  if ( !warm ) {
+    try {
+      if ( request.input != nullptr ) {
+        mapper.load(request.input);
+      } else {
+        vector<double> C(3L*request.nv, 0.0);
+        mapper.setMesh(request.nv, request.nf, request.V, C.data(), request.F);
+      }
+      mapper.verifyBoundary();
+      mapper.reorderVertex();
+      mapper.constructLaplacian(request.method);
+      mapper.mapBoundary();
+      entry->order.resize(mapper.nv());
+      mapper.vertexOrder(entry->order.data());
+      entry->cache.path[0]  = '\0';
+      entry->cache.topology = 0;
+      entry->cache.memory   = &entry->factor;
+      entry->ready = true;
+    } catch ( ... ) {
+      discard(entry);
+      throw;
+    }
+  }
+
+  // Solve; the direct solvers keep their factorization in the entry, and the scratch stays with the thread
+  static thread_local Workspace scratch;
+  SolveOptions options = request.options;
+  options.cache   = &entry->cache;
+  options.monitor = nullptr;
+  options.work    = &scratch;
+  const bool factored = (entry->factor.factor != nullptr && options.precision == Precision::DOUBLE &&
+                         strcmp(sparseBackendName(options), "cholesky") == 0);
+  SolveInfo info;
+  mapper.solve(options, nullptr, &info);
+
+  // Write the mapped mesh, or gather the solution in the vertex order of the mesh
+  const int nv = mapper.nv();
+  U.clear();
+  if ( request.output != nullptr ) {
+    mapper.write(request.output);
+  } else {
+    const double *Um = mapper.U();
+    U.resize(2L*nv);
+    for ( int k = 0; k < 2; ++k ) {
+      for ( int i = 0; i < nv; ++i ) {
+        U[k*nv+i] = Um[k*nv+entry->order[i]];
+      }
+    }
+  }
+  account(entry);
+
+  reply->nv       = nv;
+  reply->info     = info;
+  reply->warm     = warm;
+  reply->factored = factored;
+  reply->time     = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static volatile sig_atomic_t g_stop = 0;  // set by SIGINT and SIGTERM
+
+static void onSignal( int ) {
+  g_stop = 1;
+}
+
+// Read exactly size bytes; false at the end of the stream or on error
+static bool readFull( const int fd, void *data, size_t size ) {
+  char *p = static_cast<char*>(data);
+  while ( size > 0 ) {
+    const ssize_t n = read(fd, p, size);
+    if ( n < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( n <= 0 ) {
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Write exactly size bytes; false on error (e.g. the peer has gone)
+static bool writeFull( const int fd, const void *data, size_t size ) {
+  const char *p = static_cast<const char*>(data);
+  while ( size > 0 ) {
+    const ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if ( n < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( n <= 0 ) {
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Read a line without the newline; false at the end of the stream, or if longer than a path and the options
+static bool readLine( const int fd, string &line ) {
+  line.clear();
+  char c;
+  while ( readFull(fd, &c, 1) ) {
+    if ( c == '\n' ) {
+      return true;
+    }
+    if ( line.size() > PATH_MAX+1024 ) {
+      return false;
+    }
+    line += c;
+  }
+  return false;
+}
+
+// Read an integer field in [lo, hi)
+static int parseInt( const string &key, const string &value, const int lo, const int hi ) {
+  char *end;
+  const long v = strtol(value.c_str(), &end, 10);
+  if ( value.empty() || *end != '\0' || v < lo || v >= hi ) {
+    throw HarmonicError(ErrorCode::FORMAT, "The field " + key + "=" + value + " is out of range.");
+  }
+  return int(v);
+}
+
+// Parse a map request line; the path (if any) runs to the end of the line, and output is set if an output path follows
+static void parseRequest( const string &line, MapRequest &request, string &solver, string &path, bool &output ) {
+  const string fields = line.substr(3);
+  const size_t file = fields.find(" file=");
+  if ( file != string::npos ) {
+    path = fields.substr(file+6);
+  }
+  istringstream in(fields.substr(0, file));
+  string token;
+  while ( in >> token ) {
+    const size_t eq = token.find('=');
+    const string key = token.substr(0, eq), value = (eq == string::npos) ? "" : token.substr(eq+1);
+    if ( key == "method" ) {
+      request.method = static_cast<Method>(parseInt(key, value, 0, int(Method::COUNT)));
+    } else if ( key == "solver" ) {
+      solver = value;
+    } else if ( key == "precond" ) {
+      request.options.precond = static_cast<Precond>(parseInt(key, value, 0, int(Precond::COUNT)));
+    } else if ( key == "tol" ) {
+      request.options.tol = atof(value.c_str());
+      if ( !(request.options.tol > 0.0) ) {
+        throw HarmonicError(ErrorCode::FORMAT, "The field tol=" + value + " is out of range.");
+      }
+    } else if ( key == "precision" ) {
+      request.options.precision = static_cast<Precision>(parseInt(key, value, 0, int(Precision::COUNT)));
+    } else if ( key == "krylov" ) {
+      request.options.krylov = static_cast<Krylov>(parseInt(key, value, 0, int(Krylov::COUNT)));
+    } else if ( key == "nv" ) {
+      request.nv = parseInt(key, value, 1, INT_MAX/3);
+    } else if ( key == "nf" ) {
+      request.nf = parseInt(key, value, 1, INT_MAX/3);
+    } else if ( key == "output" ) {
+      output = (parseInt(key, value, 0, 2) == 1);
+    } else {
+      throw HarmonicError(ErrorCode::FORMAT, "Unknown field " + token + ".");
+    }
+  }
+  if ( path.empty() && (request.nv == 0 || request.nf == 0) ) {
+    throw HarmonicError(ErrorCode::FORMAT, "The request has neither a file nor the sizes of a mesh.");
+  }
+}
+
+static mutex g_log;  // serializes the log lines of the connections
+
+// Serve the requests of a connection until it closes; a malformed request closes it, since its payload is unknown
+static void serveConnection( const int fd, MeshService &service ) {
+  string line;
+  bool keep = true;
+  while ( keep && readLine(fd, line) ) {
+    ostringstream head;
+    vector<double> U;
+    MapReply reply;
+    string solver, path, output, what = line;
+    try {
+      if ( line == "stats" ) {
+        head << "ok meshes=" << service.size() << " bytes=" << service.bytes() << " budget=" << service.budget()
+             << " hits=" << service.hits() << " misses=" << service.misses();
+      } else if ( line.compare(0, 4, "map ") == 0 ) {
+        MapRequest request;
+        bool write = false;
+        keep = false;
+        parseRequest(line, request, solver, path, write);
+        if ( write && !readLine(fd, output) ) {
+          break;
+        }
+
+        // The payload of an inline mesh must fit in the budget; it is not read otherwise
+        const double payload = (sizeof(double)*3.0)*request.nv + (sizeof(int)*3.0)*request.nf;
+        if ( path.empty() && payload > double(service.budget()) ) {
+          throw HarmonicError(ErrorCode::UNAVAILABLE, "The mesh (" + to_string(long(payload) >> 20) +
+                              " MiB) exceeds the budget of the service (" + to_string(service.budget() >> 20) + " MiB).");
+        }
+        vector<double> V;
+        vector<int> F;
+        if ( path.empty() ) {
+          V.resize(3L*request.nv);
+          F.resize(3L*request.nf);
+          if ( !readFull(fd, V.data(), sizeof(double)*V.size()) || !readFull(fd, F.data(), sizeof(int)*F.size()) ) {
+            break;
+          }
+          request.V = V.data();
+          request.F = F.data();
+        } else {
+          request.input = path.c_str();
+        }
+        keep = true;
+        request.output = write ? output.c_str() : nullptr;
+        request.options.solver = solver.empty() ? nullptr : solver.c_str();
+        what = path.empty() ? "inline mesh" : path;
+        service.map(request, U, &reply);
+        head << "ok nv=" << reply.nv << " iter=" << reply.info.iter << " res=" << setprecision(17) << reply.info.res
+             << " mesh=" << (reply.warm ? "warm" : "cold") << " factor=" << (reply.factored ? "warm" : "cold")
+             << " time=" << setprecision(6) << reply.time;
+      } else {
+        keep = false;
+        throw HarmonicError(ErrorCode::FORMAT, "Unknown request.");
+      }
+    } catch ( const HarmonicError &e ) {
+      string message = e.what();
+      replace(message.begin(), message.end(), '\n', ' ');
+      head.str("");
+      head << "error " << kErrorName[int(e.code())] << " " << message;
+      U.clear();
+    } catch ( const exception &e ) {
+      head.str("");
+      head << "error internal " << e.what();
+      U.clear();
+    }
+
+    {
+      lock_guard<mutex> guard(g_log);
+      cout << what << ": " << head.str() << endl;
+    }
+    head << '\n';
+    const string text = head.str();
+    if ( !writeFull(fd, text.data(), text.size()) || !writeFull(fd, U.data(), sizeof(double)*U.size()) ) {
+      break;
+    }
+  }
+}
+
+void serveMeshes(
+    const char  *path,
+    MeshService &service
+) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if ( strlen(path) >= sizeof(addr.sun_path) ) {
+    throw HarmonicError(ErrorCode::IO, string("The socket path \"") + path + "\" is too long!");
+  }
+  strcpy(addr.sun_path, path);
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if ( fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 64) != 0 ) {
+    if ( fd >= 0 ) {
+      close(fd);
+    }
+    throw HarmonicError(ErrorCode::IO, string("Unable to listen on socket \"") + path + "\"!");
+  }
+
+  // Stop on SIGINT and SIGTERM; poll returns early on them (no SA_RESTART)
+  struct sigaction action, old_int, old_term;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = onSignal;
+  sigemptyset(&action.sa_mask);
+  g_stop = 0;
+  sigaction(SIGINT,  &action, &old_int);
+  sigaction(SIGTERM, &action, &old_term);
+
+  cout << "Serving on " << path << " (budget " << (service.budget() >> 20) << " MiB)" << endl;
+
+  // The connections; each is served by a thread, and joined once done
+  struct Connection {
+    thread                   worker;
+    shared_ptr<atomic<bool>> done;
+  };
+  list<Connection> connections;
+  unordered_set<int> open_fds;
+  mutex fds_lock;
+  auto reap = [&]( const bool all ) {
+    for ( auto it = connections.begin(); it != connections.end(); ) {
+      if ( all || it->done->load() ) {
+        it->worker.join();
+        it = connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  };
+
+  while ( !g_stop ) {
+    pollfd pfd = {fd, POLLIN, 0};
+    const int ready = poll(&pfd, 1, 200);
+    reap(false);
+    if ( ready <= 0 ) {
+      continue;
+    }
+    const int client = accept(fd, nullptr, nullptr);
+    if ( client < 0 ) {
+      continue;
+    }
+    {
+      lock_guard<mutex> guard(fds_lock);
+      open_fds.insert(client);
+    }
+    shared_ptr<atomic<bool>> done = make_shared<atomic<bool>>(false);
+    connections.push_back({thread([=, &service, &open_fds, &fds_lock]() {
+      serveConnection(client, service);
+      {
+        lock_guard<mutex> guard(fds_lock);
+        open_fds.erase(client);
+      }
+      close(client);
+      done->store(true);
+    }), done});
+  }
+
+  // Close the listening socket, end the open connections, and wait for the requests in flight
+  close(fd);
+  unlink(path);
+  {
+    lock_guard<mutex> guard(fds_lock);
+    for ( const int client : open_fds ) {
+      shutdown(client, SHUT_RDWR);
+    }
+  }
+  reap(true);
+  sigaction(SIGINT,  &old_int,  nullptr);
+  sigaction(SIGTERM, &old_term, nullptr);
+
+  cout << "Stopped; " << service.hits() << " warm and " << service.misses() << " cold requests, "
+       << service.size() << " meshes (" << service.bytes() / 1048576.0 << " MiB) cached" << endl;
+}
+
+void requestMap(
+    const char          *path,
+    const MapRequest    &request,
+    std::vector<double> &U,
+    MapReply            *reply
+) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path)-1);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ( fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ) {
+    if ( fd >= 0 ) {
+      close(fd);
+    }
+    throw HarmonicError(ErrorCode::IO, string("Unable to connect to the service on \"") + path + "\"!");
+  }
+
+  // Send the request
+  const SolveOptions &options = request.options;
+  ostringstream head;
+  head << "map method=" << int(request.method) << " precond=" << int(options.precond) << " tol=" << setprecision(17)
+       << options.tol << " precision=" << int(options.precision) << " krylov=" << int(options.krylov);
+  if ( options.solver != nullptr ) {
+    head << " solver=" << options.solver;
+  }
+  if ( request.output != nullptr ) {
+    head << " output=1";
+  }
+  if ( request.input != nullptr ) {
+    head << " file=" << request.input;
+  } else {
+    head << " nv=" << request.nv << " nf=" << request.nf;
+  }
+  head << '\n';
+  if ( request.output != nullptr ) {
+    head << request.output << '\n';
+  }
+  const string text = head.str();
+  bool good = writeFull(fd, text.data(), text.size());
+  if ( good && request.input == nullptr ) {
+    good = writeFull(fd, request.V, sizeof(double)*3*request.nv) && writeFull(fd, request.F, sizeof(int)*3*request.nf);
+  }
+
+  // Receive the reply
+  string line;
+  good = good && readLine(fd, line);
+  if ( good && line.compare(0, 6, "error ") == 0 ) {
+    close(fd);
+    const size_t space = line.find(' ', 6);
+    const string name = line.substr(6, space-6), message = (space == string::npos) ? "" : line.substr(space+1);
+    int code = int(ErrorCode::INTERNAL);
+    for ( int k = 0; k < int(ErrorCode::COUNT); ++k ) {
+      code = (name == kErrorName[k]) ? k : code;
+    }
+    throw HarmonicError(static_cast<ErrorCode>(code), message);
+  }
+  memset(reply, 0, sizeof(MapReply));
+  if ( good ) {
+    char mesh[8] = "", factor[8] = "";
+    good = sscanf(line.c_str(), "ok nv=%d iter=%d res=%lf mesh=%7s factor=%7s time=%lf", &reply->nv, &reply->info.iter,
+                  &reply->info.res, mesh, factor, &reply->time) == 6 && reply->nv > 0;
+    reply->warm     = (strcmp(mesh, "warm") == 0);
+    reply->factored = (strcmp(factor, "warm") == 0);
+  }
+  U.clear();
+  if ( good && request.output == nullptr ) {
+    U.resize(2L*reply->nv);
+    good = readFull(fd, U.data(), sizeof(double)*U.size());
+  }
+  close(fd);
+  if ( !good ) {
+    throw HarmonicError(ErrorCode::IO, string("The service on \"") + path + "\" did not reply.");
+  }
+}
@@ -0,0 +1,632 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    multigrid_sparse.cpp
+/// @brief   The implementation of geometric multigrid on a mesh decimation hierarchy. (sparse version)
+///
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include <multigrid.hpp>
+#include <band.hpp>
+#include <iterative.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+static const int kCoarseSize = 400;  // stop coarsening below this number of interior vertices
+static const int kMaxLevel   = 16;   // the maximum number of levels
+static const int kMaxPass    = 8;    // the maximum number of collapse passes per level
+static const int kDenseSize  = 2048; // factor the coarsest level in band storage above this number of interior vertices
+
+static double dot3( const double *x, const double *y ) {
+  return x[0]*y[0] + x[1]*y[1] + x[2]*y[2];
+}
+
+static void cross3( const double *x, const double *y, double *z ) {
+  z[0] = x[1]*y[2] - x[2]*y[1];
+  z[1] = x[2]*y[0] - x[0]*y[2];
+  z[2] = x[0]*y[1] - x[1]*y[0];
+}
+
+static void point3( const int nv, const double *V, const int i, double *p ) {
+  p[0] = V[i];
+  p[1] = V[nv+i];
+  p[2] = V[2*nv+i];
+}
+
+static void normal3( const double *a, const double *b, const double *c, double *n ) {
+  double ab[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+  double ac[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+  cross3(ab, ac, n);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Barycentric coordinates of the point on triangle (a, b, c) closest to p.
+//
+static void closestBarycentric( const double *p, const double *a, const double *b, const double *c, double *w ) {
+  double ab[3], ac[3], ap[3], bp[3], cp[3];
+  for ( int k = 0; k < 3; ++k ) {
+    ab[k] = b[k]-a[k]; ac[k] = c[k]-a[k];
+    ap[k] = p[k]-a[k]; bp[k] = p[k]-b[k]; cp[k] = p[k]-c[k];
+  }
+  double d1 = dot3(ab, ap), d2 = dot3(ac, ap);
+  double d3 = dot3(ab, bp), d4 = dot3(ac, bp);
+  double d5 = dot3(ab, cp), d6 = dot3(ac, cp);
+  double va = d3*d6 - d5*d4, vb = d5*d2 - d1*d6, vc = d1*d4 - d3*d2;
+
+  if ( d1 <= 0 && d2 <= 0 ) {
+    w[0] = 1; w[1] = 0; w[2] = 0;
+  } else if ( d3 >= 0 && d4 <= d3 ) {
+    w[0] = 0; w[1] = 1; w[2] = 0;
+  } else if ( d6 >= 0 && d5 <= d6 ) {
+    w[0] = 0; w[1] = 0; w[2] = 1;
+  } else if ( vc <= 0 && d1 >= 0 && d3 <= 0 ) {
+    double t = d1 / (d1-d3);
+    w[0] = 1-t; w[1] = t; w[2] = 0;
+  } else if ( vb <= 0 && d2 >= 0 && d6 <= 0 ) {
+    double t = d2 / (d2-d6);
+    w[0] = 1-t; w[1] = 0; w[2] = t;
+  } else if ( va <= 0 && d4-d3 >= 0 && d5-d6 >= 0 ) {
+    double t = (d4-d3) / ((d4-d3)+(d5-d6));
+    w[0] = 0; w[1] = 1-t; w[2] = t;
+  } else {
+    double s = 1.0 / (va+vb+vc);
+    w[1] = vb*s; w[2] = vc*s; w[0] = 1-w[1]-w[2];
+  }
+
+  if ( !std::isfinite(w[0]) || !std::isfinite(w[1]) || !std::isfinite(w[2]) ) {
+    w[0] = 1; w[1] = 0; w[2] = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decimate the mesh by collapsing interior edges, and build the barycentric prolongation of the interior vertices.
+// Returns the number of removed vertices.
+//
+static int decimateMesh(
+    const int nv,
+    const int nb,
+    const int nf,
+    const double *V,
+    const int *F,
+    int *ptr_nvc,
+    int *ptr_nfc,
+    double **ptr_Vc,
+    int **ptr_Fc,
+    double **ptr_P_val,
+    int **ptr_P_row,
+    int **ptr_P_col
+) {
+  const int ni = nv-nb;
+
+  vector<int> face(3*nf);
+  for ( int i = 0; i < nf; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      face[3*i+k] = F[k*nf+i]-1;
+    }
+  }
+
+  vector<char> alive(nf, 1), removed(nv, 0);
+  vector<int> target(nv, -1);
+  int nremove = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Collapse edges. Each pass locks the neighborhood of every collapse so that the collapses within a pass are independent.
+  for ( int pass = 0; pass < kMaxPass && nremove < ni/2; ++pass ) {
+    vector<vector<int>> vf(nv), adj(nv);
+    for ( int i = 0; i < nf; ++i ) {
+      if ( !alive[i] ) continue;
+      for ( int k = 0; k < 3; ++k ) {
+        int a = face[3*i+k], b = face[3*i+(k+1)%3], c = face[3*i+(k+2)%3];
+        vf[a].push_back(i);
+        adj[a].push_back(b);
+        adj[a].push_back(c);
+      }
+    }
+    for ( int i = 0; i < nv; ++i ) {
+      sort(adj[i].begin(), adj[i].end());
+      adj[i].erase(unique(adj[i].begin(), adj[i].end()), adj[i].end());
+    }
+
+    vector<char> locked(nv, 0);
+    int npass = 0;
+    for ( int u = nb; u < nv && nremove < ni/2; ++u ) {
+      if ( removed[u] || locked[u] ) continue;
+
+      double pu[3], pv[3];
+      point3(nv, V, u, pu);
+
+      // Candidates sorted by edge length
+      vector<pair<double, int>> cand;
+      for ( int v : adj[u] ) {
+        if ( v < nb || locked[v] ) continue;
+        point3(nv, V, v, pv);
+        double d[3] = {pv[0]-pu[0], pv[1]-pu[1], pv[2]-pu[2]};
+        cand.push_back(make_pair(dot3(d, d), v));
+      }
+      sort(cand.begin(), cand.end());
+
+      int vsel = -1;
+      for ( auto &it : cand ) {
+        int v = it.second;
+        point3(nv, V, v, pv);
+
+        // Link condition: u and v share exactly two neighbors, which keep a valid valence
+        vector<int> common;
+        set_intersection(adj[u].begin(), adj[u].end(), adj[v].begin(), adj[v].end(), back_inserter(common));
+        if ( common.size() != 2 ) continue;
+        bool valid = true;
+        for ( int w : common ) {
+          if ( adj[w].size() <= (w < nb ? 2u : 3u) ) valid = false;
+        }
+
+        // No face around u may flip or degenerate
+        for ( int f : vf[u] ) {
+          if ( !valid ) break;
+          int a = face[3*f], b = face[3*f+1], c = face[3*f+2];
+          if ( a == v || b == v || c == v ) continue;
+          double p[3][3], q[3][3], no[3], nn[3];
+          point3(nv, V, a, p[0]); point3(nv, V, b, p[1]); point3(nv, V, c, p[2]);
+          point3(nv, V, a == u ? v : a, q[0]); point3(nv, V, b == u ? v : b, q[1]); point3(nv, V, c == u ? v : c, q[2]);
+          normal3(p[0], p[1], p[2], no);
+          normal3(q[0], q[1], q[2], nn);
+          double nrmo = sqrt(dot3(no, no)), nrmn = sqrt(dot3(nn, nn));
+          if ( nrmn <= 1e-12 * nrmo || dot3(no, nn) <= 0.2 * nrmo * nrmn ) valid = false;
+        }
+
+        if ( valid ) {
+          vsel = v;
+          break;
+        }
+      }
+      if ( vsel < 0 ) continue;
+
+      // Collapse u into v
+      for ( int f : vf[u] ) {
+        int *fc = &face[3*f];
+        if ( fc[0] == vsel || fc[1] == vsel || fc[2] == vsel ) {
+          alive[f] = 0;
+        } else {
+          for ( int k = 0; k < 3; ++k ) {
+            if ( fc[k] == u ) fc[k] = vsel;
+          }
+        }
+      }
+      removed[u] = 1;
+      target[u] = vsel;
+      locked[u] = locked[vsel] = 1;
+      for ( int w : adj[u] ) {
+        locked[w] = 1;
+      }
+      ++nremove;
+      ++npass;
+    }
+
+    if ( npass == 0 ) break;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Build the coarse mesh. The survivors keep their order, hence the boundary vertices stay first.
+  vector<int> idx(nv, -1);
+  int &nvc = *ptr_nvc, &nfc = *ptr_nfc;
+  nvc = 0;
+  for ( int i = 0; i < nv; ++i ) {
+    if ( !removed[i] ) idx[i] = nvc++;
+  }
+  vector<int> cface;
+  for ( int i = 0; i < nf; ++i ) {
+    if ( !alive[i] ) continue;
+    for ( int k = 0; k < 3; ++k ) {
+      cface.push_back(idx[face[3*i+k]]);
+    }
+  }
+  nfc = cface.size() / 3;
+
+  *ptr_Vc = new double[3*nvc];
+  *ptr_Fc = new int[3*nfc];
+  double *Vc = *ptr_Vc;
+  int *Fc = *ptr_Fc;
+  for ( int i = 0; i < nv; ++i ) {
+    if ( removed[i] ) continue;
+    for ( int k = 0; k < 3; ++k ) {
+      Vc[k*nvc+idx[i]] = V[k*nv+i];
+    }
+  }
+  for ( int i = 0; i < nfc; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      Fc[k*nfc+i] = cface[3*i+k]+1;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  // Build the prolongation. A removed vertex is interpolated on the closest coarse face near the vertex it collapsed into.
+  vector<vector<int>> cvf(nvc);
+  for ( int i = 0; i < nfc; ++i ) {
+    for ( int k = 0; k < 3; ++k ) {
+      cvf[cface[3*i+k]].push_back(i);
+    }
+  }
+
+  *ptr_P_row = new int[ni+1];
+  int *P_row = *ptr_P_row;
+  vector<int> pcol;
+  vector<double> pval;
+  P_row[0] = 0;
+  for ( int i = nb; i < nv; ++i ) {
+    if ( !removed[i] ) {
+      pcol.push_back(idx[i]-nb);
+      pval.push_back(1.0);
+    } else {
+      int root = target[i];
+      while ( removed[root] ) {
+        root = target[root];
+      }
+
+      vector<int> cands;
+      for ( int f : cvf[idx[root]] ) {
+        for ( int k = 0; k < 3; ++k ) {
+          cands.insert(cands.end(), cvf[cface[3*f+k]].begin(), cvf[cface[3*f+k]].end());
+        }
+      }
+      sort(cands.begin(), cands.end());
+      cands.erase(unique(cands.begin(), cands.end()), cands.end());
+
+      double p[3], a[3], b[3], c[3], w[3], wbest[3] = {1, 0, 0};
+      int fbest = -1;
+      double dbest = INFINITY;
+      point3(nv, V, i, p);
+      for ( int f : cands ) {
+        point3(nvc, Vc, cface[3*f],   a);
+        point3(nvc, Vc, cface[3*f+1], b);
+        point3(nvc, Vc, cface[3*f+2], c);
+        closestBarycentric(p, a, b, c, w);
+        double d[3];
+        for ( int k = 0; k < 3; ++k ) {
+          d[k] = p[k] - (w[0]*a[k] + w[1]*b[k] + w[2]*c[k]);
+        }
+        if ( dot3(d, d) < dbest ) {
+          dbest = dot3(d, d);
+          fbest = f;
+          copy(w, w+3, wbest);
+        }
+      }
+
+      if ( fbest < 0 ) {
+        if ( idx[root] >= nb ) {
+          pcol.push_back(idx[root]-nb);
+          pval.push_back(1.0);
+        }
+      } else {
+        for ( int k = 0; k < 3; ++k ) {
+          int j = cface[3*fbest+k];
+          if ( j >= nb && wbest[k] > 0 ) {
+            pcol.push_back(j-nb);
+            pval.push_back(wbest[k]);
+          }
+        }
+      }
+    }
+    P_row[i-nb+1] = pcol.size();
+  }
+  *ptr_P_val = new double[pval.size()];
+  *ptr_P_col = new int[pcol.size()];
+  copy(pval.begin(), pval.end(), *ptr_P_val);
+  copy(pcol.begin(), pcol.end(), *ptr_P_col);
+
+  return nremove;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Setup the diagonal positions and the workspace of a level.
+//
+static void setupLevel( MultigridLevel &lv ) {
+  lv.A_diag = new int[lv.ni];
+  for ( int i = 0; i < lv.ni; ++i ) {
+    lv.A_diag[i] = -1;
+    for ( int j = lv.A_row[i]; j < lv.A_row[i+1]; ++j ) {
+      if ( lv.A_col[j] == i ) lv.A_diag[i] = j;
+    }
+  }
+  lv.P_val = nullptr;
+  lv.P_row = nullptr;
+  lv.P_col = nullptr;
+  lv.b = new double[lv.ni];
+  lv.x = new double[lv.ni];
+  lv.r = new double[lv.ni];
+}
+
+void constructMultigrid(
+    const Method method,
+    const int nv,
+    const int nb,
+    const int nf,
+    const double *V,
+    const int *F,
+    const double *Lii_val,
+    const int *Lii_row,
+    const int *Lii_col,
+    Multigrid *mg
+) {
+  vector<MultigridLevel> levels(1);
+  levels[0].nv = nv;
+  levels[0].ni = nv-nb;
+  levels[0].nf = nf;
+  levels[0].A_val = Lii_val;
+  levels[0].A_row = Lii_row;
+  levels[0].A_col = Lii_col;
+  setupLevel(levels[0]);
+
+  const double *cV = V;
+  const int *cF = F;
+  while ( levels.back().ni > kCoarseSize && int(levels.size()) < kMaxLevel ) {
+    MultigridLevel &fine = levels.back();
+    int nvc, nfc, *Fc, *P_row, *P_col;
+    double *Vc, *P_val;
+    int nremove = decimateMesh(fine.nv, nb, fine.nf, cV, cF, &nvc, &nfc, &Vc, &Fc, &P_val, &P_row, &P_col);
+
+    // Stop if the decimation stalls
+    if ( nremove < fine.ni / 10 ) {
+      delete[] Vc;
+      delete[] Fc;
+      delete[] P_val;
+      delete[] P_row;
+      delete[] P_col;
+      break;
+    }
+
+    // Rebuild the Laplacian on the coarse mesh
+    MultigridLevel coarse;
+    double *A_val, *B_val;
+    int *A_row, *A_col, *B_row, *B_col;
+    constructLaplacianSparse(method, nvc, nb, nfc, Vc, Fc, &A_val, &A_row, &A_col, &B_val, &B_row, &B_col);
+    delete[] B_val;
+    delete[] B_row;
+    delete[] B_col;
+    coarse.nv = nvc;
+    coarse.ni = nvc-nb;
+    coarse.nf = nfc;
+    coarse.A_val = A_val;
+    coarse.A_row = A_row;
+    coarse.A_col = A_col;
+    setupLevel(coarse);
+
+    fine.P_val = P_val;
+    fine.P_row = P_row;
+    fine.P_col = P_col;
+    levels.push_back(coarse);
+
+    if ( cV != V ) {
+      delete[] cV;
+      delete[] cF;
+    }
+    cV = Vc;
+    cF = Fc;
+  }
+  if ( cV != V ) {
+    delete[] cV;
+    delete[] cF;
+  }
+
+  mg->nlevel = levels.size();
+  mg->level = new MultigridLevel[mg->nlevel];
+  copy(levels.begin(), levels.end(), mg->level);
+
+  // Factorize the coarsest level; in band storage if the decimation stalled early
+  const MultigridLevel &lv = levels.back();
+  const int n = lv.ni;
+  mg->coarse_bw   = -1;
+  mg->coarse_perm = nullptr;
+  if ( n > kDenseSize ) {
+    int *perm = new int[n], *inv = new int[n], bw;
+    reorderBandSparse(n, lv.A_row, lv.A_col, perm, &bw);
+    for ( int i = 0; i < n; ++i ) {
+      inv[perm[i]] = i;
+    }
+    const long ld = bw+1;
+    double *B = new double[ld*n];
+    fill(B, B+ld*n, 0.0);
+    for ( int i = 0; i < n; ++i ) {
+      for ( int j = lv.A_row[i]; j < lv.A_row[i+1]; ++j ) {
+        const int pi = inv[i], pj = inv[lv.A_col[j]];
+        if ( pi >= pj ) {
+          B[(pi-pj) + pj*ld] = lv.A_val[j];
+        }
+      }
+    }
+    delete[] inv;
+    mg->coarse      = B;
+    mg->coarse_bw   = bw;
+    mg->coarse_perm = perm;
+    const int err = factorizeBand(n, bw, B, ld);
+    if ( err != 0 ) {
+      destroyMultigrid(mg);
+      throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization of the coarsest level failed: the leading minor "
+                          "of order " + to_string(err) + " is not positive definite.");
+    }
+    return;
+  }
+  double *G = new double[n*n];
+  fill(G, G+n*n, 0.0);
+  for ( int i = 0; i < n; ++i ) {
+    for ( int j = lv.A_row[i]; j < lv.A_row[i+1]; ++j ) {
+      G[i+lv.A_col[j]*n] = lv.A_val[j];
+    }
+  }
+  for ( int j = 0; j < n; ++j ) {
+    double s = G[j+j*n];
+    for ( int k = 0; k < j; ++k ) {
+      s -= G[j+k*n] * G[j+k*n];
+    }
+    if ( !(s > 0.0) ) {
+      delete[] G;
+      destroyMultigrid(mg);
+      throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization of the coarsest level failed: the leading minor "
+                          "of order " + to_string(j+1) + " is not positive definite.");
+    }
+    G[j+j*n] = sqrt(s);
+    for ( int i = j+1; i < n; ++i ) {
+      double t = G[i+j*n];
+      for ( int k = 0; k < j; ++k ) {
+        t -= G[i+k*n] * G[j+k*n];
+      }
+      G[i+j*n] = t / G[j+j*n];
+    }
+  }
+  mg->coarse = G;
+}
+
+void destroyMultigrid( Multigrid *mg ) {
+  for ( int l = 0; l < mg->nlevel; ++l ) {
+    MultigridLevel &lv = mg->level[l];
+    if ( l > 0 ) {
+      delete[] lv.A_val;
+      delete[] lv.A_row;
+      delete[] lv.A_col;
+    }
+    delete[] lv.A_diag;
+    delete[] lv.P_val;
+    delete[] lv.P_row;
+    delete[] lv.P_col;
+    delete[] lv.b;
+    delete[] lv.x;
+    delete[] lv.r;
+  }
+  delete[] mg->level;
+  delete[] mg->coarse;
+  delete[] mg->coarse_perm;
+  mg->nlevel = 0;
+  mg->level = nullptr;
+  mg->coarse = nullptr;
+  mg->coarse_perm = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// One Gauss-Seidel sweep on x for A * x = b.
+//
+static void sweepGaussSeidel( MultigridLevel &lv, const bool forward ) {
+  SCSC_PROFILE_ZONE("smoothing");
+  for ( int ii = 0; ii < lv.ni; ++ii ) {
+    int i = forward ? ii : lv.ni-1-ii;
+    double s = lv.b[i];
+    for ( int j = lv.A_row[i]; j < lv.A_row[i+1]; ++j ) {
+      if ( j != lv.A_diag[i] ) {
+        s -= lv.A_val[j] * lv.x[lv.A_col[j]];
+      }
+    }
+    lv.x[i] = s / lv.A_val[lv.A_diag[i]];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// One V-cycle on level l; solves A * x = b approximately with zero initial guess.
+// The forward/backward Gauss-Seidel sweeps make the cycle symmetric, so that it can be used within CG.
+//
+static void cycleMultigrid( Multigrid *mg, const int l ) {
+  MultigridLevel &lv = mg->level[l];
+  const int n = lv.ni;
+
+  // Direct solve on the coarsest level
+  if ( l == mg->nlevel-1 ) {
+    SCSC_PROFILE_ZONE("coarse solve");
+    const double *G = mg->coarse;
+    if ( mg->coarse_bw >= 0 ) {
+      const int *p = mg->coarse_perm;
+      for ( int i = 0; i < n; ++i ) {
+        lv.r[i] = lv.b[p[i]];
+      }
+      solveBand(n, mg->coarse_bw, G, mg->coarse_bw+1, lv.r);
+      for ( int i = 0; i < n; ++i ) {
+        lv.x[p[i]] = lv.r[i];
+      }
+      return;
+    }
+    for ( int i = 0; i < n; ++i ) {
+      double s = lv.b[i];
+      for ( int k = 0; k < i; ++k ) {
+        s -= G[i+k*n] * lv.x[k];
+      }
+      lv.x[i] = s / G[i+i*n];
+    }
+    for ( int i = n-1; i >= 0; --i ) {
+      double s = lv.x[i];
+      for ( int k = i+1; k < n; ++k ) {
+        s -= G[k+i*n] * lv.x[k];
+      }
+      lv.x[i] = s / G[i+i*n];
+    }
+    return;
+  }
+
+  MultigridLevel &cv = mg->level[l+1];
+
+  // Pre-smoothing
+  fill(lv.x, lv.x+n, 0.0);
+  sweepGaussSeidel(lv, true);
+
+  // Restriction; b[coarse] := P' * (b - A * x)
+  spmvSparse(n, lv.A_val, lv.A_row, lv.A_col, lv.x, lv.r);
+  fill(cv.b, cv.b+cv.ni, 0.0);
+  for ( int i = 0; i < n; ++i ) {
+    double r = lv.b[i] - lv.r[i];
+    for ( int j = lv.P_row[i]; j < lv.P_row[i+1]; ++j ) {
+      cv.b[lv.P_col[j]] += lv.P_val[j] * r;
+    }
+  }
+
+  // Coarse-grid correction; x += P * x[coarse]
+  cycleMultigrid(mg, l+1);
+  for ( int i = 0; i < n; ++i ) {
+    for ( int j = lv.P_row[i]; j < lv.P_row[i+1]; ++j ) {
+      lv.x[i] += lv.P_val[j] * cv.x[lv.P_col[j]];
+    }
+  }
+
+  // Post-smoothing
+  sweepGaussSeidel(lv, false);
+}
+
+void solveHarmonicMultigrid(
+    const int nv,
+    const int nb,
+    Multigrid *mg,
+    const double *Lib_val,
+    const int *Lib_row,
+    const int *Lib_col,
+    double *U,
+    const double *U0,
+    SolveInfo *info
+) {
+  const int ni = nv-nb;
+  const double tol = 1e-10;
+  MultigridLevel &lv = mg->level[0];
+
+  auto precond = [=]( const double *r, double *z ) {
+    copy(r, r+ni, mg->level[0].b);
+    cycleMultigrid(mg, 0);
+    copy(mg->level[0].x, mg->level[0].x+ni, z);
+  };
+
+  // Solve Lii * Ui = - Lib * Ub
+  SolveInfo stat = {0, 0.0, 0.0, 0, 0, false, 0, 0};
+  double *b = new double[ni];
+  for ( int k = 0; k < 2; ++k ) {
+    const double *Ub = U+k*nv;
+    double       *Ui = U+k*nv+nb;
+    spmvSparse(ni, Lib_val, Lib_row, Lib_col, Ub, b);
+    for ( int i = 0; i < ni; ++i ) {
+      b[i] = -b[i];
+      Ui[i] = (U0 != nullptr) ? U0[k*nv+nb+i] : 0.0;
+    }
+    double res0 = residualSparse(ni, lv.A_val, lv.A_row, lv.A_col, b, Ui), res;
+    int iter = solvePcgSparse(ni, lv.A_val, lv.A_row, lv.A_col, b, Ui, precond, tol, ni+100, nullptr, &res);
+    stat.iter += iter;
+    stat.res0 = max(stat.res0, res0);
+    stat.res = max(stat.res, res);
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+
+  delete[] b;
+}
@@ -0,0 +1,527 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    pcg_sparse.cpp
+/// @brief   The implementation of the preconditioned conjugate gradient method.
+///
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterative.hpp>
+#include <profiler.hpp>
+#include <simd.hpp>
+#include <thread_pool.hpp>
+#include <timer.hpp>
+#include <workspace.hpp>
+using namespace std;
+
+// The minimum number of rows of a chunk in the thread pool
+static const int kGrain = 4096;
+
+void spmvSparse(
+    const int     n,
+    const double *A_val,
+    const int    *A_row,
+    const int    *A_col,
+    const double *x,
+    double       *y
+) {
+  // The matrix once, x and y once
+  const double nnz = A_row[n] - A_row[0];
+  SCSC_PROFILE_WORK(12.0*nnz + 20.0*n + 4.0, 2.0*nnz);
+  parallelFor(0, n, kGrain, [=]( int begin, int end ) {
+    simd().spmv(begin, end, A_val, A_row, A_col, x, y);
+  });
+}
+
+static double dot( const int n, const double *x, const double *y ) {
+  double sum;
+  parallelSum(0, n, kGrain, 1, [=]( int begin, int end, double *partial ) {
+    partial[0] += simd().dot(end-begin, x+begin, y+begin);
+  }, &sum);
+  return sum;
+}
+
+// The monitor of a solver and its timers; nothing is timed without a monitor
+struct Recorder {
+  const Monitor &monitor;
+  double         start;
+  double         time_precond;
+  double         time_spmv;
+};
+
+static void applyPrecond( Recorder &rec, const Preconditioner &precond, const double *r, double *z ) {
+  SCSC_PROFILE_ZONE("precond");
+  if ( !rec.monitor ) {
+    precond(r, z);
+    return;
+  }
+  const double t = getTime();
+  precond(r, z);
+  rec.time_precond += getTime() - t;
+}
+
+static void applySpmv( Recorder &rec, const int n, const double *A_val, const int *A_row, const int *A_col,
+                       const double *x, double *y ) {
+  SCSC_PROFILE_ZONE("spmv");
+  if ( !rec.monitor ) {
+    spmvSparse(n, A_val, A_row, A_col, x, y);
+    return;
+  }
+  const double t = getTime();
+  spmvSparse(n, A_val, A_row, A_col, x, y);
+  rec.time_spmv += getTime() - t;
+}
+
+// Pass a record to the monitor and reset the interval timers; returns false to stop
+static bool record( Recorder &rec, const int iter, const double res ) {
+  if ( !rec.monitor ) {
+    return true;
+  }
+  const IterationInfo info = {0, iter, res, getTime() - rec.start, rec.time_precond, rec.time_spmv};
+  rec.time_precond = rec.time_spmv = 0.0;
+  return rec.monitor(info);
+}
+
+double residualSparse(
+    const int     n,
+    const double *A_val,
+    const int    *A_row,
+    const int    *A_col,
+    const double *b,
+    const double *x,
+    Workspace    *work
+) {
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  double *r = ws.take<double>(n);
+  spmvSparse(n, A_val, A_row, A_col, x, r);
+  for ( int i = 0; i < n; ++i ) {
+    r[i] = b[i] - r[i];
+  }
+  double nrmb = sqrt(dot(n, b, b));
+  double res = sqrt(dot(n, r, r)) / (nrmb == 0.0 ? 1.0 : nrmb);
+  ws.release(top);
+  return res;
+}
+
+int solvePcgSparse(
+    const int             n,
+    const double         *A_val,
+    const int            *A_row,
+    const int            *A_col,
+    const double         *b,
+    double               *x,
+    const Preconditioner &precond,
+    const double          tol,
+    const int             maxit,
+    const Monitor        &monitor,
+    double               *ptr_res,
+    Workspace            *work
+) {
+  SCSC_PROFILE_ZONE("pcg");
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  Recorder rec = {monitor, getTime(), 0.0, 0.0};
+
+  double *r = ws.take<double>(n);
+  double *z = ws.take<double>(n);
+  double *p = ws.take<double>(n);
+  double *q = ws.take<double>(n);
+
+  // r := b - A * x
+  applySpmv(rec, n, A_val, A_row, A_col, x, r);
+  for ( int i = 0; i < n; ++i ) {
+    r[i] = b[i] - r[i];
+  }
+
+  double nrmb = sqrt(dot(n, b, b));
+  if ( nrmb == 0.0 ) {
+    nrmb = 1.0;
+  }
+  double res = sqrt(dot(n, r, r)) / nrmb;
+
+  int iter = 0;
+  if ( record(rec, iter, res) && res > tol ) {
+    applyPrecond(rec, precond, r, z);
+    for ( int i = 0; i < n; ++i ) {
+      p[i] = z[i];
+    }
+    double rz = dot(n, r, z);
+
+    while ( iter < maxit ) {
+      ++iter;
+
+      // alpha := (r' * z) / (p' * A * p)
+      applySpmv(rec, n, A_val, A_row, A_col, p, q);
+      double alpha = rz / dot(n, p, q);
+
+      // x += alpha * p;  r -= alpha * q
+      parallelFor(0, n, kGrain, [=]( int begin, int end ) {
+        simd().axpy(end-begin, alpha, p+begin, x+begin);
+        simd().axpy(end-begin, -alpha, q+begin, r+begin);
+      });
+
+      res = sqrt(dot(n, r, r)) / nrmb;
+      if ( !record(rec, iter, res) || res <= tol ) {
+        break;
+      }
+
+      // p := z + beta * p
+      applyPrecond(rec, precond, r, z);
+      double rz_new = dot(n, r, z);
+      double beta = rz_new / rz;
+      rz = rz_new;
+      parallelFor(0, n, kGrain, [=]( int begin, int end ) {
+        simd().xpby(end-begin, z+begin, beta, p+begin);
+      });
+    }
+  }
+
+  if ( ptr_res != nullptr ) {
+    *ptr_res = res;
+  }
+
+  ws.release(top);
+
+  return iter;
+}
+
+int solvePipelinedPcgSparse(
+    const int             n,
+    const double         *A_val,
+    const int            *A_row,
+    const int            *A_col,
+    const double         *b,
+    double               *x,
+    const Preconditioner &precond,
+    const double          tol,
+    const int             maxit,
+    const Monitor        &monitor,
+    double               *ptr_res,
+    Workspace            *work
+) {
+  SCSC_PROFILE_ZONE("pipelined pcg");
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  Recorder rec = {monitor, getTime(), 0.0, 0.0};
+
+  double *r  = ws.take<double>(n);
+  double *u  = ws.take<double>(n);
+  double *w  = ws.take<double>(n);
+  double *m  = ws.take<double>(n);
+  double *nn = ws.take<double>(n);
+  double *p  = ws.take<double>(n);
+  double *s  = ws.take<double>(n);
+  double *q  = ws.take<double>(n);
+  double *z  = ws.take<double>(n);
+
+  double nrmb = sqrt(dot(n, b, b));
+  if ( nrmb == 0.0 ) {
+    nrmb = 1.0;
+  }
+
+  // r := b - A * x;  u := inv(M) * r;  w := A * u; returns the relative residual
+  double dots[3], gamma, delta;
+  auto restart = [&]() -> double {
+    applySpmv(rec, n, A_val, A_row, A_col, x, r);
+    for ( int i = 0; i < n; ++i ) {
+      r[i] = b[i] - r[i];
+    }
+    applyPrecond(rec, precond, r, u);
+    applySpmv(rec, n, A_val, A_row, A_col, u, w);
+    parallelSum(0, n, kGrain, 3, [=]( int begin, int end, double *partial ) {
+      for ( int i = begin; i < end; ++i ) {
+        partial[0] += r[i] * u[i];
+        partial[1] += w[i] * u[i];
+        partial[2] += r[i] * r[i];
+      }
+    }, dots);
+    gamma = dots[0];
+    delta = dots[1];
+    return sqrt(dots[2]) / nrmb;
+  };
+  double res = restart(), res_true = res;
+
+  int iter = 0, first = 1;
+  double gamma_old = 0.0, alpha_old = 0.0;
+  bool go = record(rec, iter, res), replaced = true;
+  while ( go && iter < maxit ) {
+
+    // The recursive residual drifts from b - A * x; once it meets tol, restart from the true residual unless that
+    // meets tol too, or no longer decreases
+    if ( res <= tol ) {
+      if ( replaced ) {
+        break;
+      }
+      const double res_old = res_true;
+      res = res_true = restart();
+      if ( res <= tol || !(res < res_old) ) {
+        break;
+      }
+      replaced = true;
+      first = iter+1;
+    }
+    ++iter;
+
+    // m := inv(M) * w;  n := A * m (independent of the inner products of the previous sweep)
+    applyPrecond(rec, precond, w, m);
+    applySpmv(rec, n, A_val, A_row, A_col, m, nn);
+
+    const double beta  = (iter > first) ? gamma / gamma_old : 0.0;
+    const double alpha = (iter > first) ? gamma / (delta - beta * gamma / alpha_old) : gamma / delta;
+
+    // Update all vectors and compute the inner products of the next iteration in one sweep
+    parallelSum(0, n, kGrain, 3, [=]( int begin, int end, double *partial ) {
+      for ( int i = begin; i < end; ++i ) {
+        z[i] = nn[i] + beta * z[i];
+        q[i] = m[i]  + beta * q[i];
+        s[i] = w[i]  + beta * s[i];
+        p[i] = u[i]  + beta * p[i];
+        x[i] += alpha * p[i];
+        r[i] -= alpha * s[i];
+        u[i] -= alpha * q[i];
+        w[i] -= alpha * z[i];
+        partial[0] += r[i] * u[i];
+        partial[1] += w[i] * u[i];
+        partial[2] += r[i] * r[i];
+      }
+    }, dots);
+    gamma_old = gamma;
+    alpha_old = alpha;
+    gamma = dots[0];
+    delta = dots[1];
+    res = sqrt(dots[2]) / nrmb;
+    replaced = false;
+    go = record(rec, iter, res);
+  }
+
+  if ( ptr_res != nullptr ) {
+    *ptr_res = residualSparse(n, A_val, A_row, A_col, b, x, &ws);
+  }
+
+  ws.release(top);
+
+  return iter;
+}
+
+// Cholesky factorization of the leading block of a symmetric s by s matrix in place; returns the order of the largest
+// leading block that is numerically positive definite
+static int factorizeSmall( const int s, double *G ) {
+  for ( int j = 0; j < s; ++j ) {
+    double d = G[j+j*s];
+    for ( int k = 0; k < j; ++k ) {
+      d -= G[j+k*s] * G[j+k*s];
+    }
+    if ( !(d > 1e3 * DBL_EPSILON * G[j+j*s]) ) {
+      return j;
+    }
+    G[j+j*s] = sqrt(d);
+    for ( int i = j+1; i < s; ++i ) {
+      double t = G[i+j*s];
+      for ( int k = 0; k < j; ++k ) {
+        t -= G[i+k*s] * G[j+k*s];
+      }
+      G[i+j*s] = t / G[j+j*s];
+    }
+  }
+  return s;
+}
+
+// Solve L * L' * y = y with the leading m by m block of a factor from factorizeSmall
+static void solveSmall( const int s, const int m, const double *L, double *y ) {
+  for ( int j = 0; j < m; ++j ) {
+    y[j] /= L[j+j*s];
+    for ( int i = j+1; i < m; ++i ) {
+      y[i] -= L[i+j*s] * y[j];
+    }
+  }
+  for ( int j = m-1; j >= 0; --j ) {
+    for ( int i = j+1; i < m; ++i ) {
+      y[j] -= L[i+j*s] * y[i];
+    }
+    y[j] /= L[j+j*s];
+  }
+}
+
+int solveSstepPcgSparse(
+    const int             n,
+    const double         *A_val,
+    const int            *A_row,
+    const int            *A_col,
+    const double         *b,
+    double               *x,
+    const Preconditioner &precond,
+    const int             s,
+    const double          tol,
+    const int             maxit,
+    const Monitor        &monitor,
+    double               *ptr_res,
+    Workspace            *work
+) {
+  SCSC_PROFILE_ZONE("s-step pcg");
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+  Recorder rec = {monitor, getTime(), 0.0, 0.0};
+
+  // The basis R and A * R of this step, and the directions P and A * P of the previous step; n by s matrices
+  double *R  = ws.take<double>(long(n)*s);
+  double *AR = ws.take<double>(long(n)*s);
+  double *P  = ws.take<double>(long(n)*s);
+  double *AP = ws.take<double>(long(n)*s);
+  double *r  = ws.take<double>(n);
+  double *t  = ws.take<double>(n);
+
+  // The inner products of a step: R' * A * R, (A * P)' * R, R' * r, and r' * r
+  const int ns = s*s, nsum = 2*ns+s+1;
+  double *sum = ws.take<double>(nsum);
+  double *G = sum, *C = sum+ns, *g = sum+2*ns;
+  double *W = ws.take<double>(ns), *B = ws.take<double>(ns);
+  int mp = 0;
+
+  double nrmb = sqrt(dot(n, b, b));
+  if ( nrmb == 0.0 ) {
+    nrmb = 1.0;
+  }
+
+  // r := b - A * x; returns the relative residual
+  auto residual = [&]() -> double {
+    applySpmv(rec, n, A_val, A_row, A_col, x, r);
+    for ( int i = 0; i < n; ++i ) {
+      r[i] = b[i] - r[i];
+    }
+    return sqrt(dot(n, r, r)) / nrmb;
+  };
+  double res_true = residual();
+  bool replaced = true;
+
+  int iter = 0;
+  while ( true ) {
+    // Chebyshev basis; R_0 = inv(M) * r, R_{j+1} = 2 * (inv(M) * A - I) * R_j - R_{j-1}
+    applyPrecond(rec, precond, r, R);
+    for ( int j = 0; j < s; ++j ) {
+      double *Rj = R+long(j)*n, *ARj = AR+long(j)*n;
+      applySpmv(rec, n, A_val, A_row, A_col, Rj, ARj);
+      if ( j+1 < s ) {
+        double *Rn = Rj+n;
+        applyPrecond(rec, precond, ARj, t);
+        if ( j == 0 ) {
+          for ( int i = 0; i < n; ++i ) {
+            Rn[i] = t[i] - Rj[i];
+          }
+        } else {
+          const double *Rp = Rj-n;
+          for ( int i = 0; i < n; ++i ) {
+            Rn[i] = 2.0 * (t[i] - Rj[i]) - Rp[i];
+          }
+        }
+      }
+    }
+
+    // One reduction for the whole step
+    parallelSum(0, n, kGrain, nsum, [=]( int begin, int end, double *partial ) {
+      for ( int i = begin; i < end; ++i ) {
+        for ( int j = 0; j < s; ++j ) {
+          const double Rij = R[i+long(j)*n];
+          for ( int k = j; k < s; ++k ) {
+            partial[j+k*s] += Rij * AR[i+long(k)*n];
+          }
+          for ( int k = 0; k < mp; ++k ) {
+            partial[ns+k+j*s] += AP[i+long(k)*n] * Rij;
+          }
+          partial[2*ns+j] += Rij * r[i];
+        }
+        partial[nsum-1] += r[i] * r[i];
+      }
+    }, sum);
+    for ( int j = 0; j < s; ++j ) {
+      for ( int k = j+1; k < s; ++k ) {
+        G[k+j*s] = G[j+k*s];
+      }
+    }
+
+    double res = sqrt(sum[nsum-1]) / nrmb;
+    if ( !record(rec, iter, res) || iter >= maxit ) {
+      break;
+    }
+
+    // The recursive residual drifts from b - A * x; once it meets tol, restart from the true residual unless that
+    // meets tol too, or no longer decreases
+    if ( res <= tol ) {
+      if ( replaced ) {
+        break;
+      }
+      const double res_old = res_true;
+      res_true = residual();
+      if ( res_true <= tol || !(res_true < res_old) ) {
+        break;
+      }
+      replaced = true;
+      mp = 0;
+      continue;
+    }
+    replaced = false;
+
+    // A-orthogonalize against the previous directions; B := inv(W) * C, P := R - P * B, W := G - C' * B
+    for ( int k = 0; k < s; ++k ) {
+      for ( int j = 0; j < mp; ++j ) {
+        B[j+k*s] = C[j+k*s];
+      }
+      solveSmall(s, mp, W, B+k*s);
+    }
+    for ( int j = 0; j < s; ++j ) {
+      for ( int k = 0; k < s; ++k ) {
+        double cb = 0.0;
+        for ( int l = 0; l < mp; ++l ) {
+          cb += C[l+j*s] * B[l+k*s];
+        }
+        W[j+k*s] = G[j+k*s] - cb;
+      }
+    }
+    parallelFor(0, n, kGrain, [=]( int begin, int end ) {
+      for ( int i = begin; i < end; ++i ) {
+        for ( int k = 0; k < s; ++k ) {
+          double pb = 0.0, apb = 0.0;
+          for ( int l = 0; l < mp; ++l ) {
+            pb  += P[i+long(l)*n]  * B[l+k*s];
+            apb += AP[i+long(l)*n] * B[l+k*s];
+          }
+          R[i+long(k)*n]  -= pb;
+          AR[i+long(k)*n] -= apb;
+        }
+      }
+    });
+
+    // The directions that remain linearly independent
+    const int m = factorizeSmall(s, W);
+    if ( m == 0 ) {
+      break;
+    }
+
+    // x += P * a;  r -= A * P * a;  a := inv(W) * (P' * r) = inv(W) * (R' * r)
+    solveSmall(s, m, W, g);
+    parallelFor(0, n, kGrain, [=]( int begin, int end ) {
+      for ( int i = begin; i < end; ++i ) {
+        for ( int k = 0; k < m; ++k ) {
+          x[i] += g[k] * R[i+long(k)*n];
+          r[i] -= g[k] * AR[i+long(k)*n];
+        }
+      }
+    });
+    swap(P, R);
+    swap(AP, AR);
+    mp = m;
+    iter += m;
+  }
+
+  if ( ptr_res != nullptr ) {
+    *ptr_res = residualSparse(n, A_val, A_row, A_col, b, x, &ws);
+  }
+
+  ws.release(top);
+
+  return iter;
+}
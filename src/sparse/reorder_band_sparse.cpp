@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    reorder_band_sparse.cpp
+/// @brief   The implementation of reverse Cuthill-McKee ordering. (sparse version)
+///
+
+#include <algorithm>
+#include <cstdlib>
+#include <band.hpp>
+using namespace std;
+
+void reorderBandSparse(
+    const int  n,
+    const int *A_row,
+    const int *A_col,
+    int       *perm,
+    int       *ptr_bw
+) {
+  int &bw = *ptr_bw;
+
+  bool *visited = new bool[n];
+  int  *stamp   = new int[n];
+  int  *queue   = new int[n];
+  int  *inv     = new int[n];
+  fill(visited, visited+n, false);
+  fill(stamp, stamp+n, -1);
+
+  auto degree = [=]( const int i ) { return A_row[i+1]-A_row[i]; };
+
+  // Breadth-first search from root within its component; returns the number of levels and the start of the last level
+  int nstamp = 0;
+  auto search = [&]( const int root, int *ptr_last, int *ptr_end ) {
+    int head = 0, end = 0, last = 0, nlevel = 0;
+    stamp[root] = nstamp;
+    queue[end++] = root;
+    while ( head < end ) {
+      last = head;
+      ++nlevel;
+      for ( int level_end = end; head < level_end; ++head ) {
+        const int i = queue[head];
+        for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+          if ( stamp[A_col[j]] != nstamp ) {
+            stamp[A_col[j]] = nstamp;
+            queue[end++] = A_col[j];
+          }
+        }
+      }
+    }
+    ++nstamp;
+    *ptr_last = last;
+    *ptr_end  = end;
+    return nlevel;
+  };
+
+  int count = 0;
+  for ( int s = 0; s < n; ++s ) {
+    if ( visited[s] ) {
+      continue;
+    }
+
+    // Pseudo-peripheral vertex (George & Liu)
+    int root = s, last, end;
+    int nlevel = search(root, &last, &end);
+    for ( int j = 0; j < end; ++j ) {
+      if ( degree(queue[j]) < degree(root) ) {
+        root = queue[j];
+      }
+    }
+    nlevel = search(root, &last, &end);
+    while ( true ) {
+      int x = queue[last];
+      for ( int j = last; j < end; ++j ) {
+        if ( degree(queue[j]) < degree(x) ) {
+          x = queue[j];
+        }
+      }
+      int last_x, end_x;
+      int nlevel_x = search(x, &last_x, &end_x);
+      if ( nlevel_x <= nlevel ) {
+        break;
+      }
+      root = x;
+      nlevel = nlevel_x;
+      last = last_x;
+      end = end_x;
+    }
+
+    // Cuthill-McKee from the root; the neighbours are visited in increasing degree
+    int head = count;
+    visited[root] = true;
+    perm[count++] = root;
+    for ( ; head < count; ++head ) {
+      const int i = perm[head];
+      const int begin = count;
+      for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+        if ( !visited[A_col[j]] ) {
+          visited[A_col[j]] = true;
+          perm[count++] = A_col[j];
+        }
+      }
+      stable_sort(perm+begin, perm+count, [&]( const int a, const int b ) { return degree(a) < degree(b); });
+    }
+  }
+
+  // Reverse
+  reverse(perm, perm+n);
+
+  // Bandwidth
+  for ( int i = 0; i < n; ++i ) {
+    inv[perm[i]] = i;
+  }
+  bw = 0;
+  for ( int i = 0; i < n; ++i ) {
+    for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+      bw = max(bw, abs(inv[i]-inv[A_col[j]]));
+    }
+  }
+
+  delete[] visited;
+  delete[] stamp;
+  delete[] queue;
+  delete[] inv;
+}
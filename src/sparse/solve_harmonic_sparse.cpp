@@ -5,29 +5,466 @@
 /// @author  Nul
 ///
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include <harmonic.hpp>
+#include <band.hpp>
+#include <factor_cache.hpp>
+#include <iterative.hpp>
+#include <workspace.hpp>
+#include <profiler.hpp>
+using namespace std;
+
+// A symmetric rank-one modification w * (e_i - e_j) * (e_i - e_j)'; e_j is dropped if j < 0
+struct RankOne {
+  int    i;
+  int    j;
+  double w;
+};
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// @todo  To be implemented!
-///
-void solveHarmonicSparse(
-  const int     nv,
-  const int     nb,
-  const double *Lii_val,
-  const int    *Lii_row,
-  const int    *Lii_col,
-  const double *Lib_val,
-  const int    *Lib_row,
-  const int    *Lib_col,
-  double       *U
+// Decompose the change of Lii from the factorized values into rank-one modifications.
+//
+static int diffRankOne( const int n, const double *A_val, const int *A_row, const int *A_col, const double *A0_val,
+                        RankOne *mod ) {
+  int nmod = 0;
+  for ( int i = 0; i < n; ++i ) {
+    double d = 0.0, diag = 0.0;
+    for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+      const double delta = A_val[j] - A0_val[j];
+      d += delta;
+      if ( A_col[j] == i ) {
+        diag = A_val[j];
+      } else if ( A_col[j] > i && delta != 0.0 ) {
+        mod[nmod++] = {i, A_col[j], -delta};
+      }
+    }
+    // The diagonal change not explained by the off-diagonal ones (the edges to the boundary); ignore round-off
+    if ( fabs(d) > 64 * DBL_EPSILON * fabs(diag) ) {
+      mod[nmod++] = {i, -1, d};
+    }
+  }
+  return nmod;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copy the lower triangle of A(p, p) into band storage; inv is the inverse of the ordering p.
+//
+template <typename T>
+static void fillBand( const int n, const double *A_val, const int *A_row, const int *A_col, const int *inv,
+                      const long ld, T *B ) {
+  fill(B, B+ld*n, T(0));
+  for ( int i = 0; i < n; ++i ) {
+    for ( int j = A_row[i]; j < A_row[i+1]; ++j ) {
+      const int pi = inv[i], pj = inv[A_col[j]];
+      if ( pi >= pj ) {
+        B[(pi-pj) + pj*ld] = T(A_val[j]);
+      }
+    }
+  }
+}
+
+// The largest relative residual accepted from an updated factor; a cold factorization gives about 1e-14
+static const double kUpdateResidual = 1e-10;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Solve with the band Cholesky factor of Lii. A cached factor is used as is if Lii is unchanged, or updated by rank-one
+// modifications if only a few entries changed (and refactorized if the updated one does not reach kUpdateResidual);
+// otherwise Lii is factorized and the cache (if any) is replaced.
+//
+static void solveCached(
+  const int          nv,
+  const int          nb,
+  const double      *Lii_val,
+  const int         *Lii_row,
+  const int         *Lii_col,
+  const double      *Lib_val,
+  const int         *Lib_row,
+  const int         *Lib_col,
+  double            *U,
+  const FactorCache *cache,
+  Workspace         &ws,
+  SolveInfo         *info
 ) {
-  static_cast<void>(nv);
-  static_cast<void>(nb);
-  static_cast<void>(Lii_val);
-  static_cast<void>(Lii_row);
-  static_cast<void>(Lii_col);
-  static_cast<void>(Lib_val);
-  static_cast<void>(Lib_row);
-  static_cast<void>(Lib_col);
-  static_cast<void>(U);
+  const int ni = nv-nb;
+  const long nnz = Lii_row[ni];
+  const Workspace::Mark top = ws.mark();
+
+  FactorData data;
+  memset(&data, 0, sizeof(FactorData));
+  if ( cache != nullptr ) {
+    loadFactorCache(cache, ni, &data);
+  }
+  bool cached = (data.factor != nullptr && data.val != nullptr && data.nval == nnz &&
+                 data.nfactor == (data.bw+1L)*ni);
+
+  // Symbolic: the ordering and the bandwidth
+  int bw = data.bw;
+  const int *p = data.perm;
+  if ( !cached ) {
+    SCSC_PROFILE_ZONE("band ordering");
+    int *perm = ws.take<int>(ni);
+    reorderBandSparse(ni, Lii_row, Lii_col, perm, &bw);
+    p = perm;
+  }
+  const long ld = bw+1;
+  int *inv = ws.take<int>(ni);
+  for ( int i = 0; i < ni; ++i ) {
+    inv[p[i]] = i;
+  }
+
+  // Numeric: the band Cholesky factor of Lii(p, p); factor is set if computed here
+  double *factor = nullptr;
+  const Workspace::Mark numeric = ws.mark();
+  const double *L = nullptr;
+  int nmod = 0;
+  if ( cached ) {
+    RankOne *mod = ws.take<RankOne>(nnz);
+    nmod = diffRankOne(ni, Lii_val, Lii_row, Lii_col, data.val, mod);
+    if ( nmod == 0 ) {
+      L = data.factor;
+    } else if ( nmod <= bw/4 ) {
+      // Each modification costs O(n * bw); the factorization costs O(n * bw^2)
+      SCSC_PROFILE_ZONE("rank-one update");
+      factor = ws.take<double>(ld*ni);
+      copy(data.factor, data.factor+ld*ni, factor);
+      stable_partition(mod, mod+nmod, []( const RankOne &m ) { return m.w > 0.0; });
+      double *X = ws.take<double>(long(ni)*nmod), *sigma = ws.take<double>(nmod);
+      fill(X, X+long(ni)*nmod, 0.0);
+      int s0 = ni;
+      for ( int k = 0; k < nmod; ++k ) {
+        const double sw = sqrt(fabs(mod[k].w));
+        const int pi = inv[mod[k].i];
+        X[pi+long(k)*ni] = sw;
+        s0 = min(s0, pi);
+        if ( mod[k].j >= 0 ) {
+          const int pj = inv[mod[k].j];
+          X[pj+long(k)*ni] = -sw;
+          s0 = min(s0, pj);
+        }
+        sigma[k] = (mod[k].w > 0.0) ? 1.0 : -1.0;
+      }
+      int err = updateBand(ni, bw, factor, ld, nmod, X, ni, s0, sigma);
+      if ( err == 0 ) {
+        L = factor;
+      } else {
+        factor = nullptr;
+      }
+    }
+  }
+
+  // Factorize Lii(p, p) into factor, replacing the numeric scratch
+  auto refactorize = [&]() {
+    SCSC_PROFILE_ZONE("band factorization");
+    nmod = 0;
+    ws.release(numeric);
+    factor = ws.take<double>(ld*ni);
+    fillBand(ni, Lii_val, Lii_row, Lii_col, inv, ld, factor);
+    int err = factorizeBand(ni, bw, factor, ld);
+    if ( err != 0 ) {
+      releaseFactorCache(&data);
+      ws.release(top);
+      throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization failed: the leading minor of order " +
+                          to_string(err) + " is not positive definite.");
+    }
+    L = factor;
+  };
+  if ( L == nullptr ) {
+    refactorize();
+  }
+
+  // Solve Lii * Ui = - Lib * Ub
+  SolveInfo stat;
+  auto solveFactor = [&]() {
+    stat = {0, 1.0, 0.0, nmod, 0, false, bw, ld*ni - ld*bw/2};
+    double *b = ws.take<double>(ni), *x = ws.take<double>(ni);
+    for ( int k = 0; k < 2; ++k ) {
+      SCSC_PROFILE_ZONE("band solve");
+      const double *Ub = U+k*nv;
+      double       *Ui = U+k*nv+nb;
+      spmvSparse(ni, Lib_val, Lib_row, Lib_col, Ub, b);
+      for ( int i = 0; i < ni; ++i ) {
+        b[i] = -b[i];
+      }
+      for ( int i = 0; i < ni; ++i ) {
+        x[i] = b[p[i]];
+      }
+      solveBand(ni, bw, L, ld, x);
+      for ( int i = 0; i < ni; ++i ) {
+        Ui[p[i]] = x[i];
+      }
+      stat.res = max(stat.res, residualSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui, &ws));
+    }
+  };
+  solveFactor();
+
+  // An updated factor that lost accuracy is replaced by a new factorization
+  if ( nmod > 0 && stat.res > kUpdateResidual ) {
+    refactorize();
+    solveFactor();
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+
+  // Replace the cache (after the solve; p may point into the mapped file)
+  if ( factor != nullptr && cache != nullptr ) {
+    int *p_copy = ws.take<int>(ni);
+    copy(p, p+ni, p_copy);
+    releaseFactorCache(&data);
+    storeFactorCache(cache, ni, bw, p_copy, factor, ld*ni, Lii_val, nnz);
+  }
+
+  releaseFactorCache(&data);
+  ws.release(top);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Solve with the band Cholesky factor of Lii in single precision, refined against Lii in double precision (as LAPACK
+// dsposv). Lii is refactorized in double precision if the refinement stagnates.
+//
+static void solveMixed(
+  const int          nv,
+  const int          nb,
+  const double      *Lii_val,
+  const int         *Lii_row,
+  const int         *Lii_col,
+  const double      *Lib_val,
+  const int         *Lib_row,
+  const int         *Lib_col,
+  double            *U,
+  SolveInfo         *info
+) {
+  const int ni = nv-nb;
+  const int maxrefine = 30;
+
+  // The ordering and the bandwidth
+  int bw, *perm = new int[ni], *inv = new int[ni];
+  reorderBandSparse(ni, Lii_row, Lii_col, perm, &bw);
+  for ( int i = 0; i < ni; ++i ) {
+    inv[perm[i]] = i;
+  }
+  const long ld = bw+1;
+
+  // ||Lii||_inf * sqrt(n) * eps bounds the attainable residual relative to ||x||_inf
+  double nrma = 0.0;
+  for ( int i = 0; i < ni; ++i ) {
+    double sum = 0.0;
+    for ( int j = Lii_row[i]; j < Lii_row[i+1]; ++j ) {
+      sum += fabs(Lii_val[j]);
+    }
+    nrma = max(nrma, sum);
+  }
+  const double cte = nrma * sqrt(double(ni)) * DBL_EPSILON;
+
+  // The single precision factor
+  float *factor = new float[ld*ni];
+  bool fallback;
+  {
+    SCSC_PROFILE_ZONE("single factorization");
+    fillBand(ni, Lii_val, Lii_row, Lii_col, inv, ld, factor);
+    fallback = (factorizeBand(ni, bw, factor, ld) != 0);
+  }
+
+  // Solve Lii * Ui = - Lib * Ub; each step solves Lii * d = b - Lii * Ui with the single precision factor
+  SolveInfo stat = {0, 1.0, 0.0, 0, 0, false, bw, ld*ni - ld*bw/2};
+  double *b = new double[ni], *r = new double[ni];
+  float  *d = new float[ni];
+  for ( int k = 0; k < 2 && !fallback; ++k ) {
+    SCSC_PROFILE_ZONE("refinement");
+    const double *Ub = U+k*nv;
+    double       *Ui = U+k*nv+nb;
+    spmvSparse(ni, Lib_val, Lib_row, Lib_col, Ub, b);
+    for ( int i = 0; i < ni; ++i ) {
+      b[i] = -b[i];
+    }
+    fill(Ui, Ui+ni, 0.0);
+    copy(b, b+ni, r);
+
+    double nrmr_prev = HUGE_VAL;
+    for ( int step = 0; ; ++step ) {
+      for ( int i = 0; i < ni; ++i ) {
+        d[i] = float(r[perm[i]]);
+      }
+      solveBand(ni, bw, factor, ld, d);
+      for ( int i = 0; i < ni; ++i ) {
+        Ui[perm[i]] += d[i];
+      }
+
+      // r := b - Lii * Ui
+      spmvSparse(ni, Lii_val, Lii_row, Lii_col, Ui, r);
+      double nrmr = 0.0, nrmx = 0.0;
+      for ( int i = 0; i < ni; ++i ) {
+        r[i] = b[i] - r[i];
+        nrmr = max(nrmr, fabs(r[i]));
+        nrmx = max(nrmx, fabs(Ui[i]));
+      }
+      if ( nrmr <= nrmx * cte ) {
+        stat.nrefine += step;
+        break;
+      }
+      if ( step == maxrefine || nrmr > 0.5 * nrmr_prev ) {
+        fallback = true;
+        break;
+      }
+      nrmr_prev = nrmr;
+    }
+    stat.res = max(stat.res, residualSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui));
+  }
+  delete[] factor;
+
+  // The double precision factor
+  if ( fallback ) {
+    SCSC_PROFILE_ZONE("band factorization");
+    double *factor64 = new double[ld*ni];
+    fillBand(ni, Lii_val, Lii_row, Lii_col, inv, ld, factor64);
+    int err = factorizeBand(ni, bw, factor64, ld);
+    if ( err != 0 ) {
+      delete[] factor64;
+      delete[] perm;
+      delete[] inv;
+      delete[] b;
+      delete[] r;
+      delete[] d;
+      throw HarmonicError(ErrorCode::NUMERIC, "Cholesky factorization failed: the leading minor of order " +
+                          to_string(err) + " is not positive definite.");
+    }
+    stat.res = 0.0;
+    stat.fallback = true;
+    for ( int k = 0; k < 2; ++k ) {
+      const double *Ub = U+k*nv;
+      double       *Ui = U+k*nv+nb;
+      spmvSparse(ni, Lib_val, Lib_row, Lib_col, Ub, b);
+      for ( int i = 0; i < ni; ++i ) {
+        b[i] = -b[i];
+      }
+      for ( int i = 0; i < ni; ++i ) {
+        r[i] = b[perm[i]];
+      }
+      solveBand(ni, bw, factor64, ld, r);
+      for ( int i = 0; i < ni; ++i ) {
+        Ui[perm[i]] = r[i];
+      }
+      stat.res = max(stat.res, residualSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui));
+    }
+    delete[] factor64;
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+
+  delete[] perm;
+  delete[] inv;
+  delete[] b;
+  delete[] r;
+  delete[] d;
+}
+
+void solveHarmonicSparseCholesky(
+  const int           nv,
+  const int           nb,
+  const double       *Lii_val,
+  const int          *Lii_row,
+  const int          *Lii_col,
+  const double       *Lib_val,
+  const int          *Lib_row,
+  const int          *Lib_col,
+  double             *U,
+  const double       *U0,
+  const SolveOptions &options,
+  SolveInfo          *info
+) {
+  static_cast<void>(U0);
+  if ( options.precision == Precision::MIXED ) {
+    solveMixed(nv, nb, Lii_val, Lii_row, Lii_col, Lib_val, Lib_row, Lib_col, U, info);
+  } else {
+    Workspace local;
+    Workspace &ws = (options.work != nullptr) ? *options.work : local;
+    solveCached(nv, nb, Lii_val, Lii_row, Lii_col, Lib_val, Lib_row, Lib_col, U, options.cache, ws, info);
+  }
+}
+
+void solveHarmonicSparseCg(
+  const int           nv,
+  const int           nb,
+  const double       *Lii_val,
+  const int          *Lii_row,
+  const int          *Lii_col,
+  const double       *Lib_val,
+  const int          *Lib_row,
+  const int          *Lib_col,
+  double             *U,
+  const double       *U0,
+  const SolveOptions &options,
+  SolveInfo          *info
+) {
+  const int ni = nv-nb;
+  const double tol = options.tol;
+  const Monitor &monitor = options.monitor;
+
+  Workspace local;
+  Workspace &ws = (options.work != nullptr) ? *options.work : local;
+  const Workspace::Mark top = ws.mark();
+
+  // Jacobi preconditioner, or the identity
+  double *dinv = ws.take<double>(ni);
+  for ( int i = 0; i < ni; ++i ) {
+    dinv[i] = 1.0;
+    for ( int j = Lii_row[i]; j < Lii_row[i+1] && options.precond == Precond::JACOBI; ++j ) {
+      if ( Lii_col[j] == i ) {
+        dinv[i] = 1.0 / Lii_val[j];
+      }
+    }
+  }
+  auto precond = [=]( const double *r, double *z ) {
+    for ( int i = 0; i < ni; ++i ) {
+      z[i] = dinv[i] * r[i];
+    }
+  };
+
+  // Solve Lii * Ui = - Lib * Ub
+  SolveInfo stat = {0, 0.0, 0.0, 0, 0, false, 0, 0};
+  double *b = ws.take<double>(ni);
+  for ( int k = 0; k < 2; ++k ) {
+    const double *Ub = U+k*nv;
+    double       *Ui = U+k*nv+nb;
+    spmvSparse(ni, Lib_val, Lib_row, Lib_col, Ub, b);
+    for ( int i = 0; i < ni; ++i ) {
+      b[i] = -b[i];
+      Ui[i] = (U0 != nullptr) ? U0[k*nv+nb+i] : 0.0;
+    }
+    double res0 = residualSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui, &ws), res;
+    Monitor coord = nullptr;
+    if ( monitor ) {
+      coord = [&, k]( const IterationInfo &it ) {
+        IterationInfo info_k = it;
+        info_k.rhs = k;
+        return monitor(info_k);
+      };
+    }
+    int iter;
+    switch ( options.krylov ) {
+      case Krylov::PIPELINED: {
+        iter = solvePipelinedPcgSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui, precond, tol, 10*ni+100, coord, &res, &ws);
+        break;
+      }
+      case Krylov::SSTEP: {
+        iter = solveSstepPcgSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui, precond, 4, tol, 10*ni+100, coord, &res, &ws);
+        break;
+      }
+      default: {
+        iter = solvePcgSparse(ni, Lii_val, Lii_row, Lii_col, b, Ui, precond, tol, 10*ni+100, coord, &res, &ws);
+      }
+    }
+    stat.iter += iter;
+    stat.res0 = max(stat.res0, res0);
+    stat.res = max(stat.res, res);
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+
+  ws.release(top);
 }
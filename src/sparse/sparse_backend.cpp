@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    sparse_backend.cpp
+/// @brief   The table of sparse solver backends.
+///
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <harmonic.hpp>
+#include <iterative.hpp>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Expand [Lib, Lii] to a dense matrix and solve with a dense backend. The residual is computed from the sparse Lii.
+//
+template <DenseSolver solve>
+static void solveDensified(
+  const int           nv,
+  const int           nb,
+  const double       *Lii_val,
+  const int          *Lii_row,
+  const int          *Lii_col,
+  const double       *Lib_val,
+  const int          *Lib_row,
+  const int          *Lib_col,
+  double             *U,
+  const double       *U0,
+  const SolveOptions &options,
+  SolveInfo          *info
+) {
+  static_cast<void>(U0);
+  static_cast<void>(options);
+  const int ni = nv-nb;
+  if ( long(ni) * long(nv) > INT_MAX ) {
+    throw HarmonicError(ErrorCode::UNAVAILABLE, "The size of the Laplacian matrix (" + to_string(ni) + " x " +
+                        to_string(nv) + " = " + to_string(long(ni) * long(nv)) + ") exceeds the maximum value of integer (" +
+                        to_string(INT_MAX) + "); use a sparse solver.");
+  }
+
+  // L = [ Lib, Lii ]; (nv-nb) by nv matrix
+  double *L = new double[long(ni) * nv];
+  fill(L, L+long(ni)*nv, 0.0);
+  for ( int i = 0; i < ni; ++i ) {
+    for ( int j = Lib_row[i]; j < Lib_row[i+1]; ++j ) {
+      L[i + long(Lib_col[j])*ni] += Lib_val[j];
+    }
+    for ( int j = Lii_row[i]; j < Lii_row[i+1]; ++j ) {
+      L[i + long(nb+Lii_col[j])*ni] += Lii_val[j];
+    }
+  }
+  solve(nv, nb, L, U);
+  delete[] L;
+
+  SolveInfo stat = {0, 1.0, 0.0, 0, 0, false, ni-1, long(ni)*(ni+1)/2};
+  double *b = new double[ni];
+  for ( int k = 0; k < 2; ++k ) {
+    spmvSparse(ni, Lib_val, Lib_row, Lib_col, U+k*nv, b);
+    for ( int i = 0; i < ni; ++i ) {
+      b[i] = -b[i];
+    }
+    stat.res = max(stat.res, residualSparse(ni, Lii_val, Lii_row, Lii_col, b, U+k*nv+nb));
+  }
+  if ( info != nullptr ) {
+    *info = stat;
+  }
+  delete[] b;
+}
+
+// The backends compiled in; the first one is the default of iterative solving
+static const SparseBackend kBackend[] = {
+  {"cg",             "native conjugate gradient (see --krylov, --precond, --tol)",  solveHarmonicSparseCg,              false},
+  {"cholesky",       "native band Cholesky (see --cache, --precision)",              solveHarmonicSparseCholesky,        true},
+#ifdef SCSC_USE_MKL
+  {"pardiso",        "MKL PARDISO (see --cache, --precision)",                       solveHarmonicSparseMkl,             true},
+#endif  // SCSC_USE_MKL
+#ifdef SCSC_USE_GPU
+  {"magma",          "MAGMA conjugate gradient on GPU (see --precond, --tol)",       solveHarmonicSparseMagma,           false},
+#endif  // SCSC_USE_GPU
+  {"dense-cholesky", "native tiled Cholesky of the dense Laplacian",                 solveDensified<solveHarmonic>,      false},
+#ifdef SCSC_USE_MKL
+  {"dense-lapack",   "MKL LAPACK Cholesky of the dense Laplacian",                   solveDensified<solveHarmonicMkl>,   false},
+#endif  // SCSC_USE_MKL
+#ifdef SCSC_USE_GPU
+  {"dense-magma",    "MAGMA LU of the dense Laplacian on GPU",                       solveDensified<solveHarmonicMagma>, false},
+#endif  // SCSC_USE_GPU
+};
+
+int listSparseBackends(
+    const SparseBackend **ptr_backend
+) {
+  *ptr_backend = kBackend;
+  return sizeof(kBackend) / sizeof(kBackend[0]);
+}
+
+const SparseBackend *findSparseBackend(
+    const char *name
+) {
+  for ( const SparseBackend &backend : kBackend ) {
+    if ( strcmp(backend.name, name) == 0 ) {
+      return &backend;
+    }
+  }
+  return nullptr;
+}
+
+const char *sparseBackendName(
+    const SolveOptions &options
+) {
+  if ( options.solver != nullptr ) {
+    return options.solver;
+  }
+  return (options.cache != nullptr || options.precision == Precision::MIXED) ? "cholesky" : "cg";
+}
+
+void solveHarmonicSparse(
+  const int           nv,
+  const int           nb,
+  const double       *Lii_val,
+  const int          *Lii_row,
+  const int          *Lii_col,
+  const double       *Lib_val,
+  const int          *Lib_row,
+  const int          *Lib_col,
+  double             *U,
+  const double       *U0,
+  const SolveOptions &options,
+  SolveInfo          *info
+) {
+  const char *name = sparseBackendName(options);
+  const SparseBackend *backend = findSparseBackend(name);
+  if ( backend == nullptr ) {
+    throw HarmonicError(ErrorCode::UNAVAILABLE, string("The solver backend ") + name + " is not available.");
+  }
+  if ( options.precision == Precision::MIXED && !backend->mixed ) {
+    throw HarmonicError(ErrorCode::UNAVAILABLE, string("The solver backend ") + name + " has no mixed precision path.");
+  }
+  backend->solve(nv, nb, Lii_val, Lii_row, Lii_col, Lib_val, Lib_row, Lib_col, U, U0, options, info);
+}
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    stream_object_sparse.cpp
+/// @brief   The implementation of streaming object reading. (sparse version)
+///
+
+#include <harmonic.hpp>
+#include <atomic>
+#include <thread>
+#include <bounded_queue.hpp>
+#include <profiler.hpp>
+#include <thread_pool.hpp>
+using namespace std;
+
+static const int kBatch = 4096;  // the number of faces of a batch
+static const int kQueue = 64;    // the number of batches in flight
+
+// A batch of faces; the faces [begin, end) and the first nv_read vertices are read
+struct FaceRange {
+  int begin;
+  int end;
+  int nv_read;
+};
+
+// The state shared by the parser and the consumers
+struct Stream {
+  BoundedQueue<FaceRange, kQueue> queue;
+  atomic<bool> claimed;  // whether a task has become the parser
+  atomic<bool> parsed;   // whether all batches are pushed
+  atomic<bool> late;     // whether a face refers to a vertex read after it
+  int nv, nf;
+  const double *V;
+  const int *F;
+  uint64_t *E;
+  double *W;
+};
+
+// Process a batch
+static void consume( Stream &s, const FaceRange &range ) {
+  SCSC_PROFILE_ZONE("edge batch");
+  edgeKeySparse(s.nf, s.F, range.begin, range.end, s.E);
+  if ( s.W == nullptr ) {
+    return;
+  }
+
+  // The weights need the coordinates of all vertices of the faces
+  for ( int k = 0; k < 3; ++k ) {
+    for ( int i = range.begin; i < range.end; ++i ) {
+      if ( s.F[k*s.nf+i] > range.nv_read ) {
+        s.late.store(true, memory_order_relaxed);
+        return;
+      }
+    }
+  }
+  cotangentWeightSparse(s.nv, s.nf, s.V, s.F, range.begin, range.end, s.W);
+}
+
+// Hand a batch over to the consumers; the parser processes it if the queue is full
+static void emit( void *context, int begin, int end, int nv_read ) {
+  Stream &s = *static_cast<Stream*>(context);
+  const FaceRange range = {begin, end, nv_read};
+  if ( !s.queue.tryPush(range) ) {
+    consume(s, range);
+  }
+}
+
+void streamObjectSparse(
+    const char *input,
+    const int nv,
+    const int nf,
+    double *V,
+    double *C,
+    int *F,
+    uint64_t *E,
+    double *W
+) {
+  Stream s;
+  s.claimed.store(false);
+  s.parsed.store(false);
+  s.late.store(false);
+  s.nv = nv;
+  s.nf = nf;
+  s.V  = V;
+  s.F  = F;
+  s.E  = E;
+  s.W  = W;
+
+  // One task per thread; the first one to start parses, and all of them consume until the parsing is done
+  parallelFor(0, threadPoolSize(), 1, [&]( int begin, int end ) {
+    for ( int t = begin; t < end; ++t ) {
+      if ( !s.claimed.exchange(true) ) {
+        // On an error, the consumers are let go before the loop passes it on
+        try {
+          readObject(input, nv, nf, V, C, F, kBatch, emit, &s);
+        } catch ( ... ) {
+          s.parsed.store(true, memory_order_release);
+          throw;
+        }
+        s.parsed.store(true, memory_order_release);
+      }
+      FaceRange range;
+      for ( ;; ) {
+        const bool parsed = s.parsed.load(memory_order_acquire);
+        if ( s.queue.tryPop(range) ) {
+          consume(s, range);
+        } else if ( parsed ) {
+          break;
+        } else {
+          this_thread::yield();
+        }
+      }
+    }
+  });
+
+  // Compute the weights of the faces read before their vertices
+  if ( W != nullptr && s.late.load() ) {
+    parallelFor(0, nf, 4096, [=]( int begin, int end ) {
+      cotangentWeightSparse(nv, nf, V, F, begin, end, W);
+    });
+  }
+}
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @file    update_laplacian_sparse.cpp
+/// @brief   The implementation of Laplacian updating. (sparse version)
+///
+
+#include <algorithm>
+#include <cmath>
+#include <harmonic.hpp>
+using namespace std;
+
+// The cotangent weight of the edge row-col opposite to mid; as in constructLaplacianSparse
+static double cotWeight( const int nv, const double *V, const int row, const int col, const int mid ) {
+  double v[3] = {V[row]-V[mid], V[nv+row]-V[nv+mid], V[2*nv+row]-V[2*nv+mid]};
+  double b[3] = {V[col]-V[mid], V[nv+col]-V[nv+mid], V[2*nv+col]-V[2*nv+mid]};
+  double z[3] = {v[1]*b[2]-v[2]*b[1], v[2]*b[0]-v[0]*b[2], v[0]*b[1]-v[1]*b[0]};
+  return -0.5*(v[0]*b[0]+v[1]*b[1]+v[2]*b[2]) / sqrt(z[0]*z[0]+z[1]*z[1]+z[2]*z[2]);
+}
+
+// The position of the entry (i, j) in CSR format
+static int findEntry( const int *A_row, const int *A_col, const int i, const int j ) {
+  const int *begin = A_col+A_row[i], *end = A_col+A_row[i+1];
+  return lower_bound(begin, end, j) - A_col;
+}
+
+void updateLaplacianSparse(
+  const Method  method,
+  const int     nv,
+  const int     nb,
+  const int     nf,
+  const double *V0,
+  const double *V,
+  const int    *F,
+  const int     nm,
+  const int    *moved,
+  double       *Lii_val,
+  const int    *Lii_row,
+  const int    *Lii_col,
+  double       *Lib_val,
+  const int    *Lib_row,
+  const int    *Lib_col
+) {
+  // The Kirchhoff Laplacian does not depend on the coordinates
+  if ( method != Method::COTANGENT || nm == 0 ) {
+    return;
+  }
+
+  bool *is_moved = new bool[nv];
+  fill(is_moved, is_moved+nv, false);
+  for ( int i = 0; i < nm; ++i ) {
+    is_moved[moved[i]] = true;
+  }
+
+  // Replace the weights of the faces incident to the moved vertices
+  for ( int i = 0; i < nf; ++i ) {
+    if ( !is_moved[F[i]-1] && !is_moved[F[nf+i]-1] && !is_moved[F[2*nf+i]-1] ) {
+      continue;
+    }
+    for ( int k = 0; k < 3; ++k ) {
+      int row = F[k*nf+i]-1;
+      int col = F[(k+1)%3*nf+i]-1;
+      int mid = F[(k+2)%3*nf+i]-1;
+      const double dw = cotWeight(nv, V, row, col, mid) - cotWeight(nv, V0, row, col, mid);
+      if ( row < nb && col < nb ) {
+        continue;
+      }
+      if ( row < nb ) {
+        swap(row, col);
+      }
+      if ( col >= nb ) {
+        // Lii
+        Lii_val[findEntry(Lii_row, Lii_col, row-nb, col-nb)] += dw;
+        Lii_val[findEntry(Lii_row, Lii_col, col-nb, row-nb)] += dw;
+        Lii_val[findEntry(Lii_row, Lii_col, row-nb, row-nb)] -= dw;
+        Lii_val[findEntry(Lii_row, Lii_col, col-nb, col-nb)] -= dw;
+      } else {
+        // Lib
+        Lib_val[findEntry(Lib_row, Lib_col, row-nb, col)] += dw;
+        Lii_val[findEntry(Lii_row, Lii_col, row-nb, row-nb)] -= dw;
+      }
+    }
+  }
+
+  delete[] is_moved;
+}
@@ -7,56 +7,113 @@
 ///
 
 #include <harmonic.hpp>
-#include <map>
-#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <thread_pool.hpp>
+#include <workspace.hpp>
 using namespace std;
 
-using Pair = pair<int, int>;
+// The key of the directed edge from a to b
+static inline uint64_t edgeKey( const int a, const int b ) { return (uint64_t(uint32_t(a)) << 32) | uint32_t(b); }
+
+void edgeKeySparse(
+    const int nf,
+    const int *F,
+    const int begin,
+    const int end,
+    uint64_t *E
+) {
+  for ( int i = begin; i < end; ++i ) {
+    E[i]      = edgeKey(F[i],      F[nf+i]);
+    E[nf+i]   = edgeKey(F[nf+i],   F[2*nf+i]);
+    E[2*nf+i] = edgeKey(F[2*nf+i], F[i]);
+  }
+}
 
 void verifyBoundarySparse(
     const int nv,
     const int nf,
     const int *F,
     int *ptr_nb,
-    int *idx_b
+    int *idx_b,
+    Workspace *work
 ) {
   static_cast<void>(nv);
 
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
+
+  // Generate the directed edges of the faces
+  uint64_t *E = ws.take<uint64_t>(3*nf);
+  parallelFor(0, nf, 4096, [=]( int begin, int end ) {
+    edgeKeySparse(nf, F, begin, end, E);
+  });
+  verifyBoundarySparse(nf, E, ptr_nb, idx_b, &ws);
+
+  ws.release(top);
+}
+
+void verifyBoundarySparse(
+    const int nf,
+    uint64_t *E,
+    int *ptr_nb,
+    int *idx_b,
+    Workspace *work
+) {
   int &nb = *ptr_nb;
-  int p[3];
-
-  // Generate graph
-  map<Pair, int> Gb;
-  for ( int i = 0; i < nf; ++i ) {
-    p[0] = F[i];
-    p[1] = F[nf+i];
-    p[2] = F[2*nf+i];
-
-    Gb[Pair(p[1], p[0])]++;
-    Gb[Pair(p[2], p[1])]++;
-    Gb[Pair(p[0], p[2])]++;
-
-    Gb[Pair(p[0], p[1])]--;
-    Gb[Pair(p[1], p[2])]--;
-    Gb[Pair(p[2], p[0])]--;
-  }
+  const int ne = 3*nf;
+
+  Workspace local;
+  Workspace &ws = (work != nullptr) ? *work : local;
+  const Workspace::Mark top = ws.mark();
 
-  // Find edges
-  map<int, int> Eb;
-  for ( auto it = Gb.begin(); it != Gb.end(); ++it ) {
-    if ( it->second == -1 ) {
-      Eb[it->first.first] = it->first.second;
+  // Sort the directed edges
+  parallelSort(E, E+ne, less<uint64_t>());
+
+  // Find edges; a to b is a boundary edge if it occurs once more than b to a
+  char *is_b = ws.take<char>(ne);
+  parallelFor(0, ne, 4096, [=]( int begin, int end ) {
+    for ( int i = begin; i < end; ++i ) {
+      is_b[i] = 0;
+      if ( i > 0 && E[i] == E[i-1] ) {
+        continue;
+      }
+      const int count = upper_bound(E+i, E+ne, E[i]) - (E+i);
+      const auto rev = equal_range(E, E+ne, (E[i] << 32) | (E[i] >> 32));
+      is_b[i] = (count - (rev.second - rev.first) == 1);
+    }
+  });
+
+  // The boundary edges by their first vertex; the last one is kept if a vertex has several
+  int *Eb_first = ws.take<int>(ne), *Eb_second = ws.take<int>(ne);
+  int ne_b = 0;
+  for ( int i = 0; i < ne; ++i ) {
+    if ( is_b[i] ) {
+      const int a = int(E[i] >> 32), b = int(uint32_t(E[i]));
+      if ( ne_b == 0 || Eb_first[ne_b-1] != a ) {
+        Eb_first[ne_b++] = a;
+      }
+      Eb_second[ne_b-1] = b;
     }
   }
 
   // Count boundary size
-  nb = Eb.size();
+  nb = ne_b;
 
-  // List boundary
-  int idx = Eb.begin()->first;
-  for ( int i = 0; i < nb; ++i ) {
+  // List boundary; it must be one loop through all boundary edges
+  int idx = (ne_b > 0) ? Eb_first[0] : 0;
+  bool loop = (nb > 0);
+  for ( int i = 0; i < nb && loop; ++i ) {
     idx_b[i] = idx;
-    idx = Eb[idx];
+    const int *it = lower_bound(Eb_first, Eb_first+ne_b, idx);
+    idx = (it != Eb_first+ne_b && *it == idx) ? Eb_second[it - Eb_first] : 0;
+    loop = (idx != 0) && ((idx == idx_b[0]) == (i+1 == nb));
+  }
+
+  ws.release(top);
+  if ( !loop ) {
+    throw HarmonicError(ErrorCode::FORMAT, (nb == 0) ? "The mesh has no boundary; a disk topology is needed."
+                                                     : "The boundary is not one loop; a disk topology is needed.");
   }
-  return;
 }
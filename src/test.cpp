@@ -12,19 +12,16 @@
 using namespace std;
 
 int main( int argc, char** argv ) {
-
-  const char *input  = "input.obj";
-  const char *output = "output.obj";
-  Method method = Method::KIRCHHOFF;
+  Arguments args;
 
   int nv, nf, *F = nullptr;
   double *V = nullptr, *C = nullptr, *L;
 
   // Read arguments
-  readArgs(argc, argv, input, output, method);
+  readArgs(argc, argv, "ft", args);
 
   // Read object
-  readObject(input, &nv, &nf, &V, &C, &F);
+  readObject(args.input, &nv, &nf, &V, &C, &F);
   if ( nv > sqrt(INT_MAX) ) {
   cerr << "The size of the Laplacian matrix (" << nv << " x " << nv << " = " << long(nv) * long(nv)
        << ") exceed the maximum value of integer (" << INT_MAX << ")" << endl;
@@ -33,7 +30,7 @@ int main( int argc, char** argv ) {
 
   // Construct Laplacian
   L = new double[nv * nv];
-  constructLaplacian(method, nv, nf, V, F, L);
+  constructLaplacian(args.method, nv, 0, nf, V, F, L);
 
   // Print out result
   for (int i = 0; i < nv; ++i) {